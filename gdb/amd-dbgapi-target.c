@@ -185,6 +185,7 @@ struct amd_dbgapi_target final : public target_ops
   void stop (ptid_t ptid) override;
 
   void fetch_registers (struct regcache *, int) override;
+  void prefetch_registers (gdb::array_view<thread_info *> threads) override;
   void store_registers (struct regcache *, int) override;
 
   void update_thread_list () override;
@@ -207,6 +208,9 @@ struct amd_dbgapi_target final : public target_ops
 					ULONGEST offset, ULONGEST len,
 					ULONGEST *xfered_len) override;
 
+  bool read_raw_memory_ranges
+    (gdb::array_view<memory_read_request> requests) override;
+
   bool stopped_by_watchpoint () override;
 
   bool stopped_by_sw_breakpoint () override;
@@ -548,6 +552,17 @@ amd_dbgapi_target::xfer_partial (enum target_object object, const char *annex,
   return TARGET_XFER_OK;
 }
 
+bool
+amd_dbgapi_target::read_raw_memory_ranges
+  (gdb::array_view<memory_read_request> requests)
+{
+  /* Let xfer_partial read the memory of GPU threads.  */
+  if (ptid_is_gpu (inferior_ptid))
+    return false;
+
+  return beneath ()->read_raw_memory_ranges (requests);
+}
+
 bool
 amd_dbgapi_target::stopped_by_watchpoint ()
 {
@@ -1469,6 +1484,18 @@ amd_dbgapi_target::detach (inferior *inf, int from_tty)
   beneath ()->detach (inf, from_tty);
 }
 
+void
+amd_dbgapi_target::prefetch_registers (gdb::array_view<thread_info *> threads)
+{
+  /* The registers of GPU threads are fetched by fetch_registers.  */
+  std::vector<thread_info *> cpu_threads;
+  for (thread_info *tp : threads)
+    if (!ptid_is_gpu (tp->ptid))
+      cpu_threads.push_back (tp);
+
+  beneath ()->prefetch_registers (cpu_threads);
+}
+
 void
 amd_dbgapi_target::fetch_registers (struct regcache *regcache, int regno)
 {
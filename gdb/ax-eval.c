@@ -0,0 +1,639 @@
+/* Evaluating agent expressions inside GDB.
+
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Agent expressions are normally shipped to a remote stub, which
+   evaluates them without any symbolic information.  The same property
+   makes them a cheap way for GDB itself to evaluate an expression
+   over and over again: all symbol lookups, location expressions and
+   type conversions were done once when the bytecode was generated,
+   and what is left only needs registers and memory.  */
+
+#include "defs.h"
+#include "ax.h"
+#include "ax-gdb.h"
+#include "gdbarch.h"
+#include "regcache.h"
+#include "target.h"
+#include "registry.h"
+#include "gdbsupport/format.h"
+
+/* The deepest stack the evaluator supports.  Expressions needing more
+   are refused up front by ax_host_eval_p.  */
+
+#define AX_HOST_STACK_MAX 64
+
+/* The longest string a printf bytecode's %s directive may print.
+   Longer strings, most likely an unterminated buffer or a wrong
+   pointer, make evaluation fail and are left to GDB.  */
+
+#define AX_HOST_STRING_MAX 4096
+
+/* Map from the register numbers used in bytecode (the remote register
+   numbers, see ax_reg) back to GDB's register numbers, for one
+   architecture.  Unmapped entries are -1.  */
+
+struct ax_host_regmap
+{
+  explicit ax_host_regmap (struct gdbarch *gdbarch)
+  {
+    int num_regs = gdbarch_num_regs (gdbarch);
+
+    for (int regnum = 0; regnum < num_regs; regnum++)
+      {
+	int remote = gdbarch_remote_register_number (gdbarch, regnum);
+
+	if (remote < 0 || remote > 0xffff)
+	  continue;
+	if (remote >= map.size ())
+	  map.resize (remote + 1, -1);
+	map[remote] = regnum;
+      }
+  }
+
+  std::vector<int> map;
+};
+
+static const registry<gdbarch>::key<ax_host_regmap> ax_host_regmap_data;
+
+/* Return the register map for GDBARCH, creating it if needed.  */
+
+static const ax_host_regmap *
+get_ax_host_regmap (struct gdbarch *gdbarch)
+{
+  ax_host_regmap *result = ax_host_regmap_data.get (gdbarch);
+
+  if (result == nullptr)
+    result = ax_host_regmap_data.emplace (gdbarch, gdbarch);
+  return result;
+}
+
+/* Read a big-endian N-byte constant from AX at offset PC.  */
+
+static ULONGEST
+ax_host_read_const (const struct agent_expr *ax, int pc, int n)
+{
+  ULONGEST val = 0;
+
+  for (int i = 0; i < n; i++)
+    val = (val << 8) | ax->buf[pc + i];
+  return val;
+}
+
+/* Return the length of the printf bytecode at PC in AX, opcode
+   included, or -1 if it runs past the end of AX.  */
+
+static int
+ax_host_printf_length (const struct agent_expr *ax, int pc)
+{
+  if (pc + 4 > ax->buf.size ())
+    return -1;
+
+  int slen = ax_host_read_const (ax, pc + 2, 2);
+  if (pc + 4 + slen > ax->buf.size ())
+    return -1;
+
+  return 4 + slen;
+}
+
+/* Check that the printf bytecode at PC in AX has a format string
+   ax_host_printf can handle, with as many directives as arguments.  */
+
+static bool
+ax_host_printf_ok_p (const struct agent_expr *ax, int pc)
+{
+  int nargs = ax->buf[pc + 1];
+  int slen = ax_host_read_const (ax, pc + 2, 2);
+  const char *format = (const char *) &ax->buf[pc + 4];
+
+  if (slen == 0 || format[slen - 1] != '\0')
+    return false;
+
+  try
+    {
+      format_pieces fpieces (&format);
+      int nargs_wanted = 0;
+
+      for (auto &&piece : fpieces)
+	switch (piece.argclass)
+	  {
+	  case literal_piece:
+	    break;
+	  case int_arg:
+	  case long_arg:
+	  case long_long_arg:
+	  case size_t_arg:
+	  case ptr_arg:
+	  case string_arg:
+	    ++nargs_wanted;
+	    break;
+	  default:
+	    return false;
+	  }
+
+      return nargs == nargs_wanted;
+    }
+  catch (const gdb_exception_error &ex)
+    {
+      return false;
+    }
+}
+
+/* See ax-gdb.h.  */
+
+bool
+ax_host_eval_p (const struct agent_expr *ax)
+{
+  int len = ax->buf.size ();
+  const ax_host_regmap *regmap = get_ax_host_regmap (ax->gdbarch);
+
+  /* The stack height expected at each jump target, or -1.  */
+  std::vector<int> target_height (len, -1);
+  int height = 0;
+  bool reachable = true;
+
+  for (int pc = 0; pc < len; )
+    {
+      enum agent_op op = (enum agent_op) ax->buf[pc];
+      int size, consumed, produced;
+
+      if (target_height[pc] >= 0)
+	{
+	  if (reachable && target_height[pc] != height)
+	    return false;
+	  height = target_height[pc];
+	  reachable = true;
+	}
+      else if (!reachable)
+	return false;
+
+      switch (op)
+	{
+#define DEFOP(NAME, SIZE, DATA_SIZE, CONSUMED, PRODUCED, VALUE)	\
+	case aop_ ## NAME:					\
+	  size = 1 + SIZE;					\
+	  consumed = CONSUMED;					\
+	  produced = PRODUCED;					\
+	  break;
+#include "gdbsupport/ax.def"
+#undef DEFOP
+	default:
+	  return false;
+	}
+
+      switch (op)
+	{
+	case aop_float:
+	case aop_ref_float:
+	case aop_ref_double:
+	case aop_ref_long_double:
+	case aop_l_to_d:
+	case aop_d_to_l:
+	case aop_trace:
+	case aop_trace_quick:
+	case aop_trace16:
+	case aop_tracev:
+	case aop_tracenz:
+	case aop_getv:
+	case aop_setv:
+	case aop_invalid2:
+	  /* Nothing the host can do for these, or nothing a condition
+	     or a command should be doing.  */
+	  return false;
+
+	case aop_printf:
+	  /* The only bytecode with a variable length.  */
+	  size = ax_host_printf_length (ax, pc);
+	  if (size < 0 || !ax_host_printf_ok_p (ax, pc))
+	    return false;
+	  consumed = ax->buf[pc + 1] + 2;
+	  break;
+
+	default:
+	  break;
+	}
+
+      if (pc + size > len || height < consumed)
+	return false;
+      height += produced - consumed;
+      if (height >= AX_HOST_STACK_MAX)
+	return false;
+
+      switch (op)
+	{
+	case aop_reg:
+	  {
+	    int reg = ax_host_read_const (ax, pc + 1, 2);
+
+	    if (reg >= regmap->map.size () || regmap->map[reg] < 0
+		|| register_size (ax->gdbarch, regmap->map[reg]) > 8)
+	      return false;
+	  }
+	  break;
+
+	case aop_goto:
+	case aop_if_goto:
+	  {
+	    /* GDB only generates forward jumps; refusing the others
+	       means evaluation always terminates.  */
+	    int target = ax_host_read_const (ax, pc + 1, 2);
+
+	    if (target <= pc || target >= len
+		|| (target_height[target] >= 0
+		    && target_height[target] != height))
+	      return false;
+	    target_height[target] = height;
+	    if (op == aop_goto)
+	      reachable = false;
+	  }
+	  break;
+
+	case aop_pick:
+	  /* HEIGHT already counts the copy.  */
+	  if (ax->buf[pc + 1] >= height - 1)
+	    return false;
+	  break;
+
+	case aop_end:
+	  reachable = false;
+	  break;
+
+	default:
+	  break;
+	}
+
+      pc += size;
+    }
+
+  /* Evaluation must not run off the end.  */
+  return !reachable;
+}
+
+/* Print the arguments ARGS of the printf bytecode at PC in AX, which
+   passed ax_host_printf_ok_p, to gdb_stdout.  Return false if a
+   string argument can't be read or is longer than
+   AX_HOST_STRING_MAX.  */
+
+static bool
+ax_host_printf (const struct agent_expr *ax, int pc, const ULONGEST *args,
+		ax_host_read_memory_ftype read_memory)
+{
+  const char *format = (const char *) &ax->buf[pc + 4];
+  format_pieces fpieces (&format);
+  std::string output;
+  int i = 0;
+
+  DIAGNOSTIC_PUSH
+  DIAGNOSTIC_IGNORE_FORMAT_NONLITERAL
+
+  for (auto &&piece : fpieces)
+    {
+      const char *substring = piece.string;
+
+      switch (piece.argclass)
+	{
+	case string_arg:
+	  {
+	    CORE_ADDR addr = args[i];
+	    std::string str;
+
+	    if (addr == 0)
+	      {
+		output += string_printf (substring, "(null)");
+		break;
+	      }
+	    for (;; addr++)
+	      {
+		gdb_byte c;
+
+		if (!read_memory (addr, &c, 1))
+		  return false;
+		if (c == 0)
+		  break;
+		if (str.size () >= AX_HOST_STRING_MAX)
+		  return false;
+		str += (char) c;
+	      }
+	    output += string_printf (substring, str.c_str ());
+	  }
+	  break;
+
+	case long_long_arg:
+	  output += string_printf (substring, (long long) args[i]);
+	  break;
+
+	case int_arg:
+	  output += string_printf (substring, (int) args[i]);
+	  break;
+
+	case long_arg:
+	  output += string_printf (substring, (long) args[i]);
+	  break;
+
+	case size_t_arg:
+	  output += string_printf (substring, (size_t) args[i]);
+	  break;
+
+	case ptr_arg:
+	  output += string_printf (substring, (void *) (uintptr_t) args[i]);
+	  break;
+
+	case literal_piece:
+	  /* This may include "%%", so format it too, with a dummy
+	     argument.  */
+	  output += string_printf (substring, 0);
+	  break;
+
+	default:
+	  gdb_assert_not_reached ("unchecked printf directive");
+	}
+
+      if (piece.argclass != literal_piece)
+	++i;
+    }
+
+  DIAGNOSTIC_POP
+
+  gdb_puts (output.c_str ());
+  gdb_flush (gdb_stdout);
+  return true;
+}
+
+/* See ax-gdb.h.  */
+
+bool
+ax_host_eval (const struct agent_expr *ax, struct regcache *regcache,
+	      ax_host_read_memory_ftype read_memory, ULONGEST *result)
+{
+  struct gdbarch *gdbarch = ax->gdbarch;
+  enum bfd_endian byte_order = gdbarch_byte_order (gdbarch);
+  const ax_host_regmap *regmap = get_ax_host_regmap (gdbarch);
+  const gdb_byte *code = ax->buf.data ();
+  int len = ax->buf.size ();
+  ULONGEST stack[AX_HOST_STACK_MAX];
+  gdb_byte buf[8];
+  int sp = 0;
+  int pc = 0;
+
+  while (pc < len)
+    {
+      enum agent_op op = (enum agent_op) code[pc++];
+
+      switch (op)
+	{
+	case aop_add:
+	  sp--;
+	  stack[sp - 1] += stack[sp];
+	  break;
+
+	case aop_sub:
+	  sp--;
+	  stack[sp - 1] -= stack[sp];
+	  break;
+
+	case aop_mul:
+	  sp--;
+	  stack[sp - 1] *= stack[sp];
+	  break;
+
+	case aop_div_signed:
+	case aop_div_unsigned:
+	case aop_rem_signed:
+	case aop_rem_unsigned:
+	  {
+	    ULONGEST b = stack[--sp];
+	    ULONGEST a = stack[sp - 1];
+
+	    /* Let the expression evaluator report these.  */
+	    if (b == 0
+		|| ((op == aop_div_signed || op == aop_rem_signed)
+		    && (LONGEST) b == -1))
+	      return false;
+
+	    if (op == aop_div_signed)
+	      stack[sp - 1] = (LONGEST) a / (LONGEST) b;
+	    else if (op == aop_div_unsigned)
+	      stack[sp - 1] = a / b;
+	    else if (op == aop_rem_signed)
+	      stack[sp - 1] = (LONGEST) a % (LONGEST) b;
+	    else
+	      stack[sp - 1] = a % b;
+	  }
+	  break;
+
+	case aop_lsh:
+	  sp--;
+	  if (stack[sp] >= 64)
+	    return false;
+	  stack[sp - 1] <<= stack[sp];
+	  break;
+
+	case aop_rsh_signed:
+	  sp--;
+	  if (stack[sp] >= 64)
+	    return false;
+	  stack[sp - 1] = (LONGEST) stack[sp - 1] >> stack[sp];
+	  break;
+
+	case aop_rsh_unsigned:
+	  sp--;
+	  if (stack[sp] >= 64)
+	    return false;
+	  stack[sp - 1] >>= stack[sp];
+	  break;
+
+	case aop_log_not:
+	  stack[sp - 1] = !stack[sp - 1];
+	  break;
+
+	case aop_bit_and:
+	  sp--;
+	  stack[sp - 1] &= stack[sp];
+	  break;
+
+	case aop_bit_or:
+	  sp--;
+	  stack[sp - 1] |= stack[sp];
+	  break;
+
+	case aop_bit_xor:
+	  sp--;
+	  stack[sp - 1] ^= stack[sp];
+	  break;
+
+	case aop_bit_not:
+	  stack[sp - 1] = ~stack[sp - 1];
+	  break;
+
+	case aop_equal:
+	  sp--;
+	  stack[sp - 1] = stack[sp - 1] == stack[sp];
+	  break;
+
+	case aop_less_signed:
+	  sp--;
+	  stack[sp - 1] = (LONGEST) stack[sp - 1] < (LONGEST) stack[sp];
+	  break;
+
+	case aop_less_unsigned:
+	  sp--;
+	  stack[sp - 1] = stack[sp - 1] < stack[sp];
+	  break;
+
+	case aop_ext:
+	  {
+	    int n = code[pc++];
+
+	    if (n > 0 && n < 64)
+	      {
+		ULONGEST mask = (ULONGEST) 1 << (n - 1);
+
+		stack[sp - 1] &= ((ULONGEST) 1 << n) - 1;
+		stack[sp - 1] = (stack[sp - 1] ^ mask) - mask;
+	      }
+	  }
+	  break;
+
+	case aop_zero_ext:
+	  {
+	    int n = code[pc++];
+
+	    if (n < 64)
+	      stack[sp - 1] &= ((ULONGEST) 1 << n) - 1;
+	  }
+	  break;
+
+	case aop_ref8:
+	case aop_ref16:
+	case aop_ref32:
+	case aop_ref64:
+	  {
+	    int size = (op == aop_ref8 ? 1
+			: op == aop_ref16 ? 2
+			: op == aop_ref32 ? 4 : 8);
+
+	    if (!read_memory (stack[sp - 1], buf, size))
+	      return false;
+	    stack[sp - 1] = extract_unsigned_integer (buf, size, byte_order);
+	  }
+	  break;
+
+	case aop_if_goto:
+	  if (stack[--sp] != 0)
+	    pc = ax_host_read_const (ax, pc, 2);
+	  else
+	    pc += 2;
+	  break;
+
+	case aop_goto:
+	  pc = ax_host_read_const (ax, pc, 2);
+	  break;
+
+	case aop_const8:
+	  stack[sp++] = ax_host_read_const (ax, pc, 1);
+	  pc += 1;
+	  break;
+
+	case aop_const16:
+	  stack[sp++] = ax_host_read_const (ax, pc, 2);
+	  pc += 2;
+	  break;
+
+	case aop_const32:
+	  stack[sp++] = ax_host_read_const (ax, pc, 4);
+	  pc += 4;
+	  break;
+
+	case aop_const64:
+	  stack[sp++] = ax_host_read_const (ax, pc, 8);
+	  pc += 8;
+	  break;
+
+	case aop_reg:
+	  {
+	    int regnum = regmap->map[ax_host_read_const (ax, pc, 2)];
+
+	    pc += 2;
+	    if (regcache_raw_read_unsigned (regcache, regnum, &stack[sp])
+		!= REG_VALID)
+	      return false;
+	    sp++;
+	  }
+	  break;
+
+	case aop_end:
+	  *result = sp > 0 ? stack[sp - 1] : 0;
+	  return true;
+
+	case aop_dup:
+	  stack[sp] = stack[sp - 1];
+	  sp++;
+	  break;
+
+	case aop_pop:
+	  sp--;
+	  break;
+
+	case aop_pick:
+	  {
+	    int depth = code[pc++];
+
+	    stack[sp] = stack[sp - 1 - depth];
+	    sp++;
+	  }
+	  break;
+
+	case aop_rot:
+	  {
+	    ULONGEST tem = stack[sp - 1];
+
+	    stack[sp - 1] = stack[sp - 2];
+	    stack[sp - 2] = stack[sp - 3];
+	    stack[sp - 3] = tem;
+	  }
+	  break;
+
+	case aop_swap:
+	  std::swap (stack[sp - 1], stack[sp - 2]);
+	  break;
+
+	case aop_printf:
+	  {
+	    int nargs = code[pc];
+	    ULONGEST args[AX_HOST_STACK_MAX];
+
+	    /* Skip the function and channel; the output always goes to
+	       GDB's standard output.  The arguments were pushed last
+	       one first.  */
+	    sp -= 2;
+	    for (int i = 0; i < nargs; i++)
+	      args[i] = stack[--sp];
+	    if (!ax_host_printf (ax, pc - 1, args, read_memory))
+	      return false;
+	    pc += ax_host_printf_length (ax, pc - 1) - 1;
+	  }
+	  break;
+
+	default:
+	  /* ax_host_eval_p refused everything else.  */
+	  return false;
+	}
+    }
+
+  return false;
+}
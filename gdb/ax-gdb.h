@@ -20,6 +20,7 @@
 #define AX_GDB_H
 
 #include "ax.h"  /* For agent_expr_up.  */
+#include "gdbsupport/function-view.h"
 
 struct expression;
 
@@ -114,6 +115,32 @@ extern agent_expr_up gen_trace_for_return_address (CORE_ADDR,
 
 extern agent_expr_up gen_eval_for_expr (CORE_ADDR, struct expression *);
 
+/* Evaluating agent expressions in GDB itself (ax-eval.c).  */
+
+/* Return true if AX only uses bytecodes that ax_host_eval can
+   evaluate.  This covers the bytecode GDB generates for breakpoint
+   conditions, see gen_eval_for_expr, and for dprintf, see
+   gen_printf.  */
+extern bool ax_host_eval_p (const struct agent_expr *ax);
+
+/* The type of the function ax_host_eval uses to read LEN bytes of the
+   inferior's memory at ADDR into BUF.  It returns false on error.  */
+using ax_host_read_memory_ftype
+  = gdb::function_view<bool (CORE_ADDR addr, gdb_byte *buf, int len)>;
+
+/* Evaluate AX, which must have passed ax_host_eval_p, reading
+   registers from REGCACHE and memory with READ_MEMORY.  The output of
+   printf bytecodes goes to gdb_stdout.  On success, store the value
+   left on the stack (or zero) in *RESULT and return true.  Return
+   false if evaluation could not complete, e.g. because of a memory
+   error or a division by zero; the caller should then fall back to
+   evaluating the original expression, which will report the problem
+   properly.  */
+extern bool ax_host_eval (const struct agent_expr *ax,
+			  struct regcache *regcache,
+			  ax_host_read_memory_ftype read_memory,
+			  ULONGEST *result);
+
 extern void gen_expr (struct expression *exp, union exp_element **pc,
 		      struct agent_expr *ax, struct axs_value *value);
 
@@ -964,6 +964,8 @@ set_breakpoint_location_condition (const char *cond_string, bp_location *loc,
       else
 	{
 	  loc->cond = std::move (new_exp);
+	  loc->host_cond_bytecode.reset ();
+	  loc->host_cond_bytecode_tried = false;
 	  if (loc->disabled_by_cond && loc->enabled)
 	    gdb_printf (_("Breakpoint %d's condition is now valid at "
 			  "location %d, enabling.\n"),
@@ -1020,6 +1022,8 @@ set_breakpoint_condition (struct breakpoint *b, const char *exp,
 	  for (bp_location &loc : b->locations ())
 	    {
 	      loc.cond.reset ();
+	      loc.host_cond_bytecode.reset ();
+	      loc.host_cond_bytecode_tried = false;
 	      if (loc.disabled_by_cond && loc.enabled)
 		gdb_printf (_("Breakpoint %d's condition is now valid at "
 			      "location %d, enabling.\n"),
@@ -2345,6 +2349,26 @@ unduplicated_should_be_inserted (struct bp_location *bl)
   return should_be_inserted (bl);
 }
 
+/* Return true if a location that doesn't belong to a user breakpoint,
+   e.g., a step-resume or longjmp breakpoint, is to be inserted at
+   BL's address.  Hits of such a location must always be reported to
+   GDB, so the target must not filter them with the conditions or
+   commands of user breakpoints at the same address.  */
+
+static bool
+internal_location_at_address_p (struct bp_location *bl)
+{
+  for (bp_location *loc : all_bp_locations_at_addr (bl->address))
+    if (!is_breakpoint (loc->owner)
+	&& loc->pspace->num == bl->pspace->num
+	&& (loc->loc_type == bp_loc_software_breakpoint
+	    || loc->loc_type == bp_loc_hardware_breakpoint)
+	&& unduplicated_should_be_inserted (loc))
+      return true;
+
+  return false;
+}
+
 /* Parses a conditional described by an expression COND into an
    agent expression bytecode suitable for evaluation
    by the bytecode interpreter.  Return NULL if there was
@@ -2399,6 +2423,11 @@ build_target_condition_list (struct bp_location *bl)
       || !target_supports_evaluation_of_breakpoint_conditions ())
     return;
 
+  /* An internal breakpoint at the same address must always be
+     reported.  */
+  if (internal_location_at_address_p (bl))
+    return;
+
   auto loc_range = all_bp_locations_at_addr (bl->address);
 
   /* Do a first pass to check for locations with no assigned
@@ -2588,6 +2617,10 @@ build_target_command_list (struct bp_location *bl)
 	&& loc->owner->type != bp_dprintf)
       return;
 
+  /* Likewise for internal breakpoints.  */
+  if (internal_location_at_address_p (bl))
+    return;
+
   /* Do a first pass to check for locations with no assigned
      conditions or conditions that fail to parse to a valid agent expression
      bytecode.  If any of these happen, then it's no use to send conditions
@@ -2753,6 +2786,12 @@ insert_bp_location (struct bp_location *bl,
       /* Reset the modification marker.  */
       bl->needs_update = 0;
     }
+  else
+    {
+      bl->target_info.conditions.clear ();
+      bl->target_info.tcommands.clear ();
+      bl->needs_update = 0;
+    }
 
   /* If "set breakpoint auto-hw" is "on" and a software breakpoint was
      set at a read-only address, then a breakpoint location will have
@@ -4973,6 +5012,112 @@ breakpoint_cond_eval (expression *exp)
   return value_true (exp->evaluate ());
 }
 
+/* If true, GDB evaluates breakpoint conditions from bytecode when it
+   can, see breakpoint_cond_eval_bytecode.  */
+
+static bool host_condition_bytecode = true;
+
+/* Implement "maint show host-condition-bytecode".  */
+
+static void
+show_host_condition_bytecode (struct ui_file *file, int from_tty,
+			      struct cmd_list_element *c, const char *value)
+{
+  gdb_printf (file, _("Evaluation of breakpoint conditions "
+		      "from bytecode is %s.\n"), value);
+}
+
+/* Compile the condition of BL to bytecode that ax_host_eval can
+   evaluate.  Return NULL if that isn't possible.  */
+
+static agent_expr_up
+compile_host_condition (bp_location *bl)
+{
+  if (overlay_debugging != ovly_off)
+    return nullptr;
+
+  /* At the start of an inlined function, the expression evaluator
+     finds the variables of the condition through the frame chain and
+     may well complain that the block isn't active yet.  The bytecode
+     only sees registers and memory, and would not complain; leave
+     such locations to the evaluator so that the two always agree.  */
+  for (const block *b = block_for_pc (bl->address);
+       b != nullptr;
+       b = b->superblock ())
+    {
+      if (b->inlined_p ())
+	return nullptr;
+      if (b->function () != nullptr)
+	break;
+    }
+
+  agent_expr_up aexpr = parse_cond_to_aexpr (bl->address, bl->cond.get ());
+  if (aexpr == nullptr || !ax_host_eval_p (aexpr.get ()))
+    return nullptr;
+
+  return aexpr;
+}
+
+/* Try to evaluate the condition of BL, which THREAD has just hit, from
+   bytecode instead of with the expression evaluator.  The bytecode is
+   compiled the first time around and kept in BL, so that a hot
+   conditional breakpoint only needs to read a couple of registers and
+   words of memory per hit.  Return true and set *RESULT if that
+   worked.  On false, the caller must evaluate the condition the usual
+   way.  */
+
+static bool
+breakpoint_cond_eval_bytecode (bp_location *bl, thread_info *thread,
+			       bool *result)
+{
+  if (!host_condition_bytecode
+      || bl->loc_type == bp_loc_hardware_watchpoint
+      || bl->loc_type == bp_loc_software_watchpoint
+      || thread->ptid != inferior_ptid)
+    return false;
+
+  if (!bl->host_cond_bytecode_tried)
+    {
+      bl->host_cond_bytecode_tried = true;
+      try
+	{
+	  bl->host_cond_bytecode = compile_host_condition (bl);
+	}
+      catch (const gdb_exception_error &ex)
+	{
+	}
+    }
+
+  const agent_expr *aexpr = bl->host_cond_bytecode.get ();
+  if (aexpr == nullptr)
+    return false;
+
+  try
+    {
+      struct regcache *regcache = get_thread_regcache (thread);
+      auto read_memory = [] (CORE_ADDR addr, gdb_byte *buf, int len)
+	{
+	  return target_read_memory (addr, buf, len) == 0;
+	};
+      ULONGEST value;
+
+      /* The bytecode was compiled for BL's address; anywhere else,
+	 e.g. in the middle of a ranged breakpoint, the locations of
+	 variables may differ.  */
+      if (regcache->arch () != aexpr->gdbarch
+	  || regcache_read_pc (regcache) != bl->address
+	  || !ax_host_eval (aexpr, regcache, read_memory, &value))
+	return false;
+
+      *result = value != 0;
+      return true;
+    }
+  catch (const gdb_exception_error &ex)
+    {
+      return false;
+    }
+}
+
 /* Allocate a new bpstat.  Link it to the FIFO list by BS_LINK_POINTER.  */
 
 bpstat::bpstat (struct bp_location *bl, bpstat ***bs_link_pointer)
@@ -5431,7 +5576,7 @@ bpstat_check_breakpoint_conditions (bpstat *bs, thread_info *thread)
 {
   INFRUN_SCOPED_DEBUG_ENTER_EXIT;
 
-  const struct bp_location *bl;
+  struct bp_location *bl;
   struct breakpoint *b;
   /* Assume stop.  */
   bool condition_result = true;
@@ -5487,7 +5632,11 @@ bpstat_check_breakpoint_conditions (bpstat *bs, thread_info *thread)
   else
     cond = bl->cond.get ();
 
-  if (cond != nullptr && b->disposition != disp_del_at_next_stop)
+  if (cond != nullptr && b->disposition != disp_del_at_next_stop
+      && !is_watchpoint (b)
+      && breakpoint_cond_eval_bytecode (bl, thread, &condition_result))
+    infrun_debug_printf ("condition evaluated from bytecode");
+  else if (cond != nullptr && b->disposition != disp_del_at_next_stop)
     {
       bool within_current_scope = true;
       struct watchpoint * w;
@@ -11472,6 +11621,16 @@ update_global_location_list (enum ugll_insert_mode insert_mode)
 	swap_insertion (loc, *loc_first_p);
       loc->duplicate = 1;
 
+      /* If the target filters the hits of the inserted location with
+	 the conditions or commands of user breakpoints, re-insert it
+	 without them now that an internal breakpoint shares its
+	 address.  */
+      if ((!is_breakpoint (b) || !is_breakpoint ((*loc_first_p)->owner))
+	  && (*loc_first_p)->inserted
+	  && (!(*loc_first_p)->target_info.conditions.empty ()
+	      || !(*loc_first_p)->target_info.tcommands.empty ()))
+	(*loc_first_p)->needs_update = 1;
+
       /* Clear the condition modification flag.  */
       loc->condition_changed = condition_unchanged;
     }
@@ -11786,14 +11945,33 @@ code_breakpoint::breakpoint_hit (const struct bp_location *bl,
   return 1;
 }
 
+/* Return true if the target runs the commands of BL, an agent-style
+   dprintf location, itself.  The target may have declined them when
+   the location was inserted, see bp_target_info.  */
+
+static bool
+target_runs_dprintf_p (const struct bp_location *bl)
+{
+  if (dprintf_style != dprintf_style_agent
+      || !target_can_run_breakpoint_commands ())
+    return false;
+
+  for (bp_location *loc : all_bp_locations_at_addr (bl->address))
+    if (loc->inserted
+	&& !loc->target_info.tcommands.empty ()
+	&& breakpoint_locations_match (loc, bl))
+      return true;
+
+  return false;
+}
+
 int
 dprintf_breakpoint::breakpoint_hit (const struct bp_location *bl,
 				    const address_space *aspace,
 				    CORE_ADDR bp_addr,
 				    const target_waitstatus &ws)
 {
-  if (dprintf_style == dprintf_style_agent
-      && target_can_run_breakpoint_commands ())
+  if (target_runs_dprintf_p (bl))
     {
       /* An agent-style dprintf never causes a stop.  If we see a trap
 	 for this address it must be for a breakpoint that happens to
@@ -12220,6 +12398,18 @@ dprintf_breakpoint::after_condition_true (struct bpstat *bs)
      commands here throws.  */
   counted_command_line cmds = std::move (bs->commands);
   gdb_assert (cmds != nullptr);
+
+  /* The target reported the hit of an agent-style dprintf instead of
+     printing, so print here.  */
+  static const char agent_printf[] = "agent-printf ";
+  if (cmds->next == nullptr && startswith (cmds->line, agent_printf))
+    {
+      const char *args = cmds->line + strlen (agent_printf);
+
+      execute_command (string_printf ("printf %s", args).c_str (), 0);
+      return;
+    }
+
   execute_control_commands (cmds.get (), 0);
 }
 
@@ -12974,11 +13164,45 @@ breakpoint_re_set_one (breakpoint *b)
   b->re_set ();
 }
 
-/* Re-set breakpoint locations for the current program space.
-   Locations bound to other program spaces are left untouched.  */
+/* See breakpoint.h.  */
 
-void
-breakpoint_re_set (void)
+bool
+code_breakpoint::may_have_locations_in
+  (const std::unordered_set<objfile *> &objfiles)
+{
+  /* Only ordinary location specs are decoded by linespec, and can be
+     restricted to OBJFILES.  */
+  if (!is_breakpoint (this)
+      || locspec == nullptr
+      || locspec_range_end != nullptr
+      || (locspec->type () != LINESPEC_LOCATION_SPEC
+	  && locspec->type () != EXPLICIT_LOCATION_SPEC))
+    return true;
+
+  /* A condition that failed to parse might refer to a symbol of
+     OBJFILES.  */
+  for (const bp_location &loc : locations ())
+    if (loc.disabled_by_cond)
+      return true;
+
+  scoped_linespec_objfile_filter restrict_to_objfiles (objfiles);
+  try
+    {
+      return !decode_location_spec (locspec.get (), pspace).empty ();
+    }
+  catch (const gdb_exception_error &e)
+    {
+      /* Any other error is reported by the re-set.  */
+      return e.error != NOT_FOUND_ERROR;
+    }
+}
+
+/* Re-set the breakpoints for which NEEDS_RE_SET returns true, or all
+   of them if NEEDS_RE_SET is NULL.  See breakpoint_re_set.  */
+
+static void
+breakpoint_re_set_if
+  (gdb::function_view<bool (breakpoint *)> needs_re_set)
 {
   {
     scoped_restore_current_language save_language;
@@ -13007,7 +13231,8 @@ breakpoint_re_set (void)
       {
 	try
 	  {
-	    breakpoint_re_set_one (&b);
+	    if (needs_re_set == nullptr || needs_re_set (&b))
+	      breakpoint_re_set_one (&b);
 	  }
 	catch (const gdb_exception &ex)
 	  {
@@ -13028,6 +13253,42 @@ breakpoint_re_set (void)
   /* Now we can insert.  */
   update_global_location_list (UGLL_MAY_INSERT);
 }
+
+/* Re-set breakpoint locations for the current program space.
+   Locations bound to other program spaces are left untouched.  */
+
+void
+breakpoint_re_set (void)
+{
+  breakpoint_re_set_if (nullptr);
+}
+
+/* See breakpoint.h.  */
+
+void
+breakpoint_re_set_objfiles (gdb::array_view<objfile *const> objfiles)
+{
+  std::unordered_set<objfile *> new_objfiles;
+  for (objfile *objfile : objfiles)
+    for (::objfile *iter : objfile->separate_debug_objfiles ())
+      new_objfiles.insert (iter);
+
+  breakpoint_re_set_if ([&] (breakpoint *b)
+    {
+      /* The locations found in the other objfiles can't change when
+	 objfiles are added, so a breakpoint that has no location in the
+	 new objfiles is left alone.  This avoids decoding the location
+	 specs of all the breakpoints in all the objfiles each time a
+	 shared library is loaded.  */
+      code_breakpoint *cb = dynamic_cast<code_breakpoint *> (b);
+      if (cb == nullptr)
+	return true;
+
+      input_radix = b->input_radix;
+      set_language (b->language);
+      return cb->may_have_locations_in (new_objfiles);
+    });
+}
 
 /* Reset the thread number of this breakpoint:
 
@@ -14885,6 +15146,19 @@ a warning will be emitted for such breakpoints."),
 			   &breakpoint_set_cmdlist,
 			   &breakpoint_show_cmdlist);
 
+  add_setshow_boolean_cmd ("host-condition-bytecode", class_maintenance,
+			   &host_condition_bytecode, _("\
+Set whether GDB evaluates breakpoint conditions from bytecode."), _("\
+Show whether GDB evaluates breakpoint conditions from bytecode."), _("\
+When on, breakpoint conditions that can be translated to agent expression\n\
+bytecode are compiled once and then evaluated by GDB from the bytecode,\n\
+which is much faster than going through the full expression evaluator.\n\
+Conditions that can't be translated are always evaluated the usual way."),
+			   NULL,
+			   show_host_condition_bytecode,
+			   &maintenance_set_cmdlist,
+			   &maintenance_show_cmdlist);
+
   add_setshow_boolean_cmd ("always-inserted", class_support,
 			   &always_inserted_mode, _("\
 Set mode for inserting breakpoints."), _("\
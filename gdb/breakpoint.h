@@ -27,6 +27,7 @@
 #include "probe.h"
 #include "location.h"
 #include <vector>
+#include <unordered_set>
 #include "gdbsupport/array-view.h"
 #include "gdbsupport/filtered-iterator.h"
 #include "gdbsupport/function-view.h"
@@ -286,11 +287,15 @@ struct bp_target_info
   int kind;
 
   /* Conditions the target should evaluate if it supports target-side
-     breakpoint conditions.  These are non-owning pointers.  */
+     breakpoint conditions.  These are non-owning pointers.  A target
+     that can't evaluate them for this breakpoint clears them when
+     inserting it, and reports every hit.  */
   std::vector<agent_expr *> conditions;
 
   /* Commands the target should evaluate if it supports target-side
-     breakpoint commands.  These are non-owning pointers.  */
+     breakpoint commands.  These are non-owning pointers.  Cleared on
+     insertion, like CONDITIONS, by a target that can't run them; GDB
+     then runs them itself.  */
   std::vector<agent_expr *> tcommands;
 
   /* Flag that is true if the breakpoint should be left in place even
@@ -358,6 +363,14 @@ class bp_location : public refcounted_object, public intrusive_list_node<bp_loca
      condition evaluation.  */
   agent_expr_up cond_bytecode;
 
+  /* COND compiled to bytecode for evaluation by GDB itself, see
+     ax_host_eval.  Built the first time the location is hit with a
+     condition, and thrown away whenever COND changes.  NULL if not
+     built yet, or if COND can't be compiled; HOST_COND_BYTECODE_TRIED
+     tells those apart.  */
+  agent_expr_up host_cond_bytecode;
+  bool host_cond_bytecode_tried = false;
+
   /* Signals that the condition has changed since the last time
      we updated the global location list.  This means the condition
      needs to be sent to the target again.  This is used together
@@ -927,6 +940,12 @@ struct code_breakpoint : public breakpoint
   /* Add a location for SAL to this breakpoint.  */
   bp_location *add_location (const symtab_and_line &sal);
 
+  /* Return true if some locations of this breakpoint may be in
+     OBJFILES.  This is used when OBJFILES were just added: if this
+     returns false, they don't change the locations of this breakpoint.
+     This errs on the side of returning true.  */
+  bool may_have_locations_in (const std::unordered_set<objfile *> &objfiles);
+
   void re_set () override;
   int insert_location (struct bp_location *) override;
   int remove_location (struct bp_location *,
@@ -1480,6 +1499,12 @@ extern void update_breakpoint_locations
 
 extern void breakpoint_re_set (void);
 
+/* Like breakpoint_re_set, but only re-set the breakpoints that may be
+   affected by the addition of OBJFILES.  */
+
+extern void breakpoint_re_set_objfiles
+  (gdb::array_view<objfile *const> objfiles);
+
 extern void breakpoint_re_set_thread (struct breakpoint *);
 
 extern void delete_breakpoint (struct breakpoint *);
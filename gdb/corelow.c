@@ -47,6 +47,7 @@
 #include "build-id.h"
 #include "gdbsupport/pathstuff.h"
 #include "gdbsupport/scoped_fd.h"
+#include "gdbsupport/scoped_mmap.h"
 #include "debuginfod-support.h"
 #include <unordered_map>
 #include <unordered_set>
@@ -58,6 +59,79 @@
 #define O_LARGEFILE 0
 #endif
 
+/* An index of the sections of a target_section_table that match a
+   given predicate, sorted by address, to find the section holding an
+   address without scanning the whole table.  When several sections
+   overlap, the order of the table decides which one is used, so the
+   index is only usable when the sections don't overlap.  */
+
+class core_section_index
+{
+public:
+  core_section_index () = default;
+
+  core_section_index (const target_section_table &table,
+		      gdb::function_view<bool
+			(const struct target_section *)> match_cb);
+
+  /* Return true if the index can be used instead of scanning the
+     table.  */
+  bool usable () const
+  {
+    return m_usable;
+  }
+
+  /* Return the section holding ADDR, or NULL if there is none.  */
+  const target_section *find (CORE_ADDR addr) const;
+
+private:
+  /* The sections, sorted by address.  */
+  std::vector<const target_section *> m_sections;
+
+  /* Whether the sections don't overlap.  */
+  bool m_usable = false;
+};
+
+core_section_index::core_section_index
+  (const target_section_table &table,
+   gdb::function_view<bool (const struct target_section *)> match_cb)
+{
+  for (const target_section &p : table)
+    if (p.addr < p.endaddr && (match_cb == nullptr || match_cb (&p)))
+      m_sections.push_back (&p);
+
+  std::sort (m_sections.begin (), m_sections.end (),
+	     [] (const target_section *a, const target_section *b)
+	     {
+	       return a->addr < b->addr;
+	     });
+
+  m_usable = true;
+  for (size_t i = 1; i < m_sections.size (); ++i)
+    if (m_sections[i]->addr < m_sections[i - 1]->endaddr)
+      {
+	m_usable = false;
+	break;
+      }
+}
+
+const target_section *
+core_section_index::find (CORE_ADDR addr) const
+{
+  auto it = std::upper_bound (m_sections.begin (), m_sections.end (), addr,
+			      [] (CORE_ADDR a, const target_section *p)
+			      {
+				return a < p->addr;
+			      });
+  if (it == m_sections.begin ())
+    return nullptr;
+
+  --it;
+  if (addr >= (*it)->endaddr)
+    return nullptr;
+  return *it;
+}
+
 /* The core file target.  */
 
 static const target_info core_target_info = {
@@ -150,9 +224,34 @@ class core_target final : public process_stratum_target
      still be useful.  */
   std::vector<mem_range> m_core_unavailable_mappings;
 
+  /* Address-sorted indexes of the sections of m_core_section_table
+     with and without contents, and of m_core_file_mappings.  */
+  core_section_index m_core_contents_index;
+  core_section_index m_core_no_contents_index;
+  core_section_index m_core_file_mappings_index;
+
+#ifdef HAVE_SYS_MMAN_H
+  /* The whole core file, mapped in memory, or MAP_FAILED if it
+     couldn't be.  The contents of its sections are copied from there
+     rather than read through BFD.  */
+  scoped_mmap m_core_mapping;
+#endif
+
   /* Build m_core_file_mappings.  Called from the constructor.  */
   void build_file_mappings ();
 
+  /* Map the core file in memory and build the section indexes.
+     Called from the constructor.  */
+  void build_memory_index ();
+
+  /* Helper method for xfer_partial.  */
+  enum target_xfer_status xfer_section_memory
+    (gdb_byte *readbuf, const gdb_byte *writebuf,
+     ULONGEST offset, ULONGEST len, ULONGEST *xfered_len,
+     const target_section_table &table, const core_section_index &index,
+     gdb::function_view<bool (const struct target_section *)> match_cb
+       = nullptr);
+
   /* Helper method for xfer_partial.  */
   enum target_xfer_status xfer_memory_via_mappings (gdb_byte *readbuf,
 						    const gdb_byte *writebuf,
@@ -192,6 +291,55 @@ core_target::core_target ()
   m_core_section_table = build_section_table (core_bfd);
 
   build_file_mappings ();
+  build_memory_index ();
+}
+
+/* Return true if the contents of the core file section of S are in
+   the core file.  */
+
+static bool
+core_section_has_contents (const struct target_section *s)
+{
+  return (s->the_bfd_section->flags & SEC_HAS_CONTENTS) != 0;
+}
+
+void
+core_target::build_memory_index ()
+{
+  m_core_contents_index
+    = core_section_index (m_core_section_table, core_section_has_contents);
+  m_core_no_contents_index
+    = core_section_index (m_core_section_table,
+			  [] (const struct target_section *s)
+			  {
+			    return !core_section_has_contents (s);
+			  });
+  m_core_file_mappings_index
+    = core_section_index (m_core_file_mappings, nullptr);
+
+#ifdef HAVE_SYS_MMAN_H
+  /* Only map the core file if it's the very file BFD has open, e.g.
+     not one read from the remote target.  */
+  const char *filename = bfd_get_filename (core_bfd);
+  if (is_target_filename (filename))
+    return;
+
+  struct stat bfd_st, st;
+  if (bfd_stat (core_bfd, &bfd_st) != 0)
+    return;
+
+  scoped_fd fd = gdb_open_cloexec (filename, O_RDONLY, 0);
+  if (fd.get () < 0
+      || fstat (fd.get (), &st) != 0
+      || st.st_dev != bfd_st.st_dev
+      || st.st_ino != bfd_st.st_ino
+      || st.st_size == 0
+      || (uintmax_t) st.st_size > SIZE_MAX)
+    return;
+
+  m_core_mapping.reset (nullptr, st.st_size, PROT_READ, MAP_PRIVATE,
+			fd.get (), 0);
+#endif
 }
 
 /* Construct the target_section_table for file-backed mappings if
@@ -954,6 +1102,61 @@ core_target::files_info ()
   print_section_info (&m_core_section_table, core_bfd);
 }
 
+/* Read or write memory like section_table_xfer_memory_partial does
+   with the sections of TABLE that match MATCH_CB, or all of them if
+   MATCH_CB is NULL.  INDEX must have been built from TABLE and
+   MATCH_CB.  If INDEX is usable, a read finds the section holding
+   OFFSET with it instead of scanning TABLE, and copies the contents
+   of a core file section from the mapped core file if they're all
+   there.  Writes, and reads when INDEX isn't usable, go through
+   section_table_xfer_memory_partial.  */
+
+enum target_xfer_status
+core_target::xfer_section_memory
+  (gdb_byte *readbuf, const gdb_byte *writebuf,
+   ULONGEST offset, ULONGEST len, ULONGEST *xfered_len,
+   const target_section_table &table, const core_section_index &index,
+   gdb::function_view<bool (const struct target_section *)> match_cb)
+{
+  if (writebuf != nullptr || !index.usable ())
+    return section_table_xfer_memory_partial (readbuf, writebuf,
+					      offset, len, xfered_len,
+					      table, match_cb);
+
+  const target_section *p = index.find (offset);
+  if (p == nullptr)
+    return TARGET_XFER_EOF;
+
+  asection *asect = p->the_bfd_section;
+  ULONGEST sect_offset = offset - p->addr;
+  len = std::min (len, p->endaddr - offset);
+
+#ifdef HAVE_SYS_MMAN_H
+  /* Copy the contents straight from the mapped core file, if they're
+     all there; the file may have been truncated.  */
+  if (asect->owner == core_bfd
+      && m_core_mapping.get () != MAP_FAILED
+      && (asect->flags & SEC_HAS_CONTENTS) != 0
+      && asect->filepos >= 0
+      && (ULONGEST) asect->filepos + bfd_section_size (asect)
+	   <= m_core_mapping.size ())
+    {
+      const gdb_byte *contents
+	= (const gdb_byte *) m_core_mapping.get () + asect->filepos;
+      memcpy (readbuf, contents + sect_offset, len);
+      *xfered_len = len;
+      return TARGET_XFER_OK;
+    }
+#endif
+
+  if (!bfd_get_section_contents (asect->owner, asect, readbuf,
+				 sect_offset, len))
+    return TARGET_XFER_EOF;
+
+  *xfered_len = len;
+  return TARGET_XFER_OK;
+}
+
 /* Helper method for core_target::xfer_partial.  */
 
 enum target_xfer_status
@@ -964,10 +1167,10 @@ core_target::xfer_memory_via_mappings (gdb_byte *readbuf,
 {
   enum target_xfer_status xfer_status;
 
-  xfer_status = (section_table_xfer_memory_partial
-		   (readbuf, writebuf,
-		    offset, len, xfered_len,
-		    m_core_file_mappings));
+  xfer_status = xfer_section_memory (readbuf, writebuf,
+				     offset, len, xfered_len,
+				     m_core_file_mappings,
+				     m_core_file_mappings_index);
 
   if (xfer_status == TARGET_XFER_OK || m_core_unavailable_mappings.empty ())
     return xfer_status;
@@ -1018,15 +1221,11 @@ core_target::xfer_partial (enum target_object object, const char *annex,
 	/* Try accessing memory contents from core file data,
 	   restricting consideration to those sections for which
 	   the BFD section flag SEC_HAS_CONTENTS is set.  */
-	auto has_contents_cb = [] (const struct target_section *s)
-	  {
-	    return ((s->the_bfd_section->flags & SEC_HAS_CONTENTS) != 0);
-	  };
-	xfer_status = section_table_xfer_memory_partial
-			(readbuf, writebuf,
-			 offset, len, xfered_len,
-			 m_core_section_table,
-			 has_contents_cb);
+	xfer_status = xfer_section_memory (readbuf, writebuf,
+					   offset, len, xfered_len,
+					   m_core_section_table,
+					   m_core_contents_index,
+					   core_section_has_contents);
 	if (xfer_status == TARGET_XFER_OK)
 	  return TARGET_XFER_OK;
 
@@ -1053,15 +1252,15 @@ core_target::xfer_partial (enum target_object object, const char *annex,
 
 	/* Finally, attempt to access data in core file sections with
 	   no contents.  These will typically read as all zero.  */
-	auto no_contents_cb = [&] (const struct target_section *s)
+	auto no_contents_cb = [] (const struct target_section *s)
 	  {
-	    return !has_contents_cb (s);
+	    return !core_section_has_contents (s);
 	  };
-	xfer_status = section_table_xfer_memory_partial
-			(readbuf, writebuf,
-			 offset, len, xfered_len,
-			 m_core_section_table,
-			 no_contents_cb);
+	xfer_status = xfer_section_memory (readbuf, writebuf,
+					   offset, len, xfered_len,
+					   m_core_section_table,
+					   m_core_no_contents_index,
+					   no_contents_cb);
 
 	return xfer_status;
       }
@@ -25,6 +25,7 @@
 #include "inferior.h"
 #include "splay-tree.h"
 #include "gdbarch.h"
+#include "gdbsupport/byte-vector.h"
 
 /* Commands with a prefix of `{set,show} dcache'.  */
 static struct cmd_list_element *dcache_set_list = NULL;
@@ -464,6 +465,100 @@ dcache_init (void)
 }
 
 
+/* Fill the lines of DCACHE covering the LEN bytes at MEMADDR that aren't
+   cached yet, with a single target_read_raw_memory_ranges call if the
+   target supports it.  This saves reading the lines one at a time in
+   dcache_peek_byte, e.g. when reading a large part of a stack.  The
+   lines that can't be read this way are left for dcache_read_line.  */
+
+static void
+dcache_prefetch_lines (DCACHE *dcache, CORE_ADDR memaddr, ULONGEST len)
+{
+  CORE_ADDR line_size = dcache->line_size;
+  CORE_ADDR first = MASK (dcache, memaddr);
+  CORE_ADDR last = MASK (dcache, memaddr + len - 1);
+  if (len == 0 || first == last || last < first)
+    return;
+
+  /* Don't read more lines than the cache can hold.  */
+  std::vector<CORE_ADDR> lines;
+  for (CORE_ADDR addr = first;
+       addr <= last && lines.size () < dcache_size;
+       addr += line_size)
+    {
+      if (dcache_hit (dcache, addr) == nullptr)
+	{
+	  /* Leave the lines crossing a memory region boundary, or in a
+	     non-readable region, to dcache_read_line.  */
+	  struct mem_region *region = lookup_mem_region (addr);
+	  if (region->attrib.mode != MEM_WO
+	      && region->lo <= addr
+	      && (region->hi == 0 || addr + line_size <= region->hi))
+	    lines.push_back (addr);
+	}
+
+      if (addr == last)
+	break;
+    }
+
+  if (lines.size () < 2)
+    return;
+
+  gdb::byte_vector data (lines.size () * line_size);
+  std::vector<memory_read_request> requests;
+  requests.reserve (lines.size ());
+  for (size_t i = 0; i < lines.size (); ++i)
+    requests.emplace_back (lines[i], &data[i * line_size], line_size);
+
+  if (!target_read_raw_memory_ranges (requests))
+    return;
+
+  for (size_t i = 0; i < lines.size (); ++i)
+    if (requests[i].xfered_len == line_size)
+      {
+	struct dcache_block *db = dcache_alloc (dcache, lines[i]);
+	memcpy (db->data, &data[i * line_size], line_size);
+      }
+}
+
+/* If DCACHE holds the memory of a different thread than the current
+   one, flush it, and record the current thread.  */
+
+static void
+dcache_check_thread (DCACHE *dcache)
+{
+  process_stratum_target *proc_target = current_inferior ()->process_target ();
+  if (proc_target != dcache->proc_target || inferior_ptid != dcache->ptid)
+    {
+      dcache_invalidate (dcache);
+      dcache->ptid = inferior_ptid;
+      dcache->proc_target = proc_target;
+    }
+}
+
+/* See dcache.h.  */
+
+void
+dcache_fill (DCACHE *dcache, CORE_ADDR memaddr, const gdb_byte *data,
+	     ULONGEST len)
+{
+  dcache_check_thread (dcache);
+
+  CORE_ADDR line_size = dcache->line_size;
+  CORE_ADDR addr = align_up (memaddr, line_size);
+  unsigned count = 0;
+  for (; (addr + line_size <= memaddr + len
+	  && addr >= memaddr
+	  && count < dcache_size);
+       addr += line_size, ++count)
+    {
+      struct dcache_block *db = dcache_hit (dcache, addr);
+      if (db == nullptr)
+	db = dcache_alloc (dcache, addr);
+      memcpy (db->data, data + (addr - memaddr), line_size);
+    }
+}
+
 /* Read LEN bytes from dcache memory at MEMADDR, transferring to
    debugger address MYADDR.  If the data is presently cached, this
    fills the cache.  Arguments/return are like the target_xfer_partial
@@ -476,16 +571,9 @@ dcache_read_memory_partial (struct target_ops *ops, DCACHE *dcache,
 {
   ULONGEST i;
 
-  /* If this is a different thread from what we've recorded, flush the
-     cache.  */
+  dcache_check_thread (dcache);
 
-  process_stratum_target *proc_target = current_inferior ()->process_target ();
-  if (proc_target != dcache->proc_target || inferior_ptid != dcache->ptid)
-    {
-      dcache_invalidate (dcache);
-      dcache->ptid = inferior_ptid;
-      dcache->proc_target = proc_target;
-    }
+  dcache_prefetch_lines (dcache, memaddr, len);
 
   for (i = 0; i < len; i++)
     {
@@ -48,6 +48,12 @@ enum target_xfer_status
 			      CORE_ADDR memaddr, gdb_byte *myaddr,
 			      ULONGEST len, ULONGEST *xfered_len);
 
+/* Store the LEN bytes of DATA, which were read from the memory of the
+   current thread at MEMADDR, in DCACHE.  Only the lines that DATA
+   covers completely are stored.  */
+void dcache_fill (DCACHE *dcache, CORE_ADDR memaddr, const gdb_byte *data,
+		  ULONGEST len);
+
 void dcache_update (DCACHE *dcache, enum target_xfer_status status,
 		    CORE_ADDR memaddr, const gdb_byte *myaddr,
 		    ULONGEST len);
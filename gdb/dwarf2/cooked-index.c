@@ -248,6 +248,29 @@ cooked_index_shard::add (sect_offset die_offset, enum dwarf_tag tag,
 
 /* See cooked-index.h.  */
 
+cooked_index_entry *
+cooked_index_shard::add_cached (sect_offset die_offset, enum dwarf_tag tag,
+				cooked_index_flag flags, const char *name,
+				const char *canonical,
+				dwarf2_per_cu_data *per_cu, bool searchable)
+{
+  m_from_cache = true;
+
+  cooked_index_entry *result = create (die_offset, tag, flags, name,
+				       nullptr, per_cu);
+  result->canonical = canonical;
+  if (searchable)
+    {
+      m_entries.push_back (result);
+      if ((flags & IS_MAIN) != 0)
+	m_main = result;
+    }
+
+  return result;
+}
+
+/* See cooked-index.h.  */
+
 void
 cooked_index_shard::finalize ()
 {
@@ -304,6 +327,14 @@ cooked_index_shard::handle_gnat_encoded_entry (cooked_index_entry *entry,
 void
 cooked_index_shard::do_finalize ()
 {
+  /* Entries read back from a saved index are already canonicalized
+     and sorted.  */
+  if (m_from_cache)
+    {
+      m_entries.shrink_to_fit ();
+      return;
+    }
+
   auto hash_name_ptr = [] (const void *p)
     {
       const cooked_index_entry *entry = (const cooked_index_entry *) p;
@@ -261,6 +261,22 @@ class cooked_index_shard
 				 const cooked_index_entry *parent_entry,
 				 dwarf2_per_cu_data *per_cu);
 
+  /* Create a new cooked_index_entry that was read back from a saved
+     index, and register it with this object.  NAME and CANONICAL must
+     outlive this object.  Entries must be added in sorted order; if
+     SEARCHABLE is false, the entry is only created so that it can be
+     used as a parent, and it won't be found by lookups.  A shard that
+     holds such entries is not canonicalized or sorted when it is
+     finalized.  The new item is returned, so that its parent can be
+     set by the caller.  */
+  cooked_index_entry *add_cached (sect_offset die_offset,
+				  enum dwarf_tag tag,
+				  cooked_index_flag flags,
+				  const char *name,
+				  const char *canonical,
+				  dwarf2_per_cu_data *per_cu,
+				  bool searchable);
+
   /* Install a new fixed addrmap from the given mutable addrmap.  */
   void install_addrmap (addrmap_mutable *map)
   {
@@ -347,6 +363,8 @@ class cooked_index_shard
   addrmap *m_addrmap = nullptr;
   /* Storage for canonical names.  */
   std::vector<gdb::unique_xmalloc_ptr<char>> m_names;
+  /* True if the entries were added using add_cached.  */
+  bool m_from_cache = false;
   /* A future that tracks when the 'finalize' method is done.  Note
      that the 'get' method is never called on this future, only
      'wait'.  */
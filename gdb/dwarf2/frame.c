@@ -41,7 +41,9 @@
 #include "ax.h"
 #include "dwarf2/loc.h"
 #include "dwarf2/frame-tailcall.h"
-#include "gdbsupport/gdb_binary_search.h"
+#include "dwarf2/index-cache.h"
+#include "build-id.h"
+#include "gdb_bfd.h"
 #if GDB_SELF_TEST
 #include "gdbsupport/selftest.h"
 #include "selftest-arch.h"
@@ -135,10 +137,46 @@ struct dwarf2_fde
   /* True if this FDE is read from a .eh_frame instead of a .debug_frame
      section.  */
   unsigned char eh_frame_p;
+
+  /* Offset of this FDE in its section.  */
+  ULONGEST offset;
 };
 
 typedef std::vector<dwarf2_fde *> dwarf2_fde_table;
 
+/* An entry of the FDE index of a comp_unit: the code an FDE describes,
+   and where to decode it from when it is needed.  */
+
+struct dwarf2_fde_index_entry
+{
+  /* The code range of the FDE.  */
+  unrelocated_addr initial_location;
+  ULONGEST address_range;
+
+  /* Offset of the FDE in its section.  */
+  ULONGEST offset;
+
+  /* True if the FDE is in .eh_frame rather than .debug_frame.  */
+  bool eh_frame_p;
+};
+
+/* A section holding call frame information, and the entries decoded
+   from it so far.  */
+
+struct frame_section
+{
+  asection *section = nullptr;
+  const gdb_byte *buffer = nullptr;
+  bfd_size_type size = 0;
+
+  /* The CIEs decoded so far.  */
+  dwarf2_cie_table cies;
+
+  /* The FDEs decoded so far, by offset.  NULL for the offsets where no
+     valid FDE could be decoded.  */
+  std::unordered_map<ULONGEST, dwarf2_fde *> fdes;
+};
+
 /* A minimal decoding of DWARF2 compilation units.  We only decode
    what's needed to get to the call frame information.  */
 
@@ -152,13 +190,14 @@ struct comp_unit
   /* Keep the bfd convenient.  */
   bfd *abfd;
 
-  /* Pointer to the .debug_frame section loaded into memory.  */
+  /* Pointer to the .debug_frame or .eh_frame section being decoded,
+     loaded into memory.  */
   const gdb_byte *dwarf_frame_buffer = nullptr;
 
-  /* Length of the loaded .debug_frame section.  */
+  /* Length of the loaded section.  */
   bfd_size_type dwarf_frame_size = 0;
 
-  /* Pointer to the .debug_frame section.  */
+  /* Pointer to the section.  */
   asection *dwarf_frame_section = nullptr;
 
   /* Base for DW_EH_PE_datarel encodings.  */
@@ -167,8 +206,19 @@ struct comp_unit
   /* Base for DW_EH_PE_textrel encodings.  */
   bfd_vma tbase = 0;
 
-  /* The FDE table.  */
-  dwarf2_fde_table fde_table;
+  /* The .eh_frame and .debug_frame sections.  */
+  frame_section eh_frame;
+  frame_section debug_frame;
+
+  /* When the FDEs are looked up through the binary search table of the
+     .eh_frame_hdr section, the table, its number of entries, and the
+     address of the section its entries are relative to.  */
+  const gdb_byte *eh_frame_hdr_table = nullptr;
+  ULONGEST eh_frame_hdr_count = 0;
+  CORE_ADDR eh_frame_hdr_vma = 0;
+
+  /* Otherwise, the FDEs sorted by address.  */
+  std::vector<dwarf2_fde_index_entry> fde_index;
 
   /* Hold data used by this module.  */
   auto_obstack obstack;
@@ -889,8 +939,13 @@ struct dwarf2_frame_cache
   struct dwarf2_frame_fn_data *fn_data;
 };
 
+/* Return the DWARF frame cache of THIS_FRAME, computing it if
+   necessary.  If FIND_TAILCALLS, also look for the virtual tail call
+   frames that sit between THIS_FRAME and its caller.  */
+
 static struct dwarf2_frame_cache *
-dwarf2_frame_cache (frame_info_ptr this_frame, void **this_cache)
+dwarf2_frame_cache (frame_info_ptr this_frame, void **this_cache,
+		    bool find_tailcalls = true)
 {
   struct gdbarch *gdbarch = get_frame_arch (this_frame);
   const int num_regs = gdbarch_num_cooked_regs (gdbarch);
@@ -1112,9 +1167,10 @@ incomplete CFI data; unspecified registers (e.g., %s) at %s"),
       && fs.regs.reg[fs.retaddr_column].how == DWARF2_FRAME_REG_UNDEFINED)
     cache->undefined_retaddr = 1;
 
-  dwarf2_tailcall_sniffer_first (this_frame, &cache->tailcall_cache,
-				 (entry_cfa_sp_offset_p
-				  ? &entry_cfa_sp_offset : NULL));
+  if (find_tailcalls)
+    dwarf2_tailcall_sniffer_first (this_frame, &cache->tailcall_cache,
+				   (entry_cfa_sp_offset_p
+				    ? &entry_cfa_sp_offset : NULL));
 
   return cache;
 }
@@ -1302,6 +1358,58 @@ dwarf2_frame_dealloc_cache (frame_info *self, void *this_cache)
     dwarf2_tailcall_frame_unwind.dealloc_cache (self, cache->tailcall_cache);
 }
 
+/* See frame.h.  */
+
+bool
+dwarf2_frame_retain_cache (frame_info_ptr this_frame, void *this_cache)
+{
+  struct gdbarch *gdbarch = get_frame_arch (this_frame);
+  struct dwarf2_frame_cache *cache = (struct dwarf2_frame_cache *) this_cache;
+  const int num_regs = gdbarch_num_cooked_regs (gdbarch);
+
+  /* The virtual tail call frames are freed with the frame, and the
+     per-function data of the FN rules is allocated lazily.  */
+  if (cache->tailcall_cache != nullptr
+      || cache->fn_data != nullptr
+      || cache->unavailable_retaddr)
+    return false;
+
+  for (int regnum = -1; regnum < num_regs; regnum++)
+    {
+      const struct dwarf2_frame_state_reg &reg
+	= regnum < 0 ? cache->retaddr_reg : cache->reg[regnum];
+
+      switch (reg.how)
+	{
+	case DWARF2_FRAME_REG_UNSPECIFIED:
+	case DWARF2_FRAME_REG_UNDEFINED:
+	case DWARF2_FRAME_REG_SAVED_REG:
+	case DWARF2_FRAME_REG_SAME_VALUE:
+	case DWARF2_FRAME_REG_SAVED_VAL_OFFSET:
+	case DWARF2_FRAME_REG_RA:
+	case DWARF2_FRAME_REG_RA_OFFSET:
+	case DWARF2_FRAME_REG_CFA:
+	case DWARF2_FRAME_REG_CFA_OFFSET:
+	  break;
+
+	case DWARF2_FRAME_REG_SAVED_OFFSET:
+	  /* Only slots between the stack pointer and the CFA are
+	     checked for changes.  */
+	  if (!gdbarch_inner_than (gdbarch, cache->cfa + reg.loc.offset,
+				   cache->cfa))
+	    return false;
+	  break;
+
+	default:
+	  /* The location expressions may read any memory, and the
+	     functions may depend on anything.  */
+	  return false;
+	}
+    }
+
+  return true;
+}
+
 static int
 dwarf2_frame_sniffer (const struct frame_unwind *self,
 		      frame_info_ptr this_frame, void **this_cache)
@@ -1346,7 +1454,9 @@ static const struct frame_unwind dwarf2_frame_unwind =
   dwarf2_frame_prev_register,
   NULL,
   dwarf2_frame_sniffer,
-  dwarf2_frame_dealloc_cache
+  dwarf2_frame_dealloc_cache,
+  NULL,
+  dwarf2_frame_retain_cache
 };
 
 static const struct frame_unwind dwarf2_signal_frame_unwind =
@@ -1363,6 +1473,38 @@ static const struct frame_unwind dwarf2_signal_frame_unwind =
   NULL
 };
 
+/* See frame.h.  */
+
+bool
+dwarf2_frame_cfi_cache (frame_info_ptr this_frame, void **this_cache)
+{
+  if (*this_cache == nullptr)
+    {
+      if (!dwarf2_frame_unwinders_enabled_p)
+	return false;
+
+      CORE_ADDR block_addr = get_frame_address_in_block (this_frame);
+      if (dwarf2_frame_find_fde (&block_addr, NULL) == NULL)
+	return false;
+
+      dwarf2_frame_cache (this_frame, this_cache, false);
+    }
+
+  return true;
+}
+
+/* See frame.h.  */
+
+struct value *
+dwarf2_frame_prev_register_cfi (frame_info_ptr this_frame, void **this_cache,
+				int regnum)
+{
+  if (!dwarf2_frame_cfi_cache (this_frame, this_cache))
+    return nullptr;
+
+  return dwarf2_frame_prev_register (this_frame, this_cache, regnum);
+}
+
 /* Append the DWARF-2 frame unwinders to GDBARCH's list.  */
 
 void
@@ -1582,16 +1724,6 @@ find_cie (const dwarf2_cie_table &cie_table, ULONGEST cie_pointer)
   return NULL;
 }
 
-static inline int
-bsearch_fde_cmp (const dwarf2_fde *fde, unrelocated_addr seek_pc)
-{
-  if (fde->end_addr () <= seek_pc)
-    return -1;
-  if (fde->initial_location <= seek_pc)
-    return 0;
-  return 1;
-}
-
 /* Find an existing comp_unit for an objfile, if any.  */
 
 static comp_unit *
@@ -1617,53 +1749,6 @@ set_comp_unit (struct objfile *objfile, struct comp_unit *unit)
   return dwarf2_frame_bfd_data.set (abfd, unit);
 }
 
-/* Find the FDE for *PC.  Return a pointer to the FDE, and store the
-   initial location associated with it into *PC.  */
-
-static struct dwarf2_fde *
-dwarf2_frame_find_fde (CORE_ADDR *pc, dwarf2_per_objfile **out_per_objfile)
-{
-  for (objfile *objfile : current_program_space->objfiles ())
-    {
-      CORE_ADDR offset;
-
-      if (objfile->obfd == nullptr)
-	continue;
-
-      comp_unit *unit = find_comp_unit (objfile);
-      if (unit == NULL)
-	{
-	  dwarf2_build_frame_info (objfile);
-	  unit = find_comp_unit (objfile);
-	}
-      gdb_assert (unit != NULL);
-
-      dwarf2_fde_table *fde_table = &unit->fde_table;
-      if (fde_table->empty ())
-	continue;
-
-      gdb_assert (!objfile->section_offsets.empty ());
-      offset = objfile->text_section_offset ();
-
-      gdb_assert (!fde_table->empty ());
-      unrelocated_addr seek_pc = (unrelocated_addr) (*pc - offset);
-      if (seek_pc < (*fde_table)[0]->initial_location)
-	continue;
-
-      auto it = gdb::binary_search (fde_table->begin (), fde_table->end (),
-				    seek_pc, bsearch_fde_cmp);
-      if (it != fde_table->end ())
-	{
-	  *pc = (CORE_ADDR) (*it)->initial_location + offset;
-	  if (out_per_objfile != nullptr)
-	    *out_per_objfile = get_dwarf2_per_objfile (objfile);
-
-	  return *it;
-	}
-    }
-  return NULL;
-}
-
 /* Add FDE to FDE_TABLE.  */
 static void
 add_fde (dwarf2_fde_table *fde_table, struct dwarf2_fde *fde)
@@ -1993,6 +2078,7 @@ decode_frame_entry_1 (struct gdbarch *gdbarch,
       fde->end = end;
 
       fde->eh_frame_p = eh_frame_p;
+      fde->offset = start - unit->dwarf_frame_buffer;
 
       add_fde (fde_table, fde);
     }
@@ -2116,80 +2202,394 @@ fde_is_less_than (const dwarf2_fde *aa, const dwarf2_fde *bb)
   return aa->initial_location < bb->initial_location;
 }
 
-void
-dwarf2_build_frame_info (struct objfile *objfile)
+/* Make UNIT decode the entries of SECT.  */
+
+static void
+select_frame_section (comp_unit *unit, const frame_section &sect)
 {
-  const gdb_byte *frame_ptr;
-  dwarf2_cie_table cie_table;
-  dwarf2_fde_table fde_table;
+  unit->dwarf_frame_section = sect.section;
+  unit->dwarf_frame_buffer = sect.buffer;
+  unit->dwarf_frame_size = sect.size;
+}
 
-  struct gdbarch *gdbarch = objfile->arch ();
+/* Return the FDE at OFFSET in the .eh_frame section of UNIT if EH_FRAME_P,
+   in its .debug_frame section otherwise, decoding it if this wasn't
+   done yet.  Return NULL if there is no valid FDE there.  */
 
-  /* Build a minimal decoding of the DWARF2 compilation unit.  */
-  std::unique_ptr<comp_unit> unit (new comp_unit (objfile));
+static struct dwarf2_fde *
+decode_fde_at (struct gdbarch *gdbarch, comp_unit *unit, ULONGEST offset,
+	       bool eh_frame_p)
+{
+  frame_section &sect = eh_frame_p ? unit->eh_frame : unit->debug_frame;
+  auto iter = sect.fdes.find (offset);
+  if (iter != sect.fdes.end ())
+    return iter->second;
 
-  if (objfile->separate_debug_objfile_backlink == NULL)
+  struct dwarf2_fde *fde = nullptr;
+  if (offset < sect.size)
     {
-      /* Do not read .eh_frame from separate file as they must be also
-	 present in the main file.  */
-      dwarf2_get_section_info (objfile, DWARF2_EH_FRAME,
-			       &unit->dwarf_frame_section,
-			       &unit->dwarf_frame_buffer,
-			       &unit->dwarf_frame_size);
-      if (unit->dwarf_frame_size)
+      dwarf2_fde_table fdes;
+
+      select_frame_section (unit, sect);
+      try
 	{
-	  asection *got, *txt;
+	  decode_frame_entry (gdbarch, unit, sect.buffer + offset,
+			      eh_frame_p, sect.cies, &fdes, EH_FDE_TYPE_ID);
+	}
+      catch (const gdb_exception_error &e)
+	{
+	  complaint (_("Invalid FDE at offset %s in %s:%s: %s"),
+		     pulongest (offset), bfd_get_filename (unit->abfd),
+		     bfd_section_name (sect.section), e.what ());
+	}
 
-	  /* FIXME: kettenis/20030602: This is the DW_EH_PE_datarel base
-	     that is used for the i386/amd64 target, which currently is
-	     the only target in GCC that supports/uses the
-	     DW_EH_PE_datarel encoding.  */
-	  got = bfd_get_section_by_name (unit->abfd, ".got");
-	  if (got)
-	    unit->dbase = got->vma;
+      if (!fdes.empty ())
+	fde = fdes.back ();
+    }
 
-	  /* GCC emits the DW_EH_PE_textrel encoding type on sh and ia64
-	     so far.  */
-	  txt = bfd_get_section_by_name (unit->abfd, ".text");
-	  if (txt)
-	    unit->tbase = txt->vma;
+  sect.fdes[offset] = fde;
+  return fde;
+}
 
-	  try
-	    {
-	      frame_ptr = unit->dwarf_frame_buffer;
-	      while (frame_ptr < unit->dwarf_frame_buffer + unit->dwarf_frame_size)
-		frame_ptr = decode_frame_entry (gdbarch, unit.get (),
-						frame_ptr, 1,
-						cie_table, &fde_table,
-						EH_CIE_OR_FDE_TYPE_ID);
-	    }
+/* Return the number of bytes of a value encoded with ENCODING in the
+   .eh_frame_hdr section, -1 if this isn't a fixed size.  */
 
-	  catch (const gdb_exception_error &e)
-	    {
-	      warning (_("skipping .eh_frame info of %s: %s"),
-		       objfile_name (objfile), e.what ());
+static int
+eh_frame_hdr_value_size (gdb_byte encoding, int ptr_len)
+{
+  switch (encoding & 0x07)
+    {
+    case DW_EH_PE_absptr:
+      return ptr_len;
+    case DW_EH_PE_udata2:
+      return 2;
+    case DW_EH_PE_udata4:
+      return 4;
+    case DW_EH_PE_udata8:
+      return 8;
+    default:
+      return -1;
+    }
+}
 
-	      fde_table.clear ();
-	      /* The cie_table is discarded below.  */
-	    }
+/* Set UNIT up to find its FDEs through the binary search table of the
+   .eh_frame_hdr section of OBJFILE, which the linker creates along
+   with .eh_frame.  Return false if there is no such table, or if it
+   can't be used.  */
 
-	  cie_table.clear ();
+static bool
+read_eh_frame_hdr (struct objfile *objfile, comp_unit *unit)
+{
+  /* The entries of the table are relative to the address of the
+     section.  */
+  if (gdb_bfd_requires_relocations (unit->abfd))
+    return false;
+
+  asection *hdr = bfd_get_section_by_name (unit->abfd, ".eh_frame_hdr");
+  if (hdr == nullptr)
+    return false;
+
+  bfd_size_type size;
+  const gdb_byte *buf = gdb_bfd_map_section (hdr, &size);
+
+  /* The header holds the version, the encodings of the pointer to
+     .eh_frame, of the number of entries and of the table, then the
+     pointer and the number.  The table is only usable if its entries
+     have the fixed size of the usual encoding.  */
+  if (buf == nullptr || size < 4 || buf[0] != 1
+      || buf[2] != DW_EH_PE_udata4
+      || buf[3] != (DW_EH_PE_datarel | DW_EH_PE_sdata4))
+    return false;
+
+  int ptr_len = gdbarch_ptr_bit (objfile->arch ()) / TARGET_CHAR_BIT;
+  int eh_frame_ptr_size = eh_frame_hdr_value_size (buf[1], ptr_len);
+  if (eh_frame_ptr_size < 0 || size < 4 + eh_frame_ptr_size + 4)
+    return false;
+
+  const gdb_byte *table = buf + 4 + eh_frame_ptr_size + 4;
+  ULONGEST count = bfd_get_32 (unit->abfd, table - 4);
+  if (count == 0 || count > (buf + size - table) / 8)
+    return false;
+
+  unit->eh_frame_hdr_table = table;
+  unit->eh_frame_hdr_count = count;
+  unit->eh_frame_hdr_vma = bfd_section_vma (hdr);
+  return true;
+}
+
+/* Find the FDE covering SEEK_PC in the .eh_frame_hdr table of UNIT.  */
+
+static struct dwarf2_fde *
+find_fde_in_eh_frame_hdr (struct gdbarch *gdbarch, comp_unit *unit,
+			  unrelocated_addr seek_pc)
+{
+  const gdb_byte *table = unit->eh_frame_hdr_table;
+
+  /* Return the address stored at byte OFFSET of the table.  */
+  auto table_address = [&] (ULONGEST offset)
+    {
+      LONGEST delta = bfd_get_signed_32 (unit->abfd, table + offset);
+      return unit->eh_frame_hdr_vma + delta;
+    };
+
+  /* Find the last entry starting at or before SEEK_PC.  */
+  ULONGEST low = 0, high = unit->eh_frame_hdr_count;
+  while (low < high)
+    {
+      ULONGEST mid = low + (high - low) / 2;
+      unrelocated_addr location
+	= (unrelocated_addr) gdbarch_adjust_dwarf2_addr (gdbarch,
+							 table_address (8 * mid));
+      if (location <= seek_pc)
+	low = mid + 1;
+      else
+	high = mid;
+    }
+  if (low == 0)
+    return nullptr;
+
+  CORE_ADDR fde_addr = table_address (8 * (low - 1) + 4);
+  ULONGEST offset = fde_addr - bfd_section_vma (unit->eh_frame.section);
+  struct dwarf2_fde *fde = decode_fde_at (gdbarch, unit, offset, true);
+  if (fde == nullptr || seek_pc < fde->initial_location
+      || seek_pc >= fde->end_addr ())
+    return nullptr;
+
+  return fde;
+}
+
+/* Find the FDE covering SEEK_PC in the FDE index of UNIT.  */
+
+static struct dwarf2_fde *
+find_fde_in_index (struct gdbarch *gdbarch, comp_unit *unit,
+		   unrelocated_addr seek_pc)
+{
+  const std::vector<dwarf2_fde_index_entry> &index = unit->fde_index;
+  auto iter = std::upper_bound (index.begin (), index.end (), seek_pc,
+				[] (unrelocated_addr pc,
+				    const dwarf2_fde_index_entry &entry)
+				{
+				  return pc < entry.initial_location;
+				});
+  if (iter == index.begin ())
+    return nullptr;
+  --iter;
+
+  ULONGEST end = (ULONGEST) iter->initial_location + iter->address_range;
+  if ((ULONGEST) seek_pc >= end)
+    return nullptr;
+
+  return decode_fde_at (gdbarch, unit, iter->offset, iter->eh_frame_p);
+}
+
+/* Find the FDE for *PC.  Return a pointer to the FDE, and store the
+   initial location associated with it into *PC.  */
+
+static struct dwarf2_fde *
+dwarf2_frame_find_fde (CORE_ADDR *pc, dwarf2_per_objfile **out_per_objfile)
+{
+  for (objfile *objfile : current_program_space->objfiles ())
+    {
+      CORE_ADDR offset;
+
+      if (objfile->obfd == nullptr)
+	continue;
+
+      comp_unit *unit = find_comp_unit (objfile);
+      if (unit == NULL)
+	{
+	  dwarf2_build_frame_info (objfile);
+	  unit = find_comp_unit (objfile);
+	}
+      gdb_assert (unit != NULL);
+
+      if (unit->eh_frame_hdr_table == nullptr && unit->fde_index.empty ())
+	continue;
+
+      gdb_assert (!objfile->section_offsets.empty ());
+      offset = objfile->text_section_offset ();
+
+      struct gdbarch *gdbarch = objfile->arch ();
+      unrelocated_addr seek_pc = (unrelocated_addr) (*pc - offset);
+      struct dwarf2_fde *fde
+	= (unit->eh_frame_hdr_table != nullptr
+	   ? find_fde_in_eh_frame_hdr (gdbarch, unit, seek_pc)
+	   : find_fde_in_index (gdbarch, unit, seek_pc));
+      if (fde != nullptr)
+	{
+	  *pc = (CORE_ADDR) fde->initial_location + offset;
+	  if (out_per_objfile != nullptr)
+	    *out_per_objfile = get_dwarf2_per_objfile (objfile);
+
+	  return fde;
 	}
     }
+  return NULL;
+}
 
-  dwarf2_get_section_info (objfile, DWARF2_DEBUG_FRAME,
-			   &unit->dwarf_frame_section,
-			   &unit->dwarf_frame_buffer,
-			   &unit->dwarf_frame_size);
-  if (unit->dwarf_frame_size)
+/* The FDE index of an objfile, saved in the index cache so that it
+   needn't be built again when the objfile is loaded next time, starts
+   with this magic string and version number.  Then come the sizes of
+   the .eh_frame and .debug_frame sections it was built from, the number
+   of entries, and the entries.  All the numbers are 8-byte little-endian
+   values; the last one of each entry holds the offset of the FDE
+   shifted left by one, ORed with 1 if it is in .eh_frame.  */
+
+static const char fde_index_magic[] = "GDBFRAME";
+static const ULONGEST fde_index_version = 1;
+
+/* Return the build ID to save the FDE index of UNIT in the index cache
+   under, or NULL if it shouldn't be saved there.  */
+
+static const bfd_build_id *
+fde_index_cache_build_id (comp_unit *unit)
+{
+  if (!global_index_cache.enabled ()
+      || gdb_bfd_requires_relocations (unit->abfd))
+    return nullptr;
+
+  return build_id_bfd_get (unit->abfd);
+}
+
+/* Read the FDE index of UNIT from the index cache.  Return false if it
+   isn't there.  */
+
+static bool
+read_cached_fde_index (comp_unit *unit)
+{
+  const bfd_build_id *build_id = fde_index_cache_build_id (unit);
+  if (build_id == nullptr)
+    return false;
+
+  std::unique_ptr<index_cache_resource> resource;
+  gdb::array_view<const gdb_byte> contents
+    = global_index_cache.lookup_frame_index (build_id, &resource);
+
+  const size_t magic_len = sizeof (fde_index_magic) - 1;
+  const size_t header_len = magic_len + 4 * 8;
+  if (contents.size () < header_len
+      || memcmp (contents.data (), fde_index_magic, magic_len) != 0)
+    return false;
+
+  const gdb_byte *p = contents.data () + magic_len;
+  auto read_value = [&] ()
+    {
+      ULONGEST value = extract_unsigned_integer (p, 8, BFD_ENDIAN_LITTLE);
+      p += 8;
+      return value;
+    };
+
+  if (read_value () != fde_index_version
+      || read_value () != unit->eh_frame.size
+      || read_value () != unit->debug_frame.size)
+    return false;
+
+  ULONGEST count = read_value ();
+  if (count != (contents.size () - header_len) / 24
+      || contents.size () != header_len + count * 24)
+    return false;
+
+  unit->fde_index.reserve (count);
+  for (ULONGEST i = 0; i < count; ++i)
+    {
+      unrelocated_addr initial_location = (unrelocated_addr) read_value ();
+      ULONGEST address_range = read_value ();
+      ULONGEST location = read_value ();
+      unit->fde_index.push_back ({initial_location, address_range,
+				  location >> 1, (location & 1) != 0});
+    }
+
+  return true;
+}
+
+/* Save the FDE index of UNIT in the index cache.  */
+
+static void
+write_cached_fde_index (comp_unit *unit)
+{
+  const bfd_build_id *build_id = fde_index_cache_build_id (unit);
+  if (build_id == nullptr)
+    return;
+
+  const size_t magic_len = sizeof (fde_index_magic) - 1;
+  gdb::byte_vector contents (magic_len + 4 * 8
+			     + unit->fde_index.size () * 24);
+  memcpy (contents.data (), fde_index_magic, magic_len);
+
+  gdb_byte *p = contents.data () + magic_len;
+  auto write_value = [&] (ULONGEST value)
+    {
+      store_unsigned_integer (p, 8, BFD_ENDIAN_LITTLE, value);
+      p += 8;
+    };
+
+  write_value (fde_index_version);
+  write_value (unit->eh_frame.size);
+  write_value (unit->debug_frame.size);
+  write_value (unit->fde_index.size ());
+  for (const dwarf2_fde_index_entry &entry : unit->fde_index)
+    {
+      write_value ((ULONGEST) entry.initial_location);
+      write_value (entry.address_range);
+      write_value ((entry.offset << 1) | entry.eh_frame_p);
+    }
+
+  global_index_cache.store_frame_index (build_id, contents);
+}
+
+/* Build the FDE index of UNIT by decoding all the CIEs and FDEs of its
+   sections.  The entries are decoded again when they are needed, so
+   the result of this decoding is thrown away.  */
+
+static void
+build_fde_index (struct objfile *objfile, comp_unit *unit)
+{
+  const gdb_byte *frame_ptr;
+  dwarf2_cie_table cie_table;
+  dwarf2_fde_table fde_table;
+
+  struct gdbarch *gdbarch = objfile->arch ();
+
+  /* A scratch unit to decode the entries in.  */
+  comp_unit scratch (objfile);
+  scratch.dbase = unit->dbase;
+  scratch.tbase = unit->tbase;
+
+  if (unit->eh_frame.size)
+    {
+      select_frame_section (&scratch, unit->eh_frame);
+      try
+	{
+	  frame_ptr = scratch.dwarf_frame_buffer;
+	  while (frame_ptr < scratch.dwarf_frame_buffer + scratch.dwarf_frame_size)
+	    frame_ptr = decode_frame_entry (gdbarch, &scratch,
+					    frame_ptr, 1,
+					    cie_table, &fde_table,
+					    EH_CIE_OR_FDE_TYPE_ID);
+	}
+
+      catch (const gdb_exception_error &e)
+	{
+	  warning (_("skipping .eh_frame info of %s: %s"),
+		   objfile_name (objfile), e.what ());
+
+	  fde_table.clear ();
+	  /* The cie_table is discarded below.  */
+	}
+
+      cie_table.clear ();
+    }
+
+  if (unit->debug_frame.size)
     {
       size_t num_old_fde_entries = fde_table.size ();
 
+      select_frame_section (&scratch, unit->debug_frame);
       try
 	{
-	  frame_ptr = unit->dwarf_frame_buffer;
-	  while (frame_ptr < unit->dwarf_frame_buffer + unit->dwarf_frame_size)
-	    frame_ptr = decode_frame_entry (gdbarch, unit.get (), frame_ptr, 0,
+	  frame_ptr = scratch.dwarf_frame_buffer;
+	  while (frame_ptr < scratch.dwarf_frame_buffer + scratch.dwarf_frame_size)
+	    frame_ptr = decode_frame_entry (gdbarch, &scratch, frame_ptr, 0,
 					    cie_table, &fde_table,
 					    EH_CIE_OR_FDE_TYPE_ID);
 	}
@@ -2243,14 +2643,80 @@ dwarf2_build_frame_info (struct objfile *objfile)
 	  && fde_prev->initial_location == fde->initial_location)
 	continue;
 
-      unit->fde_table.push_back (fde);
+      unit->fde_index.push_back ({fde->initial_location, fde->address_range,
+				  fde->offset, fde->eh_frame_p != 0});
       fde_prev = fde;
     }
-  unit->fde_table.shrink_to_fit ();
+  unit->fde_index.shrink_to_fit ();
+}
+
+void
+dwarf2_build_frame_info (struct objfile *objfile)
+{
+  /* Build a minimal decoding of the DWARF2 compilation unit.  */
+  std::unique_ptr<comp_unit> unit (new comp_unit (objfile));
+
+  if (objfile->separate_debug_objfile_backlink == NULL)
+    {
+      /* Do not read .eh_frame from separate file as they must be also
+	 present in the main file.  */
+      dwarf2_get_section_info (objfile, DWARF2_EH_FRAME,
+			       &unit->eh_frame.section,
+			       &unit->eh_frame.buffer,
+			       &unit->eh_frame.size);
+      if (unit->eh_frame.size)
+	{
+	  asection *got, *txt;
+
+	  /* FIXME: kettenis/20030602: This is the DW_EH_PE_datarel base
+	     that is used for the i386/amd64 target, which currently is
+	     the only target in GCC that supports/uses the
+	     DW_EH_PE_datarel encoding.  */
+	  got = bfd_get_section_by_name (unit->abfd, ".got");
+	  if (got)
+	    unit->dbase = got->vma;
+
+	  /* GCC emits the DW_EH_PE_textrel encoding type on sh and ia64
+	     so far.  */
+	  txt = bfd_get_section_by_name (unit->abfd, ".text");
+	  if (txt)
+	    unit->tbase = txt->vma;
+	}
+    }
+
+  dwarf2_get_section_info (objfile, DWARF2_DEBUG_FRAME,
+			   &unit->debug_frame.section,
+			   &unit->debug_frame.buffer,
+			   &unit->debug_frame.size);
+
+  /* Decoding all the entries of a large library takes time, so only
+     decode the FDEs that are needed.  When there is no .debug_frame to
+     merge with .eh_frame, the table of .eh_frame_hdr is enough to find
+     them.  Otherwise an index of all the FDEs is needed; save it in the
+     index cache, if enabled, so it needs to be built only once.  */
+  bool use_eh_frame_hdr = (unit->eh_frame.size != 0
+			   && unit->debug_frame.size == 0
+			   && read_eh_frame_hdr (objfile, unit.get ()));
+  if (!use_eh_frame_hdr && !read_cached_fde_index (unit.get ()))
+    {
+      build_fde_index (objfile, unit.get ());
+      if (!unit->fde_index.empty ())
+	write_cached_fde_index (unit.get ());
+    }
 
   set_comp_unit (objfile, unit.release ());
 }
 
+/* Frames retained across stops keep the unwinder they were found with,
+   so forget them when the unwinders are turned on or off.  */
+
+static void
+set_dwarf_unwinders_enabled_p (const char *args, int from_tty,
+			       struct cmd_list_element *c)
+{
+  discard_retained_frames ();
+}
+
 /* Handle 'maintenance show dwarf unwinders'.  */
 
 static void
@@ -2274,7 +2740,7 @@ Show whether the DWARF stack frame unwinders are used."), _("\
 When enabled the DWARF stack frame unwinders can be used for architectures\n\
 that support the DWARF unwinders.  Enabling the DWARF unwinders for an\n\
 architecture that doesn't support them will have no effect."),
-			   NULL,
+			   set_dwarf_unwinders_enabled_p,
 			   show_dwarf_unwinders_enabled_p,
 			   &set_dwarf_cmdlist,
 			   &show_dwarf_cmdlist);
@@ -242,6 +242,29 @@ extern const struct frame_base *
 
 CORE_ADDR dwarf2_frame_cfa (frame_info_ptr this_frame);
 
+/* Return the value of register REGNUM in the caller of THIS_FRAME, as
+   described by the DWARF CFI that covers THIS_FRAME, or NULL if there
+   is no such CFI.  This is for unwinders that only track some of the
+   registers themselves.  *THIS_CACHE holds the DWARF frame state; it
+   must be NULL the first time this is called for THIS_FRAME.  Virtual
+   tail call frames are not taken into account.  */
+
+extern struct value *dwarf2_frame_prev_register_cfi
+  (frame_info_ptr this_frame, void **this_cache, int regnum);
+
+/* Compute the DWARF frame state *THIS_CACHE used by
+   dwarf2_frame_prev_register_cfi for THIS_FRAME, if not done already.
+   Return false if there is no CFI covering THIS_FRAME.  */
+
+extern bool dwarf2_frame_cfi_cache (frame_info_ptr this_frame,
+				    void **this_cache);
+
+/* Return true if THIS_CACHE, the DWARF frame state of THIS_FRAME, may
+   be kept across stops of the thread.  See frame_retain_ftype.  */
+
+extern bool dwarf2_frame_retain_cache (frame_info_ptr this_frame,
+				       void *this_cache);
+
 /* Find the CFA information for PC.
 
    Return 1 if a register is used for the CFA, or 0 if another
@@ -155,6 +155,66 @@ index_cache::store (dwarf2_per_bfd *per_bfd)
       index_cache_debug ("couldn't store index cache for objfile %s: %s",
 			 bfd_get_filename (per_bfd->obfd), except.what ());
     }
+
+  /* Also save the cooked index itself, if there is one, so that it can
+     be used as-is the next time this objfile is loaded.  */
+  if (per_bfd->index_table == nullptr
+      || per_bfd->index_table->index_for_writing () == nullptr)
+    return;
+
+  try
+    {
+      index_cache_debug ("writing cooked index cache for objfile %s",
+			 bfd_get_filename (per_bfd->obfd));
+
+      write_cooked_index_file (per_bfd, m_dir.c_str (),
+			       build_id_str.c_str ());
+    }
+  catch (const gdb_exception_error &except)
+    {
+      index_cache_debug ("couldn't store cooked index cache for objfile %s: %s",
+			 bfd_get_filename (per_bfd->obfd), except.what ());
+    }
+}
+
+/* See dwarf-index-cache.h.  */
+
+void
+index_cache::store_frame_index (const bfd_build_id *build_id,
+				gdb::array_view<const gdb_byte> contents)
+{
+  if (!enabled ())
+    return;
+
+  if (m_dir.empty ())
+    {
+      warning (_("The index cache directory name is empty, skipping store."));
+      return;
+    }
+
+  std::string build_id_str = build_id_to_string (build_id);
+
+  try
+    {
+      /* Try to create the containing directory.  */
+      if (!mkdir_recursive (m_dir.c_str ()))
+	{
+	  warning (_("index cache: could not make cache directory: %s"),
+		   safe_strerror (errno));
+	  return;
+	}
+
+      index_cache_debug ("writing frame index cache for build id %s",
+			 build_id_str.c_str ());
+
+      write_frame_index_file (m_dir.c_str (), build_id_str.c_str (),
+			      contents);
+    }
+  catch (const gdb_exception_error &except)
+    {
+      index_cache_debug ("couldn't store frame index cache for build id "
+			 "%s: %s", build_id_str.c_str (), except.what ());
+    }
 }
 
 #if HAVE_SYS_MMAN_H
@@ -175,8 +235,9 @@ struct index_cache_resource_mmap final : public index_cache_resource
 /* See dwarf-index-cache.h.  */
 
 gdb::array_view<const gdb_byte>
-index_cache::lookup_gdb_index (const bfd_build_id *build_id,
-			       std::unique_ptr<index_cache_resource> *resource)
+index_cache::lookup_index_file (const bfd_build_id *build_id,
+				const char *suffix,
+				std::unique_ptr<index_cache_resource> *resource)
 {
   if (!enabled ())
     return {};
@@ -188,8 +249,8 @@ index_cache::lookup_gdb_index (const bfd_build_id *build_id,
       return {};
     }
 
-  /* Compute where we would expect a gdb index file for this build id to be.  */
-  std::string filename = make_index_filename (build_id, INDEX4_SUFFIX);
+  /* Compute where we would expect an index file for this build id to be.  */
+  std::string filename = make_index_filename (build_id, suffix);
 
   try
     {
@@ -221,8 +282,9 @@ index_cache::lookup_gdb_index (const bfd_build_id *build_id,
 /* See dwarf-index-cache.h.  This is a no-op on unsupported systems.  */
 
 gdb::array_view<const gdb_byte>
-index_cache::lookup_gdb_index (const bfd_build_id *build_id,
-			       std::unique_ptr<index_cache_resource> *resource)
+index_cache::lookup_index_file (const bfd_build_id *build_id,
+				const char *suffix,
+				std::unique_ptr<index_cache_resource> *resource)
 {
   return {};
 }
@@ -231,6 +293,35 @@ index_cache::lookup_gdb_index (const bfd_build_id *build_id,
 
 /* See dwarf-index-cache.h.  */
 
+gdb::array_view<const gdb_byte>
+index_cache::lookup_gdb_index (const bfd_build_id *build_id,
+			       std::unique_ptr<index_cache_resource> *resource)
+{
+  return lookup_index_file (build_id, INDEX4_SUFFIX, resource);
+}
+
+/* See dwarf-index-cache.h.  */
+
+gdb::array_view<const gdb_byte>
+index_cache::lookup_cooked_index
+  (const bfd_build_id *build_id,
+   std::unique_ptr<index_cache_resource> *resource)
+{
+  return lookup_index_file (build_id, COOKED_INDEX_SUFFIX, resource);
+}
+
+/* See dwarf-index-cache.h.  */
+
+gdb::array_view<const gdb_byte>
+index_cache::lookup_frame_index
+  (const bfd_build_id *build_id,
+   std::unique_ptr<index_cache_resource> *resource)
+{
+  return lookup_index_file (build_id, FRAME_INDEX_SUFFIX, resource);
+}
+
+/* See dwarf-index-cache.h.  */
+
 std::string
 index_cache::make_index_filename (const bfd_build_id *build_id,
 				  const char *suffix) const
@@ -67,6 +67,24 @@ class index_cache
   lookup_gdb_index (const bfd_build_id *build_id,
 		    std::unique_ptr<index_cache_resource> *resource);
 
+  /* Likewise, but look for a saved cooked index, as written by
+     write_cooked_index_file.  */
+  gdb::array_view<const gdb_byte>
+  lookup_cooked_index (const bfd_build_id *build_id,
+		       std::unique_ptr<index_cache_resource> *resource);
+
+  /* Store CONTENTS in the cache as the index of the call frame
+     information of the object file with build id BUILD_ID, see
+     dwarf2/frame.c.  */
+  void store_frame_index (const bfd_build_id *build_id,
+			  gdb::array_view<const gdb_byte> contents);
+
+  /* Likewise, but look for a saved index of the call frame
+     information, as written by store_frame_index.  */
+  gdb::array_view<const gdb_byte>
+  lookup_frame_index (const bfd_build_id *build_id,
+		      std::unique_ptr<index_cache_resource> *resource);
+
   /* Return the number of cache hits.  */
   unsigned int n_hits () const
   { return m_n_hits; }
@@ -91,6 +109,13 @@ class index_cache
 
 private:
 
+  /* Look for the index file with suffix SUFFIX matching BUILD_ID.  See
+     lookup_gdb_index for the meaning of RESOURCE and of the return
+     value.  */
+  gdb::array_view<const gdb_byte>
+  lookup_index_file (const bfd_build_id *build_id, const char *suffix,
+		     std::unique_ptr<index_cache_resource> *resource);
+
   /* Compute the absolute filename where the index of the objfile with build
      id BUILD_ID will be stored.  SUFFIX is appended at the end of the
      filename.  */
@@ -24,6 +24,8 @@
 #define INDEX4_SUFFIX ".gdb-index"
 #define INDEX5_SUFFIX ".debug_names"
 #define DEBUG_STR_SUFFIX ".debug_str"
+#define COOKED_INDEX_SUFFIX ".gdb-cooked"
+#define FRAME_INDEX_SUFFIX ".gdb-frame"
 
 /* All offsets in the index are of this type.  It must be
    architecture-independent.  */
@@ -38,6 +40,51 @@ gdb_index_unpack (const gdb_byte *value)
 						 BFD_ENDIAN_LITTLE);
 }
 
+/* The format of the cooked index files stored in the index cache.
+   These hold a finalized cooked index, so that it can be used without
+   scanning the DWARF again.  All integers are little-endian.
+
+   The file starts with a header made of the COOKED_INDEX_MAGIC bytes
+   followed by these offset_type values:
+
+     version		COOKED_INDEX_VERSION
+     n_units		the number of units
+     n_entries		the number of searchable entries
+     n_parents		the number of entries only used as a parent
+     n_ranges		the number of address ranges
+     strings_size	the size of the string pool
+
+   Then come the unit table, the entry table, the address range table
+   and the string pool, in this order and without any padding.
+
+   A unit is COOKED_INDEX_UNIT_SIZE bytes: its section offset (8), its
+   length (4), whether it is a type unit (1), whether it comes from the
+   dwz file (1), its unit type (1) and its language (1).  The units
+   must match the ones GDB finds in the objfile, in the same order.
+
+   An entry is COOKED_INDEX_ENTRY_SIZE bytes: its DIE offset (8), the
+   offsets of its name and canonical name in the string pool (4 + 4),
+   the index of its parent entry (4), the index of its unit (4), its
+   DWARF tag (2), its flags (1) and a padding byte.  The searchable
+   entries come first, sorted as cooked_index_shard::finalize would;
+   the parent-only entries follow them.
+
+   An address range is COOKED_INDEX_RANGE_SIZE bytes: its start
+   address (8), the index of its unit (4) and the number of the address
+   map it belongs to (4).  A range extends up to the next range of the
+   same map.  Where maps overlap, the lowest-numbered one wins.
+
+   Indices that refer to nothing are COOKED_INDEX_NONE.  */
+
+#define COOKED_INDEX_MAGIC "GDBCOOKD"
+#define COOKED_INDEX_MAGIC_SIZE 8
+#define COOKED_INDEX_VERSION 1
+#define COOKED_INDEX_HEADER_SIZE (COOKED_INDEX_MAGIC_SIZE + 6 * 4)
+#define COOKED_INDEX_UNIT_SIZE 16
+#define COOKED_INDEX_ENTRY_SIZE 28
+#define COOKED_INDEX_RANGE_SIZE 16
+#define COOKED_INDEX_NONE ((offset_type) -1)
+
 /* The hash function for strings in the mapped index.  This is the same as
    SYMBOL_HASH_NEXT, but we keep a separate copy to maintain control over the
    implementation.  This is necessary because the hash function is tied to the
@@ -28,6 +28,7 @@
 #include "gdbsupport/gdb_unlinker.h"
 #include "gdbsupport/pathstuff.h"
 #include "gdbsupport/scoped_fd.h"
+#include "gdbsupport/thread-pool.h"
 #include "complaints.h"
 #include "dwarf2/index-common.h"
 #include "dwarf2.h"
@@ -42,6 +43,7 @@
 #include <algorithm>
 #include <cmath>
 #include <forward_list>
+#include <limits>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
@@ -154,6 +156,12 @@ class data_buf
     ::file_write (file, m_vec);
   }
 
+  /* Discard the contents of the buffer.  */
+  void clear ()
+  {
+    m_vec.clear ();
+  }
+
 private:
   /* Grow SIZE bytes at the end of the buffer.  Returns a pointer to
      the start of the new block.  */
@@ -166,6 +174,54 @@ class data_buf
   gdb::byte_vector m_vec;
 };
 
+/* A data_buf that is written out to a file whenever enough data has
+   accumulated in it.  This lets tables of arbitrary size be written
+   using a bounded amount of memory.  Callers must call flush when
+   they are done appending.  */
+
+class streaming_data_buf : public data_buf
+{
+public:
+  explicit streaming_data_buf (FILE *file)
+    : m_file (file)
+  {
+  }
+
+  DISABLE_COPY_AND_ASSIGN (streaming_data_buf);
+
+  /* Write the buffered data to the file, if there is enough of it.
+     This should be called after each complete record is appended.  */
+  void maybe_flush ()
+  {
+    if (size () >= flush_threshold)
+      flush ();
+  }
+
+  /* Write all the buffered data to the file.  */
+  void flush ()
+  {
+    file_write (m_file);
+    m_flushed += size ();
+    clear ();
+  }
+
+  /* Return the total number of bytes appended to this buffer.  */
+  size_t total_size () const
+  {
+    return m_flushed + size ();
+  }
+
+private:
+  /* The amount of buffered data that triggers a write.  */
+  static constexpr size_t flush_threshold = 1024 * 1024;
+
+  /* The file being written.  */
+  FILE *m_file;
+
+  /* The number of bytes already written to M_FILE.  */
+  size_t m_flushed = 0;
+};
+
 /* An entry in the symbol table.  */
 struct symtab_index_entry
 {
@@ -364,12 +420,22 @@ class vector_hasher
   }
 };
 
-/* Write the mapped hash table SYMTAB to the data buffer OUTPUT, with
-   constant pool entries going into the data buffer CPOOL.  */
+/* Map each symbol name to its offset in the constant pool.  */
 
-static void
-write_hash_table (mapped_symtab *symtab, data_buf &output, data_buf &cpool)
+using str_offset_map
+  = std::unordered_map<c_str_view, offset_type, c_str_view_hasher>;
+
+/* Lay out the constant pool of the mapped hash table SYMTAB, without
+   writing anything.  The CU index vectors come first, to ensure
+   alignment is ok, followed by the symbol names.  This sets the
+   index_offset of each entry and records the offset of each name in
+   STR_TABLE.  Returns the size of the constant pool.  */
+
+static size_t
+layout_constant_pool (mapped_symtab *symtab, str_offset_map &str_table)
 {
+  size_t cpool_size = 0;
+
   {
     /* Elements are sorted vectors of the indices of all the CUs that
        hold an object of this name.  */
@@ -377,8 +443,6 @@ write_hash_table (mapped_symtab *symtab, data_buf &output, data_buf &cpool)
 		       vector_hasher<offset_type>>
       symbol_hash_table;
 
-    /* We add all the index vectors to the constant pool first, to
-       ensure alignment is ok.  */
     for (symtab_index_entry &entry : symtab->data)
       {
 	if (entry.name == NULL)
@@ -398,26 +462,44 @@ write_hash_table (mapped_symtab *symtab, data_buf &output, data_buf &cpool)
 	    continue;
 	  }
 
-	symbol_hash_table.emplace (entry.cu_indices, cpool.size ());
-	entry.index_offset = cpool.size ();
-	cpool.append_offset (entry.cu_indices.size ());
-	for (const auto index : entry.cu_indices)
-	  cpool.append_offset (index);
+	symbol_hash_table.emplace (entry.cu_indices, cpool_size);
+	entry.index_offset = cpool_size;
+	cpool_size += (entry.cu_indices.size () + 1) * sizeof (offset_type);
       }
   }
 
-  /* Now write out the hash table.  */
-  std::unordered_map<c_str_view, offset_type, c_str_view_hasher> str_table;
+  for (const symtab_index_entry &entry : symtab->data)
+    {
+      if (entry.name == NULL)
+	continue;
+
+      if (str_table.emplace (entry.name, cpool_size).second)
+	cpool_size += strlen (entry.name) + 1;
+    }
+
+  if (cpool_size > std::numeric_limits<offset_type>::max ())
+    error (_("Constant pool too large for the index"));
+
+  return cpool_size;
+}
+
+/* Write the mapped hash table SYMTAB to OUT_FILE.  The constant pool
+   must already have been laid out by layout_constant_pool, which
+   filled in STR_TABLE.  */
+
+static void
+write_hash_table (const mapped_symtab *symtab,
+		  const str_offset_map &str_table, FILE *out_file)
+{
+  streaming_data_buf output (out_file);
+
   for (const auto &entry : symtab->data)
     {
       offset_type str_off, vec_off;
 
       if (entry.name != NULL)
 	{
-	  const auto insertpair = str_table.emplace (entry.name, cpool.size ());
-	  if (insertpair.second)
-	    cpool.append_cstr0 (entry.name);
-	  str_off = insertpair.first->second;
+	  str_off = str_table.at (entry.name);
 	  vec_off = entry.index_offset;
 	}
       else
@@ -430,7 +512,45 @@ write_hash_table (mapped_symtab *symtab, data_buf &output, data_buf &cpool)
 
       output.append_offset (str_off);
       output.append_offset (vec_off);
+      output.maybe_flush ();
+    }
+
+  output.flush ();
+}
+
+/* Write the constant pool of the mapped hash table SYMTAB to OUT_FILE,
+   following the layout computed by layout_constant_pool.  Shared
+   vectors and names are only written at their first occurrence, which
+   is recognized by its offset being the current end of the pool.  */
+
+static void
+write_constant_pool (const mapped_symtab *symtab,
+		     const str_offset_map &str_table, FILE *out_file)
+{
+  streaming_data_buf cpool (out_file);
+
+  for (const symtab_index_entry &entry : symtab->data)
+    {
+      if (entry.name == NULL || entry.index_offset != cpool.total_size ())
+	continue;
+
+      cpool.append_offset (entry.cu_indices.size ());
+      for (const auto index : entry.cu_indices)
+	cpool.append_offset (index);
+      cpool.maybe_flush ();
+    }
+
+  for (const symtab_index_entry &entry : symtab->data)
+    {
+      if (entry.name == NULL
+	  || str_table.at (entry.name) != cpool.total_size ())
+	continue;
+
+      cpool.append_cstr0 (entry.name);
+      cpool.maybe_flush ();
     }
+
+  cpool.flush ();
 }
 
 using cu_index_map
@@ -1072,19 +1192,33 @@ assert_file_size (FILE *file, size_t expected_size)
 }
 
 /* Write a gdb index file to OUT_FILE from all the sections passed as
-   arguments.  */
+   arguments.  SYMTAB may be NULL, in which case the symbol table and
+   constant pool are empty.
+
+   Only the (small) CU lists and address table are held in memory.
+   The symbol table and constant pool are streamed to OUT_FILE.  */
 
 static void
 write_gdbindex_1 (FILE *out_file,
 		  const data_buf &cu_list,
 		  const data_buf &types_cu_list,
 		  const data_buf &addr_vec,
-		  const data_buf &symtab_vec,
-		  const data_buf &constant_pool)
+		  mapped_symtab *symtab)
 {
+  /* The constant pool is laid out first, because the hash table
+     refers to it, but it is written last.  */
+  str_offset_map str_table;
+  size_t symtab_size = 0;
+  size_t constant_pool_size = 0;
+  if (symtab != nullptr)
+    {
+      constant_pool_size = layout_constant_pool (symtab, str_table);
+      symtab_size = symtab->data.size () * 2 * sizeof (offset_type);
+    }
+
   data_buf contents;
   const offset_type size_of_header = 6 * sizeof (offset_type);
-  offset_type total_len = size_of_header;
+  size_t total_len = size_of_header;
 
   /* The version number.  */
   contents.append_offset (8);
@@ -1103,11 +1237,13 @@ write_gdbindex_1 (FILE *out_file,
 
   /* The offset of the symbol table from the start of the file.  */
   contents.append_offset (total_len);
-  total_len += symtab_vec.size ();
+  total_len += symtab_size;
 
   /* The offset of the constant pool from the start of the file.  */
+  if (total_len > std::numeric_limits<offset_type>::max ())
+    error (_("Index too large"));
   contents.append_offset (total_len);
-  total_len += constant_pool.size ();
+  total_len += constant_pool_size;
 
   gdb_assert (contents.size () == size_of_header);
 
@@ -1115,8 +1251,11 @@ write_gdbindex_1 (FILE *out_file,
   cu_list.file_write (out_file);
   types_cu_list.file_write (out_file);
   addr_vec.file_write (out_file);
-  symtab_vec.file_write (out_file);
-  constant_pool.file_write (out_file);
+  if (symtab != nullptr)
+    {
+      write_hash_table (symtab, str_table, out_file);
+      write_constant_pool (symtab, str_table, out_file);
+    }
 
   assert_file_size (out_file, total_len);
 }
@@ -1264,17 +1403,14 @@ write_gdbindex (dwarf2_per_bfd *per_bfd, cooked_index *table,
      lists.  */
   symtab.minimize ();
 
-  data_buf symtab_vec, constant_pool;
   if (symtab.n_elements == 0)
     symtab.data.resize (0);
 
-  write_hash_table (&symtab, symtab_vec, constant_pool);
-
-  write_gdbindex_1(out_file, objfile_cu_list, types_cu_list, addr_vec,
-		   symtab_vec, constant_pool);
+  write_gdbindex_1 (out_file, objfile_cu_list, types_cu_list, addr_vec,
+		    &symtab);
 
   if (dwz_out_file != NULL)
-    write_gdbindex_1 (dwz_out_file, dwz_cu_list, {}, {}, {}, {});
+    write_gdbindex_1 (dwz_out_file, dwz_cu_list, {}, {}, nullptr);
   else
     gdb_assert (dwz_cu_list.empty ());
 }
@@ -1458,6 +1594,8 @@ write_dwarf_index (dwarf2_per_bfd *per_bfd, const char *dir,
   if (per_bfd->index_table == nullptr)
     error (_("No debugging symbols"));
   cooked_index *table = per_bfd->index_table->index_for_writing ();
+  if (table == nullptr)
+    error (_("Cannot use an index to create the index"));
 
   if (per_bfd->types.size () > 1)
     error (_("Cannot make an index when the file has multiple .debug_types sections"));
@@ -1491,6 +1629,225 @@ write_dwarf_index (dwarf2_per_bfd *per_bfd, const char *dir,
     dwz_index_wip->finalize ();
 }
 
+/* Return the offset of NAME in the string pool, laying it out at the
+   end of the pool if needed.  STRINGS_SIZE is the current size of the
+   pool.  STRING_OFFSETS maps the names already in the pool to their
+   offset.  Names are looked up by address, as most of them point into
+   .debug_str, which the linker normally unique-ifies.  */
+
+static offset_type
+cooked_index_string_offset
+  (size_t &strings_size,
+   std::unordered_map<const char *, offset_type> &string_offsets,
+   const char *name)
+{
+  auto insertpair = string_offsets.emplace (name, strings_size);
+  if (insertpair.second)
+    {
+      strings_size += strlen (name) + 1;
+      if (strings_size > COOKED_INDEX_NONE)
+	error (_("String pool too large for the cooked index file"));
+    }
+  return insertpair.first->second;
+}
+
+/* Append NAME to the string pool STRINGS if this is where
+   cooked_index_string_offset laid it out, that is, if this is its
+   first occurrence.  */
+
+static void
+cooked_index_write_string
+  (streaming_data_buf &strings,
+   const std::unordered_map<const char *, offset_type> &string_offsets,
+   const char *name)
+{
+  if (string_offsets.at (name) == strings.total_size ())
+    {
+      strings.append_cstr0 (name);
+      strings.maybe_flush ();
+    }
+}
+
+/* Write the cooked index TABLE of PER_BFD to OUT_FILE, in the format
+   described in index-common.h.  */
+
+static void
+write_cooked_index_contents (dwarf2_per_bfd *per_bfd, cooked_index *table,
+			     FILE *out_file)
+{
+  /* The index of each unit in the unit table.  */
+  std::unordered_map<const dwarf2_per_cu_data *, offset_type> unit_indices;
+  data_buf units;
+  for (const auto &per_cu : per_bfd->all_units)
+    {
+      unit_indices.emplace (per_cu.get (), unit_indices.size ());
+
+      units.append_uint (8, BFD_ENDIAN_LITTLE,
+			 to_underlying (per_cu->sect_off));
+      units.append_offset (per_cu->length ());
+      units.append_uint (1, BFD_ENDIAN_LITTLE, per_cu->is_debug_types);
+      units.append_uint (1, BFD_ENDIAN_LITTLE, per_cu->is_dwz);
+      units.append_uint (1, BFD_ENDIAN_LITTLE, per_cu->unit_type (false));
+      units.append_uint (1, BFD_ENDIAN_LITTLE, per_cu->lang (false));
+    }
+
+  /* The shards are only sorted individually, while the file holds a
+     single sorted table.  */
+  std::vector<const cooked_index_entry *> entries;
+  for (const cooked_index_entry *entry : table->all_entries ())
+    entries.push_back (entry);
+  std::stable_sort (entries.begin (), entries.end (),
+		    [] (const cooked_index_entry *a,
+			const cooked_index_entry *b)
+		    {
+		      return *a < *b;
+		    });
+  size_t n_searchable = entries.size ();
+
+  /* Number the entries.  Some parents, like the ones made up for
+     GNAT-encoded names, are not searchable; append them to the
+     table.  */
+  std::unordered_map<const cooked_index_entry *, offset_type> entry_indices;
+  for (const cooked_index_entry *entry : entries)
+    entry_indices.emplace (entry, entry_indices.size ());
+  for (size_t i = 0; i < entries.size (); ++i)
+    {
+      const cooked_index_entry *parent = entries[i]->parent_entry;
+      if (parent != nullptr
+	  && entry_indices.emplace (parent, entry_indices.size ()).second)
+	entries.push_back (parent);
+    }
+
+  if (entries.size () >= COOKED_INDEX_NONE)
+    error (_("Too many entries for the cooked index file"));
+
+  /* Lay out the string pool first, as its size is needed in the
+     header.  The entry table and the pool itself are then streamed to
+     the file.  */
+  size_t strings_size = 0;
+  std::unordered_map<const char *, offset_type> string_offsets;
+  for (const cooked_index_entry *entry : entries)
+    {
+      if (unit_indices.find (entry->per_cu) == unit_indices.end ())
+	error (_("Cannot cache an index entry of an unknown unit"));
+
+      cooked_index_string_offset (strings_size, string_offsets, entry->name);
+      cooked_index_string_offset (strings_size, string_offsets,
+				  entry->canonical);
+    }
+
+  data_buf ranges;
+  offset_type n_ranges = 0;
+  std::vector<const addrmap *> addrmaps = table->get_addrmaps ();
+  for (offset_type map = 0; map < addrmaps.size (); ++map)
+    {
+      if (addrmaps[map] == nullptr)
+	continue;
+
+      addrmaps[map]->foreach ([&] (CORE_ADDR start, const void *obj)
+	{
+	  offset_type unit = COOKED_INDEX_NONE;
+	  if (obj != nullptr)
+	    {
+	      auto unit_it
+		= unit_indices.find ((const dwarf2_per_cu_data *) obj);
+	      if (unit_it != unit_indices.end ())
+		unit = unit_it->second;
+	    }
+
+	  ranges.append_uint (8, BFD_ENDIAN_LITTLE, start);
+	  ranges.append_offset (unit);
+	  ranges.append_offset (map);
+	  ++n_ranges;
+	  return 0;
+	});
+    }
+
+  data_buf header;
+  header.append_array
+    (gdb::array_view<const gdb_byte> ((const gdb_byte *) COOKED_INDEX_MAGIC,
+				      COOKED_INDEX_MAGIC_SIZE));
+  header.append_offset (COOKED_INDEX_VERSION);
+  header.append_offset (per_bfd->all_units.size ());
+  header.append_offset (n_searchable);
+  header.append_offset (entries.size () - n_searchable);
+  header.append_offset (n_ranges);
+  header.append_offset (strings_size);
+  gdb_assert (header.size () == COOKED_INDEX_HEADER_SIZE);
+
+  header.file_write (out_file);
+  units.file_write (out_file);
+
+  streaming_data_buf entry_table (out_file);
+  for (const cooked_index_entry *entry : entries)
+    {
+      offset_type parent = COOKED_INDEX_NONE;
+      if (entry->parent_entry != nullptr)
+	parent = entry_indices.at (entry->parent_entry);
+
+      entry_table.append_uint (8, BFD_ENDIAN_LITTLE,
+			       to_underlying (entry->die_offset));
+      entry_table.append_offset (string_offsets.at (entry->name));
+      entry_table.append_offset (string_offsets.at (entry->canonical));
+      entry_table.append_offset (parent);
+      entry_table.append_offset (unit_indices.at (entry->per_cu));
+      entry_table.append_uint (2, BFD_ENDIAN_LITTLE, entry->tag);
+      entry_table.append_uint (1, BFD_ENDIAN_LITTLE, entry->flags.raw ());
+      entry_table.append_uint (1, BFD_ENDIAN_LITTLE, 0);
+      entry_table.maybe_flush ();
+    }
+  entry_table.flush ();
+
+  ranges.file_write (out_file);
+
+  streaming_data_buf strings (out_file);
+  for (const cooked_index_entry *entry : entries)
+    {
+      cooked_index_write_string (strings, string_offsets, entry->name);
+      cooked_index_write_string (strings, string_offsets, entry->canonical);
+    }
+  strings.flush ();
+  gdb_assert (strings.total_size () == strings_size);
+}
+
+/* See index-write.h.  */
+
+void
+write_cooked_index_file (dwarf2_per_bfd *per_bfd, const char *dir,
+			 const char *basename)
+{
+  if (per_bfd->index_table == nullptr)
+    error (_("No debugging symbols"));
+  cooked_index *table = per_bfd->index_table->index_for_writing ();
+  if (table == nullptr)
+    error (_("No cooked index"));
+
+  /* Units read from DWO files are created while indexing, and could
+     not be matched with the units of the objfile when reading the
+     file back.  */
+  if (per_bfd->dwo_files != nullptr
+      && htab_elements (per_bfd->dwo_files.get ()) != 0)
+    error (_("Cannot write a cooked index file when using split DWARF"));
+
+  /* Wait for finalization, as the canonical names are needed.  */
+  table->wait ();
+
+  index_wip_file index_wip (dir, basename, COOKED_INDEX_SUFFIX);
+  write_cooked_index_contents (per_bfd, table, index_wip.out_file.get ());
+  index_wip.finalize ();
+}
+
+/* See index-write.h.  */
+
+void
+write_frame_index_file (const char *dir, const char *basename,
+			gdb::array_view<const gdb_byte> contents)
+{
+  index_wip_file index_wip (dir, basename, FRAME_INDEX_SUFFIX);
+  file_write (index_wip.out_file.get (), contents.data (), contents.size ());
+  index_wip.finalize ();
+}
+
 /* Implementation of the `save gdb-index' command.
 
    Note that the .gdb_index file format used by this command is
@@ -1517,6 +1874,14 @@ save_gdb_index_command (const char *arg, int from_tty)
   if (!*arg)
     error (_("usage: save gdb-index [-dwarf-5] DIRECTORY"));
 
+  /* The name of the main program is needed when writing an index.
+     Compute it now, as this cannot be done from a worker thread.  */
+  main_name ();
+
+  /* Collect the objfiles to write, and finish reading their index
+     here, so that this can be interrupted.  Nothing may throw once
+     the first task has been posted.  */
+  std::vector<objfile *> objfiles;
   for (objfile *objfile : current_program_space->objfiles ())
     {
       /* If the objfile does not correspond to an actual file, skip it.  */
@@ -1524,29 +1889,54 @@ save_gdb_index_command (const char *arg, int from_tty)
 	continue;
 
       dwarf2_per_objfile *per_objfile = get_dwarf2_per_objfile (objfile);
+      if (per_objfile == NULL)
+	continue;
 
-      if (per_objfile != NULL)
-	{
-	  try
-	    {
-	      const char *basename = lbasename (objfile_name (objfile));
-	      const dwz_file *dwz = dwarf2_get_dwz_file (per_objfile->per_bfd);
-	      const char *dwz_basename = NULL;
+      dwarf_scanner_base *index = per_objfile->per_bfd->index_table.get ();
+      if (index != nullptr && index->index_for_writing () != nullptr)
+	index->index_for_writing ()->wait ();
 
-	      if (dwz != NULL)
-		dwz_basename = lbasename (dwz->filename ());
+      objfiles.push_back (objfile);
+    }
 
-	      write_dwarf_index (per_objfile->per_bfd, arg, basename,
-				 dwz_basename, index_kind);
-	    }
-	  catch (const gdb_exception_error &except)
-	    {
-	      exception_fprintf (gdb_stderr, except,
-				 _("Error while writing index for `%s': "),
-				 objfile_name (objfile));
-	    }
-	    }
+  /* Write the indices in parallel, each in a worker thread.  Each
+     task returns the text of the error it hit, or an empty string on
+     success.  */
+  std::vector<gdb::future<std::string>> results;
+  for (objfile *objfile : objfiles)
+    {
+      dwarf2_per_bfd *per_bfd = get_dwarf2_per_objfile (objfile)->per_bfd;
+      const char *basename = lbasename (objfile_name (objfile));
+      const dwz_file *dwz = dwarf2_get_dwz_file (per_bfd);
+      const char *dwz_basename = NULL;
 
+      if (dwz != NULL)
+	dwz_basename = lbasename (dwz->filename ());
+
+      std::function<std::string ()> task
+	= [=] ()
+	  {
+	    try
+	      {
+		write_dwarf_index (per_bfd, arg, basename, dwz_basename,
+				   index_kind);
+	      }
+	    catch (const gdb_exception_error &except)
+	      {
+		return std::string (except.what ());
+	      }
+	    return std::string ();
+	  };
+      results.push_back
+	(gdb::thread_pool::g_thread_pool->post_task (std::move (task)));
+    }
+
+  for (size_t i = 0; i < objfiles.size (); ++i)
+    {
+      std::string message = results[i].get ();
+      if (!message.empty ())
+	gdb_printf (gdb_stderr, _("Error while writing index for `%s': %s\n"),
+		    objfile_name (objfiles[i]), message.c_str ());
     }
 }
 
@@ -36,4 +36,20 @@ extern void write_dwarf_index
   (dwarf2_per_bfd *per_bfd, const char *dir, const char *basename,
    const char *dwz_basename, dw_index_kind index_kind);
 
+/* Save the cooked index of PER_BFD in the directory DIR, in a file
+   named BASENAME with COOKED_INDEX_SUFFIX appended.  This file can be
+   read back by dwarf2_read_cooked_index.  Throws an error if the index
+   cannot be saved.  */
+
+extern void write_cooked_index_file (dwarf2_per_bfd *per_bfd,
+				     const char *dir, const char *basename);
+
+/* Save CONTENTS, the index of the call frame information of an
+   objfile, in the directory DIR, in a file named BASENAME with
+   FRAME_INDEX_SUFFIX appended.  Throws an error if the file cannot be
+   saved.  */
+
+extern void write_frame_index_file (const char *dir, const char *basename,
+				    gdb::array_view<const gdb_byte> contents);
+
 #endif /* DWARF_INDEX_WRITE_H */
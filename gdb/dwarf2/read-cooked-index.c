@@ -0,0 +1,298 @@
+/* Reading code for saved cooked indexes
+
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "defs.h"
+#include "read-cooked-index.h"
+
+#include "cooked-index.h"
+#include "index-common.h"
+#include "objfiles.h"
+#include "read.h"
+
+/* The flags that can be found in a saved index entry.  */
+
+static constexpr cooked_index_flag all_cooked_index_flags
+  = (IS_MAIN | IS_STATIC | IS_ENUM_CLASS | IS_LINKAGE
+     | IS_TYPE_DECLARATION);
+
+/* A cursor over the contents of a saved cooked index.  All the reading
+   methods throw an error if reading goes past the end of the data.  */
+
+class cooked_index_reader
+{
+public:
+
+  explicit cooked_index_reader (gdb::array_view<const gdb_byte> contents)
+    : m_contents (contents)
+  {
+  }
+
+  /* Return the current offset.  */
+  size_t offset () const
+  { return m_offset; }
+
+  /* Return the LEN bytes at the current offset and skip them.  */
+  const gdb_byte *bytes (size_t len)
+  {
+    if (len > m_contents.size () - m_offset)
+      error (_("Cooked index is truncated"));
+    const gdb_byte *result = m_contents.data () + m_offset;
+    m_offset += len;
+    return result;
+  }
+
+  /* Read an unsigned integer of LEN bytes.  */
+  ULONGEST uint (int len)
+  {
+    return extract_unsigned_integer (bytes (len), len, BFD_ENDIAN_LITTLE);
+  }
+
+  /* Read an offset_type.  */
+  offset_type offset_value ()
+  { return uint (sizeof (offset_type)); }
+
+  /* Skip the COUNT records of SIZE bytes starting at the current
+     offset, and return a cursor over them.  */
+  cooked_index_reader table (offset_type count, size_t size)
+  {
+    if (count > (m_contents.size () - m_offset) / size)
+      error (_("Cooked index is truncated"));
+    size_t len = count * size;
+    cooked_index_reader result (m_contents.slice (m_offset, len));
+    m_offset += len;
+    return result;
+  }
+
+private:
+
+  gdb::array_view<const gdb_byte> m_contents;
+  size_t m_offset = 0;
+};
+
+/* An index entry, as read from a saved cooked index.  */
+
+struct saved_cooked_entry
+{
+  sect_offset die_offset;
+  const char *name;
+  const char *canonical;
+  offset_type parent;
+  dwarf2_per_cu_data *per_cu;
+  enum dwarf_tag tag;
+  cooked_index_flag flags;
+};
+
+/* See read-cooked-index.h.  */
+
+void
+dwarf2_read_cooked_index (dwarf2_per_objfile *per_objfile,
+			  gdb::array_view<const gdb_byte> contents)
+{
+  struct objfile *objfile = per_objfile->objfile;
+  dwarf2_per_bfd *per_bfd = per_objfile->per_bfd;
+
+  cooked_index_reader reader (contents);
+  if (memcmp (reader.bytes (COOKED_INDEX_MAGIC_SIZE), COOKED_INDEX_MAGIC,
+	      COOKED_INDEX_MAGIC_SIZE) != 0)
+    error (_("Not a cooked index"));
+  offset_type version = reader.offset_value ();
+  if (version != COOKED_INDEX_VERSION)
+    error (_("Unsupported cooked index version %u"), version);
+  offset_type n_units = reader.offset_value ();
+  offset_type n_entries = reader.offset_value ();
+  offset_type n_parents = reader.offset_value ();
+  offset_type n_ranges = reader.offset_value ();
+  offset_type strings_size = reader.offset_value ();
+  gdb_assert (reader.offset () == COOKED_INDEX_HEADER_SIZE);
+
+  cooked_index_reader units = reader.table (n_units, COOKED_INDEX_UNIT_SIZE);
+  if (n_parents > COOKED_INDEX_NONE - n_entries)
+    error (_("Too many entries in cooked index"));
+  cooked_index_reader entries
+    = reader.table (n_entries + n_parents, COOKED_INDEX_ENTRY_SIZE);
+  cooked_index_reader ranges = reader.table (n_ranges,
+					      COOKED_INDEX_RANGE_SIZE);
+  const char *strings = (const char *) reader.bytes (strings_size);
+  if (reader.offset () != contents.size ())
+    error (_("Trailing data in cooked index"));
+  /* This ensures that all the names are NUL-terminated.  */
+  if (strings_size == 0 || strings[strings_size - 1] != '\0')
+    error (_("Invalid string pool in cooked index"));
+
+  /* The units are compared with the ones found in the objfile, so that
+     an out-of-date index is not used.  */
+  per_bfd->map_info_sections (objfile);
+  create_all_units (per_objfile);
+  if (n_units != per_bfd->all_units.size ())
+    error (_("Cooked index does not match the objfile"));
+
+  std::vector<std::pair<dwarf_unit_type, enum language>> unit_langs;
+  unit_langs.reserve (n_units);
+  for (const auto &per_cu : per_bfd->all_units)
+    {
+      sect_offset sect_off = (sect_offset) units.uint (8);
+      offset_type length = units.offset_value ();
+      bool is_debug_types = units.uint (1) != 0;
+      bool is_dwz = units.uint (1) != 0;
+      dwarf_unit_type unit_type = (dwarf_unit_type) units.uint (1);
+      enum language lang = (enum language) units.uint (1);
+
+      if (sect_off != per_cu->sect_off
+	  || length != per_cu->length ()
+	  || is_debug_types != per_cu->is_debug_types
+	  || is_dwz != per_cu->is_dwz
+	  || lang >= nr_languages
+	  || (per_cu->unit_type (false) != 0
+	      && per_cu->unit_type (false) != unit_type)
+	  || (per_cu->lang (false) != language_unknown
+	      && per_cu->lang (false) != lang))
+	error (_("Cooked index does not match the objfile"));
+
+      unit_langs.emplace_back (unit_type, lang);
+    }
+
+  /* Decode and check all the entries before changing anything, so
+     that a bad index leaves the objfile as it was.  */
+  offset_type n_all_entries = n_entries + n_parents;
+  std::vector<saved_cooked_entry> saved_entries (n_all_entries);
+  for (saved_cooked_entry &entry : saved_entries)
+    {
+      entry.die_offset = (sect_offset) entries.uint (8);
+      offset_type name = entries.offset_value ();
+      offset_type canonical = entries.offset_value ();
+      entry.parent = entries.offset_value ();
+      offset_type unit = entries.offset_value ();
+      entry.tag = (enum dwarf_tag) entries.uint (2);
+      entry.flags = (cooked_index_flag_enum) entries.uint (1);
+      entries.uint (1);
+
+      if (name >= strings_size || canonical >= strings_size
+	  || unit >= n_units
+	  || (entry.parent != COOKED_INDEX_NONE
+	      && entry.parent >= n_all_entries)
+	  || (entry.flags & ~all_cooked_index_flags) != 0)
+	error (_("Invalid entry in cooked index"));
+
+      entry.name = strings + name;
+      entry.canonical = strings + canonical;
+      entry.per_cu = per_bfd->all_units[unit].get ();
+    }
+
+  /* A cycle of parents would make computing the full names loop
+     forever.  */
+  for (const saved_cooked_entry &entry : saved_entries)
+    {
+      offset_type depth = 0;
+      for (offset_type parent = entry.parent;
+	   parent != COOKED_INDEX_NONE;
+	   parent = saved_entries[parent].parent)
+	if (++depth > n_all_entries)
+	  error (_("Invalid entry in cooked index"));
+    }
+
+  addrmap_mutable mutable_map;
+  CORE_ADDR prev_start = 0;
+  offset_type prev_map = COOKED_INDEX_NONE;
+  dwarf2_per_cu_data *prev_per_cu = nullptr;
+  for (offset_type i = 0; i <= n_ranges; ++i)
+    {
+      CORE_ADDR start = 0;
+      offset_type map = COOKED_INDEX_NONE;
+      dwarf2_per_cu_data *per_cu = nullptr;
+      if (i < n_ranges)
+	{
+	  start = ranges.uint (8);
+	  offset_type unit = ranges.offset_value ();
+	  map = ranges.offset_value ();
+	  if (unit != COOKED_INDEX_NONE)
+	    {
+	      if (unit >= n_units)
+		error (_("Invalid address range in cooked index"));
+	      per_cu = per_bfd->all_units[unit].get ();
+	    }
+	  if (map == COOKED_INDEX_NONE
+	      || (prev_map != COOKED_INDEX_NONE
+		  && (map < prev_map
+		      || (map == prev_map && start <= prev_start))))
+	    error (_("Invalid address range in cooked index"));
+	}
+
+      /* The previous range extends up to this one, or to the end of the
+	 address space if it was the last one of its map.  Since the maps
+	 are processed in order, set_empty gives precedence to the
+	 lowest-numbered one, like cooked_index::lookup does.  */
+      if (prev_per_cu != nullptr)
+	mutable_map.set_empty (prev_start,
+			       map == prev_map ? start - 1 : (CORE_ADDR) -1,
+			       prev_per_cu);
+
+      prev_start = start;
+      prev_map = map;
+      prev_per_cu = per_cu;
+    }
+
+  /* Everything has been checked, so the index can now be
+     installed.  */
+  for (offset_type i = 0; i < n_units; ++i)
+    {
+      dwarf2_per_cu_data *per_cu = per_bfd->all_units[i].get ();
+      if (unit_langs[i].first != 0)
+	{
+	  per_cu->set_unit_type (unit_langs[i].first);
+	  if (unit_langs[i].second != language_unknown)
+	    per_cu->set_lang (unit_langs[i].second);
+	}
+    }
+
+  /* The entries are not queried in place: each one is still created
+     in the shard's obstack, and only the names point into the saved
+     file.  This avoids the DWARF scan and the sort, but not the cost
+     of building one entry per saved record.  */
+  std::unique_ptr<cooked_index_shard> shard (new cooked_index_shard);
+  std::vector<cooked_index_entry *> new_entries;
+  new_entries.reserve (n_all_entries);
+  for (offset_type i = 0; i < n_all_entries; ++i)
+    {
+      const saved_cooked_entry &entry = saved_entries[i];
+      new_entries.push_back (shard->add_cached (entry.die_offset, entry.tag,
+						entry.flags, entry.name,
+						entry.canonical, entry.per_cu,
+						i < n_entries));
+    }
+  for (offset_type i = 0; i < n_all_entries; ++i)
+    if (saved_entries[i].parent != COOKED_INDEX_NONE)
+      new_entries[i]->parent_entry = new_entries[saved_entries[i].parent];
+  shard->install_addrmap (&mutable_map);
+
+  cooked_index::vec_type indexes;
+  indexes.push_back (std::move (shard));
+  cooked_index *vec = new cooked_index (std::move (indexes));
+  per_bfd->index_table.reset (vec);
+  per_bfd->quick_file_names_table
+    = create_quick_file_names_table (per_bfd->all_units.size ());
+
+  /* See dwarf2_build_psymtabs_hard.  */
+  const cooked_index_entry *main_entry = vec->get_main ();
+  if (main_entry != nullptr)
+    {
+      enum language lang = main_entry->per_cu->lang ();
+      const char *full_name = main_entry->full_name (&per_bfd->obstack, true);
+      set_objfile_main_name (objfile, full_name, lang);
+    }
+}
@@ -0,0 +1,37 @@
+/* Reading code for saved cooked indexes
+
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef DWARF2_READ_COOKED_INDEX_H
+#define DWARF2_READ_COOKED_INDEX_H
+
+#include "gdbsupport/array-view.h"
+
+struct dwarf2_per_objfile;
+
+/* Install the cooked index saved in CONTENTS, as written by
+   write_cooked_index_file, as the index of PER_OBJFILE.  CONTENTS must
+   live as long as the per-BFD object.  Throws an error if CONTENTS is
+   malformed or does not describe the units of PER_OBJFILE; the units
+   may have been created by then, and must be cleared by the
+   caller.  */
+
+extern void dwarf2_read_cooked_index (dwarf2_per_objfile *per_objfile,
+				      gdb::array_view<const gdb_byte> contents);
+
+#endif /* DWARF2_READ_COOKED_INDEX_H */
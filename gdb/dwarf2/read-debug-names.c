@@ -26,6 +26,9 @@
 #include "mapped-index.h"
 #include "read.h"
 #include "stringify.h"
+#include "gdbsupport/gdb-safe-ctype.h"
+#include "gdbsupport/parallel-for.h"
+#include <atomic>
 
 /* A description of the mapped .debug_names.
    Uninitialized map has CU_COUNT 0.  */
@@ -63,9 +66,44 @@ struct mapped_debug_names final : public mapped_index_base
 
   std::unordered_map<ULONGEST, index_val> abbrev_map;
 
+  /* The result of checking a part of the name table, see
+     start_hash_check.  */
+  struct hash_check_result
+  {
+    /* Whether the names could all be read.  */
+    bool valid = true;
+
+    /* The hashes of the names whose lookup may miss a matching name
+       if it is done through the hash table.  */
+    std::vector<uint32_t> misses;
+  };
+
+  /* The tasks checking the name table, until their results are
+     collected into HASH_VALID and HASH_MISSES.  */
+  std::vector<gdb::future<hash_check_result>> hash_check_tasks;
+
+  /* Whether the hash table can be used at all.  */
+  bool hash_valid = false;
+
+  /* The sorted hashes of the names that must be looked up through the
+     name components instead of the hash table.  */
+  std::vector<uint32_t> hash_misses;
+
+  /* The number of lookups done through the hash table.  */
+  unsigned int hash_lookups = 0;
+
   const char *namei_to_name
     (uint32_t namei, dwarf2_per_objfile *per_objfile) const;
 
+  /* Start checking the name table in the background, for
+     hash_lookup_usable.  */
+  void start_hash_check (dwarf2_per_objfile *per_objfile);
+
+  /* Return true if the lookup of NAME, an identifier, can use the hash
+     table instead of the name components.  The first call waits for
+     the check started by start_hash_check.  */
+  bool hash_lookup_usable (gdb::string_view name);
+
   /* Implementation of the mapped_index_base virtual interface, for
      the name_components cache.  */
 
@@ -76,6 +114,13 @@ struct mapped_debug_names final : public mapped_index_base
   size_t symbol_name_count () const override
   { return this->name_count; }
 
+  /* The hash check tasks use this object and the string section.  */
+  void wait_completely () override
+  {
+    for (auto &task : hash_check_tasks)
+      task.wait ();
+  }
+
   quick_symbol_functions_up make_quick_functions () const override;
 };
 
@@ -83,6 +128,8 @@ struct dwarf2_debug_names_index : public dwarf2_base_index_functions
 {
   void dump (struct objfile *objfile) override;
 
+  void print_stats (struct objfile *objfile, bool print_bcache) override;
+
   void expand_matching_symbols
     (struct objfile *,
      const lookup_name_info &lookup_name,
@@ -519,6 +566,8 @@ dwarf2_read_debug_names (dwarf2_per_objfile *per_objfile)
 
   create_addrmap_from_aranges (per_objfile, &per_bfd->debug_aranges);
 
+  map->start_hash_check (per_objfile);
+
   per_bfd->index_table = std::move (map);
   per_bfd->quick_file_names_table =
     create_quick_file_names_table (per_bfd->all_units.size ());
@@ -601,6 +650,281 @@ mapped_debug_names::namei_to_name
   return read_indirect_string_at_offset (per_objfile, namei_string_offs);
 }
 
+/* Return true if NAME consists only of the characters of a C
+   identifier.  */
+
+static bool
+debug_names_identifier_p (gdb::string_view name)
+{
+  if (name.empty ())
+    return false;
+
+  for (char c : name)
+    if (!ISALNUM (c) && c != '_')
+      return false;
+
+  return true;
+}
+
+/* Call CALLBACK with the identifiers that a symbol name matcher could
+   match NAME, a name from the name table, against when ignoring a
+   decoration of NAME: the identifier before C++ parameter and template
+   lists, ABI tags or scope operators, and the names without the GNAT
+   encodings for suffixes, library-level subprograms and packages.  See
+   ada-lang.c:is_name_suffix.  A lookup of any other identifier can
+   only match NAME if it is equal to NAME modulo case.  */
+
+static void
+debug_names_name_bases (gdb::string_view name,
+			gdb::function_view<void (gdb::string_view)> callback)
+{
+  size_t len = 0;
+  while (len < name.size () && (ISALNUM (name[len]) || name[len] == '_'))
+    ++len;
+  if (len == 0)
+    return;
+  if (len < name.size ())
+    callback (name.substr (0, len));
+  name = name.substr (0, len);
+
+  if (startswith (name, "_ada_") && len > 5)
+    {
+      callback (name.substr (5));
+      debug_names_name_bases (name.substr (5), callback);
+    }
+
+  size_t under = name.find ("__", 1);
+  if (under != gdb::string_view::npos)
+    callback (name.substr (0, under));
+
+  /* Task bodies.  */
+  if (len > 3 && name.substr (len - 3) == "TKB")
+    callback (name.substr (0, len - 3));
+
+  /* "X", "Xb", "Xn", ... suffixes.  */
+  size_t x = name.rfind ('X');
+  if (x != gdb::string_view::npos && x > 0
+      && name.find_first_not_of ("bn", x + 1) == gdb::string_view::npos)
+    callback (name.substr (0, x));
+
+  /* "_E<digits>b" and "_E<digits>s" suffixes.  */
+  if (len > 3 && (name[len - 1] == 'b' || name[len - 1] == 's'))
+    {
+      size_t p = len - 2;
+      while (p > 0 && ISDIGIT (name[p]))
+	--p;
+      if (p < len - 2 && p > 1 && name[p] == 'E' && name[p - 1] == '_')
+	callback (name.substr (0, p - 1));
+    }
+}
+
+/* See mapped_debug_names.  */
+
+void
+mapped_debug_names::start_hash_check (dwarf2_per_objfile *per_objfile)
+{
+  if (bucket_count == 0)
+    return;
+
+  /* Read the string section now, the workers below must not.  */
+  dwarf2_section_info &str = per_objfile->per_bfd->str;
+  str.read (per_objfile->objfile);
+  if (str.buffer == nullptr)
+    return;
+
+  /* Each task checks a range of names.  It records the names that the
+     hash table lookup would miss: those whose hash is wrong or that
+     are not in the run of names starting at the index of their
+     bucket.  It also records the identifiers that could match a name
+     by ignoring some decoration, as that name is in the run of a
+     different bucket.  */
+  auto check = [this, &str] (uint32_t first, uint32_t last)
+    {
+      hash_check_result result;
+      auto add_miss = [&] (gdb::string_view name)
+	{
+	  result.misses.push_back (dwarf5_djb_hash (name));
+	};
+
+      for (uint32_t namei = first; namei < last; ++namei)
+	{
+	  const ULONGEST str_offs
+	    = extract_unsigned_integer ((name_table_string_offs_reordered
+					 + namei * offset_size),
+					offset_size, dwarf5_byte_order);
+	  if (str_offs >= str.size
+	      || memchr (str.buffer + str_offs, '\0',
+			 str.size - str_offs) == nullptr)
+	    {
+	      result.valid = false;
+	      break;
+	    }
+
+	  const char *name = (const char *) str.buffer + str_offs;
+	  if (*name == '\0')
+	    continue;
+
+	  const uint32_t hash
+	    = extract_unsigned_integer (reinterpret_cast<const gdb_byte *>
+					(hash_table_reordered + namei), 4,
+					dwarf5_byte_order);
+	  const uint32_t bucket = hash % bucket_count;
+	  const uint32_t bucket_start
+	    = extract_unsigned_integer (reinterpret_cast<const gdb_byte *>
+					(bucket_table_reordered + bucket), 4,
+					dwarf5_byte_order);
+	  bool in_run = (hash == dwarf5_djb_hash (name)
+			 && bucket_start != 0
+			 && bucket_start - 1 <= namei);
+	  if (in_run && bucket_start - 1 < namei)
+	    {
+	      const uint32_t prev_hash
+		= extract_unsigned_integer (reinterpret_cast<const gdb_byte *>
+					    (hash_table_reordered + namei - 1),
+					    4, dwarf5_byte_order);
+	      in_run = prev_hash % bucket_count == bucket;
+	    }
+	  if (!in_run)
+	    add_miss (name);
+
+	  debug_names_name_bases (name, add_miss);
+	}
+
+      return result;
+    };
+
+  size_t n_tasks = std::max<size_t> (1, (gdb::thread_pool::g_thread_pool
+					 ->thread_count ()));
+  uint32_t per_task = name_count / n_tasks + 1;
+  for (uint32_t first = 0; first < name_count; first += per_task)
+    {
+      uint32_t last = std::min (name_count, first + per_task);
+      hash_check_tasks.push_back
+	(gdb::thread_pool::g_thread_pool->post_task<hash_check_result>
+	 ([=] ()
+	  {
+	    return check (first, last);
+	  }));
+    }
+  hash_valid = true;
+}
+
+/* See mapped_debug_names.  */
+
+bool
+mapped_debug_names::hash_lookup_usable (gdb::string_view name)
+{
+  if (!hash_check_tasks.empty ())
+    {
+      for (auto &task : hash_check_tasks)
+	{
+	  hash_check_result result = task.get ();
+	  hash_valid &= result.valid;
+	  hash_misses.insert (hash_misses.end (), result.misses.begin (),
+			      result.misses.end ());
+	}
+      hash_check_tasks.clear ();
+
+      std::sort (hash_misses.begin (), hash_misses.end ());
+      hash_misses.erase (std::unique (hash_misses.begin (),
+				      hash_misses.end ()),
+			 hash_misses.end ());
+      hash_misses.shrink_to_fit ();
+    }
+
+  return (hash_valid
+	  && !std::binary_search (hash_misses.begin (), hash_misses.end (),
+				  dwarf5_djb_hash (name)));
+}
+
+/* Like dw2_expand_symtabs_matching_symbol, but when LOOKUP_NAME is a
+   full name that is an identifier and that hash_lookup_usable accepts,
+   find the matching names through the hash table of MAP rather than
+   through its name components.  This avoids sorting
+   every name in the index for sessions that only look up a few
+   symbols by name.  */
+
+static bool
+dw2_debug_names_matching_symbol
+  (mapped_debug_names &map,
+   const lookup_name_info &lookup_name,
+   gdb::function_view<expand_symtabs_symbol_matcher_ftype> symbol_matcher,
+   gdb::function_view<bool (offset_type)> match_callback,
+   dwarf2_per_objfile *per_objfile)
+{
+  if (lookup_name.match_type () != symbol_name_match_type::FULL
+      || lookup_name.completion_mode ()
+      || !debug_names_identifier_p (lookup_name.name ())
+      || !map.hash_lookup_usable (lookup_name.name ()))
+    return dw2_expand_symtabs_matching_symbol (map, lookup_name,
+					       symbol_matcher,
+					       match_callback, per_objfile);
+
+  lookup_name_info lookup_name_without_params
+    = lookup_name.make_ignore_params ();
+
+  std::vector<symbol_name_matcher_ftype *> matchers;
+  for (int i = 0; i < nr_languages; i++)
+    {
+      const language_defn *lang = language_def ((enum language) i);
+      symbol_name_matcher_ftype *name_matcher
+	= lang->get_symbol_name_matcher (lookup_name_without_params);
+      if (std::find (matchers.begin (), matchers.end (), name_matcher)
+	  == matchers.end ())
+	matchers.push_back (name_matcher);
+    }
+
+  /* The hash is case-insensitive, so this visits all the names that
+     are equal to LOOKUP_NAME modulo case.  hash_lookup_usable checked
+     that no other name can match.  Let the matchers of the languages
+     decide which of these really match, as
+     dw2_expand_symtabs_matching_symbol would.  */
+  ++map.hash_lookups;
+  std::string name = gdb::to_string (lookup_name.name ());
+  const uint32_t full_hash = dwarf5_djb_hash (name.c_str ());
+  const uint32_t bucket = full_hash % map.bucket_count;
+  uint32_t namei
+    = extract_unsigned_integer (reinterpret_cast<const gdb_byte *>
+				(map.bucket_table_reordered + bucket), 4,
+				map.dwarf5_byte_order);
+  if (namei == 0)
+    return true;
+
+  for (--namei; namei < map.name_count; ++namei)
+    {
+      const uint32_t namei_full_hash
+	= extract_unsigned_integer (reinterpret_cast<const gdb_byte *>
+				    (map.hash_table_reordered + namei), 4,
+				    map.dwarf5_byte_order);
+      if (namei_full_hash % map.bucket_count != bucket)
+	break;
+      if (namei_full_hash != full_hash)
+	continue;
+
+      const char *namei_string = map.namei_to_name (namei, per_objfile);
+      if (namei_string == nullptr
+	  || strcasecmp (namei_string, name.c_str ()) != 0)
+	continue;
+
+      bool matched = false;
+      for (symbol_name_matcher_ftype *name_matcher : matchers)
+	if (name_matcher (namei_string, lookup_name_without_params, nullptr))
+	  {
+	    matched = true;
+	    break;
+	  }
+
+      if (!matched
+	  || (symbol_matcher != nullptr && !symbol_matcher (namei_string)))
+	continue;
+
+      if (!match_callback (namei))
+	return false;
+    }
+
+  return true;
+}
+
 /* Find a slot in .debug_names for the object named NAME.  If NAME is
    found, return pointer to its pool data.  If NAME cannot be found,
    return NULL.  */
@@ -955,6 +1279,24 @@ dwarf2_debug_names_index::dump (struct objfile *objfile)
   gdb_printf (".debug_names: exists\n");
 }
 
+void
+dwarf2_debug_names_index::print_stats (struct objfile *objfile,
+				       bool print_bcache)
+{
+  dwarf2_base_index_functions::print_stats (objfile, print_bcache);
+  if (print_bcache)
+    return;
+
+  dwarf2_per_objfile *per_objfile = get_dwarf2_per_objfile (objfile);
+  mapped_debug_names &map
+    = *(gdb::checked_static_cast<mapped_debug_names *>
+	(per_objfile->per_bfd->index_table.get ()));
+  gdb_printf (_("  Number of .debug_names hash table lookups: %u\n"),
+	      map.hash_lookups);
+  gdb_printf (_("  Number of .debug_names name components: %zu\n"),
+	      map.name_components.size ());
+}
+
 void
 dwarf2_debug_names_index::expand_matching_symbols
   (struct objfile *objfile,
@@ -978,8 +1320,8 @@ dwarf2_debug_names_index::expand_matching_symbols
       return ordered_compare (symname, match_name) == 0;
     };
 
-  dw2_expand_symtabs_matching_symbol (map, name, matcher,
-				      [&] (offset_type namei)
+  dw2_debug_names_matching_symbol (map, name, matcher,
+				   [&] (offset_type namei)
     {
       /* The name was matched, now expand corresponding CUs that were
 	 marked.  */
@@ -1013,17 +1355,14 @@ dwarf2_debug_names_index::expand_symtabs_matching
   gdb_assert (lookup_name != nullptr || symbol_matcher == nullptr);
   if (lookup_name == nullptr)
     {
+      std::vector<dwarf2_per_cu_data *> units;
       for (dwarf2_per_cu_data *per_cu
 	     : all_units_range (per_objfile->per_bfd))
-	{
-	  QUIT;
+	units.push_back (per_cu);
 
-	  if (!dw2_expand_symtabs_matching_one (per_cu, per_objfile,
+      return dw2_expand_symtabs_matching_units (units, per_objfile,
 						file_matcher,
-						expansion_notify))
-	    return false;
-	}
-      return true;
+						expansion_notify);
     }
 
   mapped_debug_names &map
@@ -1031,9 +1370,9 @@ dwarf2_debug_names_index::expand_symtabs_matching
 	(per_objfile->per_bfd->index_table.get ()));
 
   bool result
-    = dw2_expand_symtabs_matching_symbol (map, *lookup_name,
-					  symbol_matcher,
-					  [&] (offset_type namei)
+    = dw2_debug_names_matching_symbol (map, *lookup_name,
+				       symbol_matcher,
+				       [&] (offset_type namei)
     {
       /* The name was matched, now expand corresponding CUs that were
 	 marked.  */
@@ -473,17 +473,14 @@ dwarf2_gdb_index::expand_symtabs_matching
   gdb_assert (lookup_name != nullptr || symbol_matcher == nullptr);
   if (lookup_name == nullptr)
     {
+      std::vector<dwarf2_per_cu_data *> units;
       for (dwarf2_per_cu_data *per_cu
 	     : all_units_range (per_objfile->per_bfd))
-	{
-	  QUIT;
+	units.push_back (per_cu);
 
-	  if (!dw2_expand_symtabs_matching_one (per_cu, per_objfile,
+      return dw2_expand_symtabs_matching_units (units, per_objfile,
 						file_matcher,
-						expansion_notify))
-	    return false;
-	}
-      return true;
+						expansion_notify);
     }
 
   mapped_gdb_index &index
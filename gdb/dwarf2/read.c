@@ -41,6 +41,7 @@
 #include "dwarf2/dwz.h"
 #include "dwarf2/macro.h"
 #include "dwarf2/die.h"
+#include "dwarf2/read-cooked-index.h"
 #include "dwarf2/read-debug-names.h"
 #include "dwarf2/read-gdb-index.h"
 #include "dwarf2/sect-names.h"
@@ -603,6 +604,10 @@ class cutu_reader : public die_reader_specs
      for dummy CUs.  */
   void keep ();
 
+  /* Release the new CU, transferring ownership to the caller instead
+     of putting it on the chain.  This cannot be done for dummy CUs.  */
+  std::unique_ptr<dwarf2_cu> release_cu ();
+
   /* Release the abbrev table, transferring ownership to the
      caller.  */
   abbrev_table_up release_abbrev_table ()
@@ -1050,14 +1055,18 @@ static void prepare_one_comp_unit (struct dwarf2_cu *cu,
 static struct type *set_die_type (struct die_info *, struct type *,
 				  struct dwarf2_cu *, bool = false);
 
-static void create_all_units (dwarf2_per_objfile *per_objfile);
-
 static void load_full_comp_unit (dwarf2_per_cu_data *per_cu,
 				 dwarf2_per_objfile *per_objfile,
 				 dwarf2_cu *existing_cu,
 				 bool skip_partial,
 				 enum language pretend_language);
 
+static void read_full_comp_unit_dies (cutu_reader *reader,
+				      enum language pretend_language);
+
+static std::unique_ptr<dwarf2_cu> read_full_comp_unit_detached
+  (dwarf2_per_cu_data *this_cu, dwarf2_per_objfile *per_objfile);
+
 static void process_full_comp_unit (dwarf2_cu *cu,
 				    enum language pretend_language);
 
@@ -1149,6 +1158,13 @@ static struct dwo_unit *lookup_dwo_unit_in_dwp
 
 static struct dwp_file *get_dwp_file (dwarf2_per_objfile *per_objfile);
 
+static void **lookup_dwo_file_slot (dwarf2_per_objfile *per_objfile,
+				    const char *dwo_name,
+				    const char *comp_dir);
+
+static void prefetch_dwo_file (dwarf2_per_objfile *per_objfile,
+			       const char *dwo_name, const char *comp_dir);
+
 static struct dwo_unit *lookup_dwo_comp_unit
   (dwarf2_cu *cu, const char *dwo_name, const char *comp_dir,
    ULONGEST signature);
@@ -1724,8 +1740,14 @@ load_cu (dwarf2_per_cu_data *per_cu, dwarf2_per_objfile *per_objfile,
   if (per_cu->is_debug_types)
     load_full_type_unit (per_cu, per_objfile);
   else
-    load_full_comp_unit (per_cu, per_objfile, per_objfile->get_cu (per_cu),
-			 skip_partial, language_minimal);
+    {
+      /* The DIEs may already have been read in by
+	 dw2_expand_symtabs_matching_units.  */
+      dwarf2_cu *existing_cu = per_objfile->get_cu (per_cu);
+      if (existing_cu == nullptr || existing_cu->dies == nullptr)
+	load_full_comp_unit (per_cu, per_objfile, existing_cu,
+			     skip_partial, language_minimal);
+    }
 
   dwarf2_cu *cu = per_objfile->get_cu (per_cu);
   if (cu == nullptr)
@@ -3047,6 +3069,170 @@ dw2_expand_symtabs_matching_one
   return true;
 }
 
+/* When true, dw2_expand_symtabs_matching_units reads the DIEs of the
+   units to expand on the worker threads before building their symtabs
+   on the main thread.  */
+
+static bool dwarf_parallel_expansion = true;
+
+static void
+show_dwarf_parallel_expansion (struct ui_file *file, int from_tty,
+			       struct cmd_list_element *c, const char *value)
+{
+  gdb_printf (file, _("Parallel reading of DWARF units during symtab "
+		      "expansion is %s.\n"),
+	      value);
+}
+
+/* The maximum amount of .debug_info, in bytes, whose DIEs
+   dw2_expand_symtabs_matching_units reads ahead of expansion in one go.
+   This bounds the memory used by DIEs that were read in but whose
+   symtab has not yet been built.  */
+
+static const size_t dwarf_expansion_batch_size = 64 * 1024 * 1024;
+
+/* The amount of .debug_info, in bytes, whose DIEs
+   dw2_expand_symtabs_matching_units reads ahead for its first batch.
+   The following batches are as large as all the units expanded so
+   far, up to dwarf_expansion_batch_size, so that not much is read in
+   vain when the expansion is stopped early by its notify callback,
+   e.g. after the first match.  */
+
+static const size_t dwarf_expansion_first_batch_size = 1024 * 1024;
+
+/* Read the DIEs of the units in UNITS that still need them, using the
+   thread pool.  The resulting CUs are stored in the corresponding
+   slots of RESULT; a slot is left empty if the unit does not need to
+   be read, is a dummy, or could not be read.  In the latter case the
+   error will be reported again when the unit is read in the usual
+   way.  */
+
+static void
+dw2_read_units_in_parallel
+  (gdb::array_view<dwarf2_per_cu_data * const> units,
+   dwarf2_per_objfile *per_objfile,
+   std::vector<std::unique_ptr<dwarf2_cu>> &result)
+{
+  result.clear ();
+  result.resize (units.size ());
+
+  /* Decide which units to read on the main thread, as the CU cache
+     may not be consulted concurrently with its modification.  */
+  std::vector<size_t> todo;
+  for (size_t i = 0; i < units.size (); ++i)
+    {
+      dwarf2_per_cu_data *per_cu = units[i];
+      if (!per_cu->is_debug_types
+	  && !per_objfile->symtab_set_p (per_cu)
+	  && per_objfile->get_cu (per_cu) == nullptr)
+	todo.push_back (i);
+    }
+
+  if (todo.size () < 2)
+    return;
+
+  /* Ensure that complaints are handled correctly.  */
+  complaint_interceptor complaint_handler;
+
+  using iter_type = decltype (todo.begin ());
+
+  auto task_size_ = [&] (iter_type iter)
+    {
+      return (size_t) units[*iter]->length ();
+    };
+  auto task_size = gdb::make_function_view (task_size_);
+
+  gdb::parallel_for_each (1, todo.begin (), todo.end (),
+			  [&] (iter_type iter, iter_type end)
+    {
+      for (; iter != end; ++iter)
+	{
+	  try
+	    {
+	      result[*iter]
+		= read_full_comp_unit_detached (units[*iter], per_objfile);
+	    }
+	  catch (const gdb_exception &except)
+	    {
+	      /* Leave it to the main thread to read this unit again and
+		 report the error.  */
+	    }
+	}
+    }, task_size);
+}
+
+/* See read.h.  */
+
+bool
+dw2_expand_symtabs_matching_units
+  (gdb::array_view<dwarf2_per_cu_data * const> units,
+   dwarf2_per_objfile *per_objfile,
+   gdb::function_view<expand_symtabs_file_matcher_ftype> file_matcher,
+   gdb::function_view<expand_symtabs_exp_notify_ftype> expansion_notify)
+{
+  /* Reading DIEs in parallel would interleave the DIE dumps, and is
+     pointless without worker threads.  */
+  bool parallel = (dwarf_parallel_expansion
+		   && dwarf_die_debug == 0
+		   && gdb::thread_pool::g_thread_pool->thread_count () > 0);
+
+  std::vector<dwarf2_per_cu_data *> batch;
+  std::vector<std::unique_ptr<dwarf2_cu>> prefetched;
+  size_t start = 0;
+  size_t batch_limit = dwarf_expansion_first_batch_size;
+  while (start < units.size ())
+    {
+      /* Gather the next batch of units that actually need expanding.  */
+      batch.clear ();
+      size_t batch_bytes = 0;
+      for (; start < units.size () && batch_bytes < batch_limit; ++start)
+	{
+	  dwarf2_per_cu_data *per_cu = units[start];
+	  if (file_matcher != nullptr && !per_cu->mark)
+	    continue;
+	  batch.push_back (per_cu);
+	  /* The length of type units is not known yet with
+	     .gdb_index, but they are not read ahead anyway.  */
+	  if (!per_cu->is_debug_types)
+	    batch_bytes += per_cu->length ();
+	}
+
+      if (parallel)
+	dw2_read_units_in_parallel (batch, per_objfile, prefetched);
+      else
+	prefetched.clear ();
+
+      for (size_t i = 0; i < batch.size (); ++i)
+	{
+	  QUIT;
+
+	  dwarf2_per_cu_data *per_cu = batch[i];
+
+	  /* Install the DIEs that were read ahead just before expanding
+	     the unit, as expansion frees the cached CUs when done.  */
+	  if (i < prefetched.size () && prefetched[i] != nullptr)
+	    {
+	      if (!per_objfile->symtab_set_p (per_cu)
+		  && per_objfile->get_cu (per_cu) == nullptr)
+		per_objfile->set_cu (per_cu, std::move (prefetched[i]));
+	      else
+		prefetched[i].reset ();
+	    }
+
+	  if (!dw2_expand_symtabs_matching_one (per_cu, per_objfile,
+						file_matcher,
+						expansion_notify))
+	    return false;
+	}
+
+      /* The whole batch was expanded, read ahead as much again.  */
+      batch_limit = std::min (batch_limit + batch_bytes,
+			      dwarf_expansion_batch_size);
+    }
+
+  return true;
+}
+
 /* See read.h.  */
 
 void
@@ -3374,6 +3560,43 @@ get_gdb_index_contents_from_cache_dwz (objfile *obj, dwz_file *dwz)
   return global_index_cache.lookup_gdb_index (build_id, &dwz->index_cache_res);
 }
 
+/* Try to read a saved cooked index for PER_OBJFILE from the index
+   cache.  Return true if it was found and installed.  */
+
+static bool
+dwarf2_read_cooked_index_from_cache (dwarf2_per_objfile *per_objfile)
+{
+  objfile *obj = per_objfile->objfile;
+  dwarf2_per_bfd *per_bfd = per_objfile->per_bfd;
+
+  const bfd_build_id *build_id = build_id_bfd_get (obj->obfd.get ());
+  if (build_id == nullptr)
+    return false;
+
+  std::unique_ptr<index_cache_resource> resource;
+  gdb::array_view<const gdb_byte> contents
+    = global_index_cache.lookup_cooked_index (build_id, &resource);
+  if (contents.empty ())
+    return false;
+
+  try
+    {
+      dwarf2_read_cooked_index (per_objfile, contents);
+    }
+  catch (const gdb_exception_error &except)
+    {
+      dwarf_read_debug_printf ("could not use cooked index from cache: %s",
+			       except.what ());
+      per_bfd->all_units.clear ();
+      per_bfd->signatured_types.reset ();
+      return false;
+    }
+
+  /* The entries point into the file contents.  */
+  per_bfd->index_cache_res = std::move (resource);
+  return true;
+}
+
 static quick_symbol_functions_up make_cooked_index_funcs ();
 
 /* See dwarf2/public.h.  */
@@ -3428,7 +3651,16 @@ dwarf2_initialize_objfile (struct objfile *objfile)
       return;
     }
 
-  /* ... otherwise, try to find the index in the index cache.  */
+  /* ... otherwise, try to find an index in the index cache, starting
+     with a saved cooked index, which can be used as-is.  */
+  if (dwarf2_read_cooked_index_from_cache (per_objfile))
+    {
+      dwarf_read_debug_printf ("found cooked index from cache");
+      global_index_cache.hit ();
+      objfile->qf.push_front (per_bfd->index_table->make_quick_functions ());
+      return;
+    }
+
   if (dwarf2_read_gdb_index (per_objfile,
 			     get_gdb_index_contents_from_cache,
 			     get_gdb_index_contents_from_cache_dwz))
@@ -4097,14 +4329,6 @@ lookup_dwo_id (struct dwarf2_cu *cu, struct die_info* comp_unit_die)
 static struct dwo_unit *
 lookup_dwo_unit (dwarf2_cu *cu, die_info *comp_unit_die, const char *dwo_name)
 {
-#if CXX_STD_THREAD
-  /* We need a lock here both to handle the DWO hash table, and BFD,
-     which is not thread-safe.  */
-  static std::mutex dwo_lock;
-
-  std::lock_guard<std::mutex> guard (dwo_lock);
-#endif
-
   dwarf2_per_cu_data *per_cu = cu->per_cu;
   struct dwo_unit *dwo_unit;
   const char *comp_dir;
@@ -4115,6 +4339,28 @@ lookup_dwo_unit (dwarf2_cu *cu, die_info *comp_unit_die, const char *dwo_name)
   dwo_name = dwarf2_dwo_name (comp_unit_die, cu);
   comp_dir = dwarf2_string_attr (comp_unit_die, DW_AT_comp_dir, cu);
 
+#if CXX_STD_THREAD
+  /* We need a lock here both to handle the DWO hash table, and BFD,
+     which is not thread-safe.  */
+  static std::mutex dwo_lock;
+
+  /* Searching for the DWO file needs neither, so do it before taking
+     the lock, letting the units being indexed in parallel find their
+     DWO files in parallel.  There is nothing to search for if there
+     is a DWP file, or if the DWO file was already read.  */
+  bool need_search;
+  {
+    std::lock_guard<std::mutex> guard (dwo_lock);
+    need_search = (get_dwp_file (cu->per_objfile) == nullptr
+		   && *lookup_dwo_file_slot (cu->per_objfile, dwo_name,
+					     comp_dir) == nullptr);
+  }
+  if (need_search)
+    prefetch_dwo_file (cu->per_objfile, dwo_name, comp_dir);
+
+  std::lock_guard<std::mutex> guard (dwo_lock);
+#endif
+
   if (per_cu->is_debug_types)
     dwo_unit = lookup_dwo_type_unit (cu, dwo_name, comp_dir);
   else
@@ -4407,6 +4653,14 @@ cutu_reader::keep ()
     }
 }
 
+std::unique_ptr<dwarf2_cu>
+cutu_reader::release_cu ()
+{
+  gdb_assert (!dummy_p);
+  gdb_assert (m_new_cu != nullptr);
+  return std::move (m_new_cu);
+}
+
 /* Read CU/TU THIS_CU but do not follow DW_AT_GNU_dwo_name (DW_AT_dwo_name)
    if present. DWO_FILE, if non-NULL, is the DWO file to read (the caller is
    assumed to have already done the lookup to find the DWO file).
@@ -5276,10 +5530,9 @@ finalize_all_units (dwarf2_per_bfd *per_bfd)
   per_bfd->all_type_units = tmp.slice (nr_cus, nr_tus);
 }
 
-/* Create a list of all compilation units in OBJFILE.
-   This is only done for -readnow and building partial symtabs.  */
+/* See read.h.  */
 
-static void
+void
 create_all_units (dwarf2_per_objfile *per_objfile)
 {
   htab_up types_htab;
@@ -5721,8 +5974,21 @@ load_full_comp_unit (dwarf2_per_cu_data *this_cu,
   if (reader.dummy_p)
     return;
 
-  struct dwarf2_cu *cu = reader.cu;
-  const gdb_byte *info_ptr = reader.info_ptr;
+  read_full_comp_unit_dies (&reader, pretend_language);
+  reader.keep ();
+}
+
+/* Read all the DIEs of the unit READER is positioned on into its CU,
+   and prepare the CU for symtab expansion.  This does not install the
+   CU in the per-objfile, and it does not touch anything but the CU
+   itself, so it may be called from a worker thread.  */
+
+static void
+read_full_comp_unit_dies (cutu_reader *reader,
+			  enum language pretend_language)
+{
+  struct dwarf2_cu *cu = reader->cu;
+  const gdb_byte *info_ptr = reader->info_ptr;
 
   gdb_assert (cu->die_hash == NULL);
   cu->die_hash =
@@ -5734,11 +6000,11 @@ load_full_comp_unit (dwarf2_per_cu_data *this_cu,
 			  hashtab_obstack_allocate,
 			  dummy_obstack_deallocate);
 
-  if (reader.comp_unit_die->has_children)
-    reader.comp_unit_die->child
-      = read_die_and_siblings (&reader, reader.info_ptr,
-			       &info_ptr, reader.comp_unit_die);
-  cu->dies = reader.comp_unit_die;
+  if (reader->comp_unit_die->has_children)
+    reader->comp_unit_die->child
+      = read_die_and_siblings (reader, reader->info_ptr,
+			       &info_ptr, reader->comp_unit_die);
+  cu->dies = reader->comp_unit_die;
   /* comp_unit_die is not stored in die_hash, no need.  */
 
   /* We try not to read any attributes in this function, because not
@@ -5748,8 +6014,25 @@ load_full_comp_unit (dwarf2_per_cu_data *this_cu,
      Similarly, if we do not read the producer, we can not apply
      producer-specific interpretation.  */
   prepare_one_comp_unit (cu, cu->dies, pretend_language);
+}
 
-  reader.keep ();
+/* Read the DIEs of THIS_CU into a new dwarf2_cu which is returned to
+   the caller rather than installed in PER_OBJFILE.  Returns nullptr
+   for dummy units.  This is safe to call from a worker thread, provided
+   the main thread does not modify PER_OBJFILE's CU cache meanwhile.  */
+
+static std::unique_ptr<dwarf2_cu>
+read_full_comp_unit_detached (dwarf2_per_cu_data *this_cu,
+			      dwarf2_per_objfile *per_objfile)
+{
+  gdb_assert (! this_cu->is_debug_types);
+
+  cutu_reader reader (this_cu, per_objfile, nullptr, nullptr, false);
+  if (reader.dummy_p)
+    return nullptr;
+
+  read_full_comp_unit_dies (&reader, language_minimal);
+  return reader.release_cu ();
 }
 
 /* Add a DIE to the delayed physname list.  */
@@ -9123,23 +9406,19 @@ lookup_dwo_unit_in_dwp (dwarf2_per_objfile *per_objfile,
 	 dwp_file->name);
 }
 
-/* Subroutine of open_dwo_file,open_dwp_file to simplify them.
-   Open the file specified by FILE_NAME and hand it off to BFD for
-   preliminary analysis.  Return a newly initialized bfd *, which
-   includes a canonicalized copy of FILE_NAME.
-   If IS_DWP is TRUE, we're opening a DWP file, otherwise a DWO file.
+/* Search for DWO/DWP file FILE_NAME.
+   IS_DWP is TRUE if we're looking for a DWP file, otherwise a DWO file.
    SEARCH_CWD is true if the current directory is to be searched.
    It will be searched before debug-file-directory.
-   If successful, the file is added to the bfd include table of the
-   objfile's bfd (see gdb_bfd_record_inclusion).
-   If unable to find/open the file, return NULL.
-   NOTE: This function is derived from symfile_bfd_open.  */
+   If successful, return a descriptor for the file and store its
+   absolute name in *ABSOLUTE_NAME.  Otherwise return -1.
+   This does not use BFD, so it can be called from worker threads.  */
 
-static gdb_bfd_ref_ptr
-try_open_dwop_file (dwarf2_per_objfile *per_objfile,
-		    const char *file_name, int is_dwp, int search_cwd)
+static int
+search_dwop_file (dwarf2_per_objfile *per_objfile,
+		  const char *file_name, int is_dwp, int search_cwd,
+		  gdb::unique_xmalloc_ptr<char> *absolute_name)
 {
-  int desc;
   /* Blech.  OPF_TRY_CWD_FIRST also disables searching the path list if
      FILE_NAME contains a '/'.  So we can't use it.  Instead prepend "."
      to debug_file_directory.  */
@@ -9173,14 +9452,22 @@ try_open_dwop_file (dwarf2_per_objfile *per_objfile,
   if (is_dwp)
     flags |= OPF_SEARCH_IN_PATH;
 
-  gdb::unique_xmalloc_ptr<char> absolute_name;
-  desc = openp (search_path, flags, file_name,
-		O_RDONLY | O_BINARY, &absolute_name);
-  if (desc < 0)
-    return NULL;
+  return openp (search_path, flags, file_name,
+		O_RDONLY | O_BINARY, absolute_name);
+}
 
-  gdb_bfd_ref_ptr sym_bfd (gdb_bfd_open (absolute_name.get (),
-					 gnutarget, desc));
+/* Open the DWO/DWP file ABSOLUTE_NAME, for which DESC is a descriptor,
+   as found by search_dwop_file.  This takes ownership of DESC.
+   If successful, the file is added to the bfd include table of the
+   objfile's bfd (see gdb_bfd_record_inclusion).
+   If unable to open the file, return NULL.
+   NOTE: This function is derived from symfile_bfd_open.  */
+
+static gdb_bfd_ref_ptr
+open_dwop_bfd (dwarf2_per_objfile *per_objfile, const char *absolute_name,
+	       int desc)
+{
+  gdb_bfd_ref_ptr sym_bfd (gdb_bfd_open (absolute_name, gnutarget, desc));
   if (sym_bfd == NULL)
     return NULL;
   bfd_set_cacheable (sym_bfd.get (), 1);
@@ -9197,20 +9484,41 @@ try_open_dwop_file (dwarf2_per_objfile *per_objfile,
   return sym_bfd;
 }
 
-/* Try to open DWO file FILE_NAME.
-   COMP_DIR is the DW_AT_comp_dir attribute.
-   The result is the bfd handle of the file.
-   If there is a problem finding or opening the file, return NULL.
-   Upon success, the canonicalized path of the file is stored in the bfd,
-   same as symfile_bfd_open.  */
+/* Try to open DWO/DWP file FILE_NAME.
+   IS_DWP is TRUE if we're opening a DWP file, otherwise a DWO file.
+   SEARCH_CWD is true if the current directory is to be searched.
+   It will be searched before debug-file-directory.
+   If successful, the file is added to the bfd include table of the
+   objfile's bfd (see gdb_bfd_record_inclusion).
+   If unable to find/open the file, return NULL.  */
 
 static gdb_bfd_ref_ptr
-open_dwo_file (dwarf2_per_objfile *per_objfile,
-	       const char *file_name, const char *comp_dir)
+try_open_dwop_file (dwarf2_per_objfile *per_objfile,
+		    const char *file_name, int is_dwp, int search_cwd)
+{
+  gdb::unique_xmalloc_ptr<char> absolute_name;
+  int desc = search_dwop_file (per_objfile, file_name, is_dwp, search_cwd,
+			       &absolute_name);
+  if (desc < 0)
+    return NULL;
+
+  return open_dwop_bfd (per_objfile, absolute_name.get (), desc);
+}
+
+/* Search for DWO file FILE_NAME.
+   COMP_DIR is the DW_AT_comp_dir attribute.
+   If successful, return a descriptor for the file and store its
+   canonicalized path in *ABSOLUTE_NAME.  Otherwise return -1.
+   This does not use BFD, so it can be called from worker threads.  */
+
+static int
+search_dwo_file (dwarf2_per_objfile *per_objfile,
+		 const char *file_name, const char *comp_dir,
+		 gdb::unique_xmalloc_ptr<char> *absolute_name)
 {
   if (IS_ABSOLUTE_PATH (file_name))
-    return try_open_dwop_file (per_objfile, file_name,
-			       0 /*is_dwp*/, 0 /*search_cwd*/);
+    return search_dwop_file (per_objfile, file_name,
+			     0 /*is_dwp*/, 0 /*search_cwd*/, absolute_name);
 
   /* Before trying the search path, try DWO_NAME in COMP_DIR.  */
 
@@ -9220,6 +9528,101 @@ open_dwo_file (dwarf2_per_objfile *per_objfile,
 
       /* NOTE: If comp_dir is a relative path, this will also try the
 	 search path, which seems useful.  */
+      int desc = search_dwop_file (per_objfile, path_to_try.c_str (),
+				   0 /*is_dwp*/, 1 /*search_cwd*/,
+				   absolute_name);
+      if (desc >= 0)
+	return desc;
+    }
+
+  /* That didn't work, try debug-file-directory, which, despite its name,
+     is a list of paths.  */
+
+  if (debug_file_directory.empty ())
+    return -1;
+
+  return search_dwop_file (per_objfile, file_name,
+			   0 /*is_dwp*/, 1 /*search_cwd*/, absolute_name);
+}
+
+/* Return the key of the DWO file DWO_NAME of a unit whose
+   DW_AT_comp_dir is COMP_DIR in dwarf2_per_bfd::dwo_file_searches.  */
+
+static std::string
+dwo_file_search_key (const char *dwo_name, const char *comp_dir)
+{
+  std::string key (comp_dir != nullptr ? comp_dir : "");
+  key += '\0';
+  key += dwo_name;
+  return key;
+}
+
+/* Search for the DWO file DWO_NAME of a unit whose DW_AT_comp_dir is
+   COMP_DIR, unless it was already found, and record the result in
+   dwarf2_per_bfd::dwo_file_searches for open_dwo_file.
+
+   This does not use BFD and does not need the DWO lock, so the DWO
+   files of the skeleton units are searched for and opened in parallel
+   while the units are indexed.  This matters when there are many DWO
+   files on a slow file system.  */
+
+static void
+prefetch_dwo_file (dwarf2_per_objfile *per_objfile, const char *dwo_name,
+		   const char *comp_dir)
+{
+  dwarf2_per_bfd *per_bfd = per_objfile->per_bfd;
+  std::string key = dwo_file_search_key (dwo_name, comp_dir);
+
+  {
+#if CXX_STD_THREAD
+    std::lock_guard<std::mutex> guard (per_bfd->dwo_file_searches_lock);
+#endif
+    auto iter = per_bfd->dwo_file_searches.find (key);
+    if (iter != per_bfd->dwo_file_searches.end ()
+	&& iter->second.found
+	&& iter->second.debug_file_directory == debug_file_directory)
+      return;
+  }
+
+  dwo_file_search search;
+  search.debug_file_directory = debug_file_directory;
+  search.fd = scoped_fd (search_dwo_file (per_objfile, dwo_name, comp_dir,
+					  &search.filename));
+  search.found = search.fd.get () >= 0;
+
+#if defined (POSIX_FADV_WILLNEED)
+  /* Start reading the file in, as it is going to be read soon.  */
+  if (search.fd.get () >= 0)
+    posix_fadvise (search.fd.get (), 0, 0, POSIX_FADV_WILLNEED);
+#endif
+
+#if CXX_STD_THREAD
+  std::lock_guard<std::mutex> guard (per_bfd->dwo_file_searches_lock);
+#endif
+  auto iter = per_bfd->dwo_file_searches.find (key);
+  if (iter == per_bfd->dwo_file_searches.end ())
+    per_bfd->dwo_file_searches.emplace (std::move (key), std::move (search));
+  else if (!iter->second.found
+	   || iter->second.debug_file_directory != debug_file_directory)
+    iter->second = std::move (search);
+}
+
+/* Search for and open DWO file FILE_NAME like open_dwo_file, but
+   going on with the search if a file that is found cannot be opened.
+   This does not use the search done by prefetch_dwo_file.  */
+
+static gdb_bfd_ref_ptr
+reopen_dwo_file (dwarf2_per_objfile *per_objfile,
+		 const char *file_name, const char *comp_dir)
+{
+  if (IS_ABSOLUTE_PATH (file_name))
+    return try_open_dwop_file (per_objfile, file_name,
+			       0 /*is_dwp*/, 0 /*search_cwd*/);
+
+  if (comp_dir != NULL)
+    {
+      std::string path_to_try = path_join (comp_dir, file_name);
+
       gdb_bfd_ref_ptr abfd (try_open_dwop_file
 	(per_objfile, path_to_try.c_str (), 0 /*is_dwp*/, 1 /*search_cwd*/));
 
@@ -9227,9 +9630,6 @@ open_dwo_file (dwarf2_per_objfile *per_objfile,
 	return abfd;
     }
 
-  /* That didn't work, try debug-file-directory, which, despite its name,
-     is a list of paths.  */
-
   if (debug_file_directory.empty ())
     return NULL;
 
@@ -9237,6 +9637,86 @@ open_dwo_file (dwarf2_per_objfile *per_objfile,
 			     0 /*is_dwp*/, 1 /*search_cwd*/);
 }
 
+/* Record ERROR as the reason why DWO file FILE_NAME of a unit whose
+   DW_AT_comp_dir is COMP_DIR cannot be used.  READ_FAILED is true if
+   the file could be opened but not read.  */
+
+static void
+set_dwo_file_error (dwarf2_per_objfile *per_objfile, const char *file_name,
+		    const char *comp_dir, std::string &&error,
+		    bool read_failed)
+{
+  dwarf2_per_bfd *per_bfd = per_objfile->per_bfd;
+
+#if CXX_STD_THREAD
+  std::lock_guard<std::mutex> guard (per_bfd->dwo_file_searches_lock);
+#endif
+  dwo_file_search &search
+    = per_bfd->dwo_file_searches.at (dwo_file_search_key (file_name,
+							   comp_dir));
+  search.error = std::move (error);
+  search.read_failed = read_failed;
+}
+
+/* Try to open DWO file FILE_NAME.
+   COMP_DIR is the DW_AT_comp_dir attribute.
+   The result is the bfd handle of the file.
+   If there is a problem finding or opening the file, return NULL.
+   A file that is found but cannot be opened is reported the first
+   time.  If reading the file failed before, throw that error again.
+   Upon success, the canonicalized path of the file is stored in the bfd,
+   same as symfile_bfd_open.
+
+   Once the file is found, the search is not done again for the same
+   debug-file-directory setting; see prefetch_dwo_file.  */
+
+static gdb_bfd_ref_ptr
+open_dwo_file (dwarf2_per_objfile *per_objfile,
+	       const char *file_name, const char *comp_dir)
+{
+  dwarf2_per_bfd *per_bfd = per_objfile->per_bfd;
+
+  prefetch_dwo_file (per_objfile, file_name, comp_dir);
+
+  int desc;
+  gdb::unique_xmalloc_ptr<char> absolute_name;
+  {
+#if CXX_STD_THREAD
+    std::lock_guard<std::mutex> guard (per_bfd->dwo_file_searches_lock);
+#endif
+    dwo_file_search &search
+      = per_bfd->dwo_file_searches.at (dwo_file_search_key (file_name,
+							     comp_dir));
+    if (search.read_failed)
+      error ("%s", search.error.c_str ());
+    desc = search.fd.release ();
+    absolute_name = std::move (search.filename);
+  }
+
+  if (desc < 0)
+    return NULL;
+
+  gdb_bfd_ref_ptr abfd = open_dwop_bfd (per_objfile, absolute_name.get (),
+					desc);
+  if (abfd != NULL)
+    return abfd;
+
+  /* The first file found is not usable, for instance because it is
+     not an object file.  Save the reason before it is overwritten,
+     then look further.  */
+  std::string error = string_printf ("%s: %s", absolute_name.get (),
+				     bfd_errmsg (bfd_get_error ()));
+  abfd = reopen_dwo_file (per_objfile, file_name, comp_dir);
+  if (abfd == NULL)
+    {
+      warning (_("Could not open DWO file %s"), error.c_str ());
+      set_dwo_file_error (per_objfile, file_name, comp_dir,
+			  std::move (error), false);
+    }
+
+  return abfd;
+}
+
 /* This function is mapped across the sections and remembers the offset and
    size of each of the DWO debugging sections we are interested in.  */
 
@@ -9308,23 +9788,36 @@ open_and_init_dwo_file (dwarf2_cu *cu, const char *dwo_name,
   dwo_file->comp_dir = comp_dir;
   dwo_file->dbfd = std::move (dbfd);
 
-  for (asection *sec : gdb_bfd_sections (dwo_file->dbfd))
-    dwarf2_locate_dwo_sections (per_objfile->objfile, dwo_file->dbfd.get (),
-				sec, &dwo_file->sections);
+  try
+    {
+      for (asection *sec : gdb_bfd_sections (dwo_file->dbfd))
+	dwarf2_locate_dwo_sections (per_objfile->objfile,
+				    dwo_file->dbfd.get (), sec,
+				    &dwo_file->sections);
 
-  create_cus_hash_table (per_objfile, cu, *dwo_file, dwo_file->sections.info,
-			 dwo_file->cus);
+      create_cus_hash_table (per_objfile, cu, *dwo_file,
+			     dwo_file->sections.info, dwo_file->cus);
 
-  if (cu->per_cu->version () < 5)
-    {
-      create_debug_types_hash_table (per_objfile, dwo_file.get (),
-				     dwo_file->sections.types, dwo_file->tus);
+      if (cu->per_cu->version () < 5)
+	{
+	  create_debug_types_hash_table (per_objfile, dwo_file.get (),
+					 dwo_file->sections.types,
+					 dwo_file->tus);
+	}
+      else
+	{
+	  create_debug_type_hash_table (per_objfile, dwo_file.get (),
+					&dwo_file->sections.info,
+					dwo_file->tus, rcuh_kind::COMPILE);
+	}
     }
-  else
+  catch (const gdb_exception_error &ex)
     {
-      create_debug_type_hash_table (per_objfile, dwo_file.get (),
-				    &dwo_file->sections.info, dwo_file->tus,
-				    rcuh_kind::COMPILE);
+      /* The file was found, so it must not be reported as missing by
+	 the next units that use it.  Keep the error for them.  */
+      set_dwo_file_error (per_objfile, dwo_name, comp_dir, ex.what (),
+			  true);
+      throw;
     }
 
   dwarf_read_debug_printf ("DWO file found: %s", dwo_name);
@@ -16807,23 +17300,26 @@ cooked_index_functions::expand_symtabs_matching
   gdb_assert (lookup_name != nullptr || symbol_matcher == nullptr);
   if (lookup_name == nullptr)
     {
+      std::vector<dwarf2_per_cu_data *> units;
       for (dwarf2_per_cu_data *per_cu
 	     : all_units_range (per_objfile->per_bfd))
-	{
-	  QUIT;
+	units.push_back (per_cu);
 
-	  if (!dw2_expand_symtabs_matching_one (per_cu, per_objfile,
+      return dw2_expand_symtabs_matching_units (units, per_objfile,
 						file_matcher,
-						expansion_notify))
-	    return false;
-	}
-      return true;
+						expansion_notify);
     }
 
   lookup_name_info lookup_name_without_params
     = lookup_name->make_ignore_params ();
   bool completing = lookup_name->completion_mode ();
 
+  /* The units to expand, in the order they were found.  Collecting
+     them first lets dw2_expand_symtabs_matching_units read them in
+     parallel.  */
+  std::vector<dwarf2_per_cu_data *> units;
+  std::unordered_set<dwarf2_per_cu_data *> units_seen;
+
   /* Unique styles of language splitting.  */
   static const enum language unique_styles[] =
   {
@@ -16906,14 +17402,13 @@ cooked_index_functions::expand_symtabs_matching
 		continue;
 	    }
 
-	  if (!dw2_expand_symtabs_matching_one (entry->per_cu, per_objfile,
-						file_matcher,
-						expansion_notify))
-	    return false;
+	  if (units_seen.insert (entry->per_cu).second)
+	    units.push_back (entry->per_cu);
 	}
     }
 
-  return true;
+  return dw2_expand_symtabs_matching_units (units, per_objfile,
+					    file_matcher, expansion_notify);
 }
 
 /* Return a new cooked_index_functions object.  */
@@ -22016,6 +22511,18 @@ caching, which can slow down startup."),
 			    &set_dwarf_cmdlist,
 			    &show_dwarf_cmdlist);
 
+  add_setshow_boolean_cmd ("parallel-expansion", class_obscure,
+			   &dwarf_parallel_expansion, _("\
+Set whether DWARF units are read in parallel during symtab expansion."), _("\
+Show whether DWARF units are read in parallel during symtab expansion."), _("\
+When on, and several compilation units match a symbol search, their\n\
+DIEs are read on the worker threads before their symbol tables are\n\
+built on the main thread."),
+			   NULL,
+			   show_dwarf_parallel_expansion,
+			   &set_dwarf_cmdlist,
+			   &show_dwarf_cmdlist);
+
   add_setshow_zuinteger_cmd ("dwarf-read", no_class, &dwarf_read_debug, _("\
 Set debugging of the DWARF reader."), _("\
 Show debugging of the DWARF reader."), _("\
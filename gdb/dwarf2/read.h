@@ -34,6 +34,11 @@
 #include "gdbsupport/hash_enum.h"
 #include "gdbsupport/function-view.h"
 #include "gdbsupport/packed.h"
+#include "gdbsupport/scoped_fd.h"
+
+#if CXX_STD_THREAD
+#include <mutex>
+#endif
 
 /* Hold 'maintenance (set|show) dwarf' commands.  */
 extern struct cmd_list_element *set_dwarf_cmdlist;
@@ -410,6 +415,35 @@ struct signatured_type : public dwarf2_per_cu_data
 
 using signatured_type_up = std::unique_ptr<signatured_type>;
 
+/* The result of searching for a DWO file ahead of reading it.  See
+   prefetch_dwo_file.  */
+
+struct dwo_file_search
+{
+  /* The value of debug-file-directory when the search was done.  */
+  std::string debug_file_directory;
+
+  /* A descriptor for the file that was found.  This is -1 if the file
+     was not found, or once the file has been opened.  */
+  scoped_fd fd;
+
+  /* The name of the file that was found, or NULL.  */
+  gdb::unique_xmalloc_ptr<char> filename;
+
+  /* Whether the file was found.  A search that found nothing is done
+     again the next time, since the file may have shown up since, or
+     be found relative to another current directory.  */
+  bool found = false;
+
+  /* If the file was found but could not be used, the reason.  */
+  std::string error;
+
+  /* True if the file was opened but reading it failed with ERROR.
+     The next units using the file get that error too, rather than
+     finding the file missing.  */
+  bool read_failed = false;
+};
+
 /* Some DWARF data can be shared across objfiles who share the same BFD,
    this data is stored in this object.
 
@@ -512,6 +546,16 @@ struct dwarf2_per_bfd
      This is NULL if the table hasn't been allocated yet.  */
   htab_up dwo_files;
 
+  /* The results of searching for DWO files, keyed by the
+     DW_AT_comp_dir and DW_AT_dwo_name of the skeleton unit.  See
+     prefetch_dwo_file.  */
+  std::unordered_map<std::string, dwo_file_search> dwo_file_searches;
+
+#if CXX_STD_THREAD
+  /* Protects DWO_FILE_SEARCHES.  */
+  std::mutex dwo_file_searches_lock;
+#endif
+
   /* True if we've checked for whether there is a DWP file.  */
   bool dwp_checked = false;
 
@@ -897,6 +941,18 @@ extern bool dw2_expand_symtabs_matching_one
    gdb::function_view<expand_symtabs_file_matcher_ftype> file_matcher,
    gdb::function_view<expand_symtabs_exp_notify_ftype> expansion_notify);
 
+/* Like dw2_expand_symtabs_matching_one, but for each of UNITS in turn,
+   stopping as soon as EXPANSION_NOTIFY returns false.  Returns false
+   in that case, true otherwise.  Unless disabled with "maint set dwarf
+   parallel-expansion", the DIEs of the units are read on the worker
+   threads, while their symtabs are still built on the main thread.  */
+
+extern bool dw2_expand_symtabs_matching_units
+  (gdb::array_view<dwarf2_per_cu_data * const> units,
+   dwarf2_per_objfile *per_objfile,
+   gdb::function_view<expand_symtabs_file_matcher_ftype> file_matcher,
+   gdb::function_view<expand_symtabs_exp_notify_ftype> expansion_notify);
+
 /* Helper for dw2_expand_symtabs_matching that works with a
    mapped_index_base instead of the containing objfile.  This is split
    to a separate function in order to be able to unit test the
@@ -935,6 +991,12 @@ extern dwarf2_per_cu_data_up create_cu_from_index_list
   (dwarf2_per_bfd *per_bfd, struct dwarf2_section_info *section,
    int is_dwz, sect_offset sect_off, ULONGEST length);
 
+/* Create a list of all the units in PER_OBJFILE.  This is only done
+   for -readnow, when building the cooked index and when reading it
+   back from the index cache.  */
+
+extern void create_all_units (dwarf2_per_objfile *per_objfile);
+
 /* Initialize the views on all_units.  */
 
 extern void finalize_all_units (dwarf2_per_bfd *per_bfd);
@@ -204,6 +204,15 @@ frame_unwind_find_by_frame (frame_info_ptr this_frame, void **this_cache)
 				   unwinder_from_target))
     return;
 
+  /* If this frame is still the one that was found at the same place
+     when the thread's frames were last flushed, use the same unwinder
+     and cache again.  Not when the target supplies its own unwinders,
+     e.g. when replaying.  */
+  if (unwinder_from_target == NULL
+      && target_get_unwinder () == NULL
+      && frame_reuse_retained_unwinder (this_frame, this_cache))
+    return;
+
   for (entry = table->list; entry != NULL; entry = entry->next)
     if (frame_unwind_try_unwinder (this_frame, this_cache, entry->unwinder))
       return;
@@ -156,6 +156,21 @@ typedef void (frame_dealloc_cache_ftype) (frame_info *self,
 typedef struct gdbarch *(frame_prev_arch_ftype) (frame_info_ptr this_frame,
 						 void **this_prologue_cache);
 
+/* Return true if THIS_PROLOGUE_CACHE, THIS frame's prologue cache, may
+   be used again for a frame found at the same code address after the
+   thread has been resumed and has stopped again, provided that the
+   frames inner to it were themselves unchanged and that the part of
+   the stack between THIS frame's stack pointer and its CFA still has
+   the same contents (see retain_frame_cache).  This means the cache
+   must only depend on THIS frame's code address, its stack pointer and
+   the registers its callee had saved in that part of the stack; it
+   must not be modified in a way that allocates memory once this
+   method returned true; and the unwinder's dealloc_cache method must
+   leave it usable.  */
+
+typedef bool (frame_retain_ftype) (frame_info_ptr this_frame,
+				   void *this_prologue_cache);
+
 struct frame_unwind
 {
   const char *name;
@@ -171,6 +186,7 @@ struct frame_unwind
   frame_sniffer_ftype *sniffer;
   frame_dealloc_cache_ftype *dealloc_cache;
   frame_prev_arch_ftype *prev_arch;
+  frame_retain_ftype *retain;
 };
 
 /* Register a frame unwinder, _prepending_ it to the front of the
@@ -43,6 +43,7 @@
 #include "hashtab.h"
 #include "valprint.h"
 #include "cli/cli-option.h"
+#include "gdbsupport/byte-vector.h"
 
 /* The sentinel frame terminates the innermost end of the frame chain.
    If unwound, it returns the information needed to construct an
@@ -143,6 +144,12 @@ struct frame_info
   void *prologue_cache;
   const struct frame_unwind *unwind;
 
+  /* If positive, one plus the index of the frame this frame was found
+     to be unchanged from, among those retained for the thread by
+     retain_frame_cache; if negative, this frame is not one of those.
+     Zero if this was not checked yet.  */
+  int retained;
+
   /* Cached copy of the previous frame's architecture.  */
   struct
   {
@@ -1648,21 +1655,453 @@ create_sentinel_frame (struct program_space *pspace, struct regcache *regcache,
   return frame_info_ptr (frame);
 }
 
+/* The memory for the frames, and the unwinders' caches, allocated
+   between two calls to reinit_frame_cache.  It outlives the frames
+   when some of those caches were retained by retain_frame_cache.  */
+
+struct frame_cache_store
+{
+  frame_cache_store ()
+  {
+    obstack_init (&obstack);
+  }
+
+  ~frame_cache_store ()
+  {
+    obstack_free (&obstack, 0);
+  }
+
+  DISABLE_COPY_AND_ASSIGN (frame_cache_store);
+
+  struct obstack obstack;
+};
+
+using frame_cache_store_ref = std::shared_ptr<frame_cache_store>;
+
 /* Cache for frame addresses already read by gdb.  Valid only while
    inferior is stopped.  Control variables for the frame cache should
    be local to this module.  */
 
-static struct obstack frame_cache_obstack;
+static frame_cache_store_ref frame_cache_current;
+
+/* The older stores the caches used by the current frames were
+   allocated in.  */
+
+static std::vector<frame_cache_store_ref> frame_cache_borrowed;
 
 void *
 frame_obstack_zalloc (unsigned long size)
 {
-  void *data = obstack_alloc (&frame_cache_obstack, size);
+  void *data = obstack_alloc (&frame_cache_current->obstack, size);
 
   memset (data, 0, size);
   return data;
 }
 
+/* What is remembered of a frame by retain_frame_cache.  */
+
+struct retained_frame
+{
+  /* The frame's type, architecture, code address and ID.  The ID of an
+     inline frame is only known if it was computed.  */
+  enum frame_type type;
+  struct gdbarch *arch;
+  CORE_ADDR pc;
+  bool id_p;
+  frame_id id;
+
+  /* The frame's unwinder and prologue cache, and the store the
+     prologue cache was allocated in.  */
+  const frame_unwind *unwind;
+  void *prologue_cache;
+  frame_cache_store_ref store;
+
+  /* Whether the unwinder and prologue cache can be used again, see
+     frame_retain_ftype.  */
+  bool reusable;
+
+  /* The part of the stack that belongs to a normal frame, from its
+     stack pointer to its CFA, and a hash of its contents.  That is
+     where the frame saved its caller's registers.  Empty for the other
+     kinds of frames.  */
+  CORE_ADDR area_start;
+  ULONGEST area_len;
+  unsigned int area_hash;
+};
+
+/* The frames retained for a thread, innermost first.  */
+
+struct retained_thread_frames
+{
+  process_stratum_target *target;
+  ptid_t ptid;
+  std::vector<retained_frame> frames;
+};
+
+/* The threads whose frames were retained, least recently first.  */
+
+static std::vector<retained_thread_frames> retained_frames;
+
+/* Whether frames are retained across stops at all.  */
+
+static bool frame_retention_p = true;
+
+/* The number of threads whose frames are retained.  The frames of the
+   least recently flushed thread are forgotten first.  */
+
+static const size_t max_retained_threads = 16;
+
+/* The largest part of the stack a single frame may own for it to be
+   retained.  Bigger frames are just unwound again.  */
+
+static const ULONGEST max_retained_frame_area = 64 * 1024;
+
+/* Hash the LEN bytes of stack at START into *HASH.  Return false if
+   they could not be read.  */
+
+static bool
+hash_stack_area (CORE_ADDR start, ULONGEST len, unsigned int *hash)
+{
+  gdb::byte_vector buf (len);
+
+  if (len > 0 && target_read_stack (start, buf.data (), len) != 0)
+    return false;
+
+  *hash = fast_hash (buf.data (), len);
+  return true;
+}
+
+/* Return whether the part of the stack owned by retained frame RF
+   still has the same contents.  */
+
+static bool
+retained_frame_area_unchanged_p (const retained_frame &rf)
+{
+  unsigned int hash;
+
+  return (hash_stack_area (rf.area_start, rf.area_len, &hash)
+	  && hash == rf.area_hash);
+}
+
+/* Return the frames retained for the current thread, or NULL.  */
+
+static std::vector<retained_frame> *
+current_retained_frames ()
+{
+  if (!frame_retention_p || inferior_ptid == null_ptid)
+    return nullptr;
+
+  process_stratum_target *target = current_inferior ()->process_target ();
+  for (retained_thread_frames &rt : retained_frames)
+    if (rt.target == target && rt.ptid == inferior_ptid)
+      return &rt.frames;
+
+  return nullptr;
+}
+
+/* Return the index in FRAMES, the frames retained for the current
+   thread, of the frame FI is unchanged from, or -1.  A normal frame is
+   unchanged if it has the same unwinder, code address and ID as a
+   retained frame, and the part of the stack it owns has the same
+   contents.  An inline frame is also required to be outer to an
+   unchanged frame, as it uses the registers of that frame.  */
+
+static int
+frame_retained_index (const std::vector<retained_frame> &frames,
+		      frame_info *fi)
+{
+  if (fi->retained != 0)
+    return fi->retained > 0 ? fi->retained - 1 : -1;
+  fi->retained = -1;
+
+  if (fi->level < 0
+      || fi->unwind == nullptr
+      || (fi->unwind->type != NORMAL_FRAME
+	  && fi->unwind->type != INLINE_FRAME)
+      || fi->next->prev_pc.status != CC_VALUE)
+    return -1;
+
+  CORE_ADDR pc = fi->next->prev_pc.value;
+  struct gdbarch *arch = frame_unwind_arch (frame_info_ptr (fi->next));
+  bool id_p = fi->this_id.p == frame_id_status::COMPUTED;
+  size_t first = 0, last = frames.size ();
+
+  if (fi->unwind->type == INLINE_FRAME)
+    {
+      int next = frame_retained_index (frames, fi->next);
+
+      if (next < 0)
+	return -1;
+      first = next + 1;
+      last = std::min (last, first + 1);
+    }
+  else if (!id_p)
+    return -1;
+
+  for (size_t i = first; i < last; ++i)
+    {
+      const retained_frame &rf = frames[i];
+
+      if (rf.unwind == fi->unwind
+	  && rf.pc == pc
+	  && rf.arch == arch
+	  && (!id_p || !rf.id_p || rf.id == fi->this_id.value))
+	{
+	  if (!retained_frame_area_unchanged_p (rf))
+	    return -1;
+
+	  frame_debug_printf ("frame %d is unchanged from retained frame %zu",
+			      fi->level, i);
+	  fi->retained = i + 1;
+	  return i;
+	}
+    }
+
+  return -1;
+}
+
+/* See frame.h.  */
+
+bool
+frame_reuse_retained_unwinder (frame_info_ptr this_frame, void **this_cache)
+{
+  if (this_frame->level <= 0)
+    return false;
+
+  std::vector<retained_frame> *frames = current_retained_frames ();
+  if (frames == nullptr)
+    return false;
+
+  int next = frame_retained_index (*frames, this_frame->next);
+  if (next < 0 || next + 1 >= frames->size ())
+    return false;
+
+  const retained_frame &rf = (*frames)[next + 1];
+  if (!rf.reusable || rf.arch != get_frame_arch (this_frame))
+    return false;
+
+  try
+    {
+      if (get_frame_pc (this_frame) != rf.pc)
+	return false;
+    }
+  catch (const gdb_exception_error &ex)
+    {
+      return false;
+    }
+
+  if (!retained_frame_area_unchanged_p (rf))
+    return false;
+
+  frame_debug_printf ("reusing unwinder \"%s\" of retained frame %d",
+		      rf.unwind->name, next + 1);
+
+  frame_prepare_for_sniffer (this_frame, rf.unwind);
+  *this_cache = rf.prologue_cache;
+  this_frame->retained = next + 2;
+
+  if (frame_cache_borrowed.empty ()
+      || frame_cache_borrowed.back () != rf.store)
+    frame_cache_borrowed.push_back (rf.store);
+
+  return true;
+}
+
+/* Fill in RF with what is remembered of frame FI.  OLD_RF, if not
+   NULL, is the retained frame FI was found to be unchanged from.
+   Return false if FI cannot be retained.  */
+
+static bool
+retain_frame (frame_info *fi, const retained_frame *old_rf,
+	      retained_frame *rf)
+{
+  if (fi->unwind == nullptr
+      || fi->next->prev_pc.status != CC_VALUE)
+    return false;
+
+  rf->type = fi->unwind->type;
+  rf->arch = frame_unwind_arch (frame_info_ptr (fi->next));
+  rf->pc = fi->next->prev_pc.value;
+  rf->id_p = fi->this_id.p == frame_id_status::COMPUTED;
+  if (rf->id_p)
+    rf->id = fi->this_id.value;
+  else if (rf->type != INLINE_FRAME)
+    return false;
+  rf->unwind = fi->unwind;
+  rf->prologue_cache = fi->prologue_cache;
+
+  if (old_rf != nullptr && old_rf->prologue_cache == fi->prologue_cache)
+    {
+      /* The cache was reused, so it is still what it was when it was
+	 first retained; and the frame's part of the stack was found to
+	 be unchanged.  */
+      rf->store = old_rf->store;
+      rf->reusable = old_rf->reusable;
+      rf->area_start = old_rf->area_start;
+      rf->area_len = old_rf->area_len;
+      rf->area_hash = old_rf->area_hash;
+      return true;
+    }
+
+  rf->store = frame_cache_current;
+  rf->reusable = (rf->type == NORMAL_FRAME
+		  && fi->prologue_cache != nullptr
+		  && fi->unwind->retain != nullptr
+		  && fi->unwind->retain (frame_info_ptr (fi),
+					 fi->prologue_cache));
+
+  rf->area_start = 0;
+  rf->area_len = 0;
+  if (rf->type == NORMAL_FRAME)
+    {
+      if (rf->id.stack_status != FID_STACK_VALID)
+	return false;
+
+      CORE_ADDR sp = get_frame_sp (frame_info_ptr (fi));
+      CORE_ADDR cfa = rf->id.stack_addr;
+      if (gdbarch_inner_than (rf->arch, cfa, sp))
+	return false;
+
+      rf->area_start = std::min (sp, cfa);
+      rf->area_len = std::max (sp, cfa) - rf->area_start;
+      if (rf->area_len > max_retained_frame_area)
+	return false;
+    }
+
+  return hash_stack_area (rf->area_start, rf->area_len, &rf->area_hash);
+}
+
+/* Return the frames of the current thread that can be retained,
+   followed by those retained before, OLD_FRAMES, that are outer to
+   them and may still be on the stack.  */
+
+static std::vector<retained_frame>
+retain_current_frames (std::vector<retained_frame> &old_frames)
+{
+  std::vector<retained_frame> frames;
+  frame_info *last = nullptr;
+  bool complete = false;
+
+  for (frame_info *fi = sentinel_frame->prev; fi != nullptr; fi = fi->prev)
+    {
+      retained_frame rf;
+
+      try
+	{
+	  int index = frame_retained_index (old_frames, fi);
+	  if (!retain_frame (fi, index >= 0 ? &old_frames[index] : nullptr,
+			     &rf))
+	    break;
+	}
+      catch (const gdb_exception_error &ex)
+	{
+	  break;
+	}
+
+      frames.push_back (std::move (rf));
+      last = fi;
+
+      if (!fi->prev_p)
+	{
+	  complete = true;
+	  break;
+	}
+    }
+
+  if (!complete || old_frames.empty ())
+    return frames;
+
+  /* If the outermost frame unwound was found to be unchanged, keep the
+     old frames outer to it.  Otherwise, keep those whose CFA is outer
+     to that of the outermost normal frame unwound.  */
+  int index = frame_retained_index (old_frames, last);
+  size_t keep = old_frames.size ();
+
+  if (index >= 0)
+    keep = index + 1;
+  else
+    {
+      const retained_frame *outermost = nullptr;
+      for (const retained_frame &rf : frames)
+	if (rf.type == NORMAL_FRAME)
+	  outermost = &rf;
+
+      if (outermost != nullptr)
+	for (keep = 0; keep < old_frames.size (); ++keep)
+	  if (old_frames[keep].id_p
+	      && old_frames[keep].id.stack_status == FID_STACK_VALID
+	      && gdbarch_inner_than (outermost->arch,
+				     outermost->id.stack_addr,
+				     old_frames[keep].id.stack_addr))
+	    break;
+    }
+
+  for (; keep < old_frames.size (); ++keep)
+    frames.push_back (std::move (old_frames[keep]));
+
+  return frames;
+}
+
+/* See frame.h.  */
+
+void
+retain_frame_cache ()
+{
+  static bool retaining = false;
+
+  if (!frame_retention_p
+      || retaining
+      || sentinel_frame == nullptr
+      || sentinel_frame->prev == nullptr
+      || inferior_ptid == null_ptid)
+    return;
+
+  scoped_restore restore_retaining = make_scoped_restore (&retaining, true);
+  process_stratum_target *target = current_inferior ()->process_target ();
+  std::vector<retained_frame> *old_frames = current_retained_frames ();
+  std::vector<retained_frame> no_frames;
+  std::vector<retained_frame> frames;
+
+  /* Retaining the frames is only an optimization, it must not prevent
+     resuming the thread.  */
+  try
+    {
+      frames = retain_current_frames (old_frames != nullptr
+				      ? *old_frames : no_frames);
+    }
+  catch (const gdb_exception &ex)
+    {
+      frames.clear ();
+    }
+
+  /* Nothing could be retained this time, keep what was retained
+     before.  */
+  if (frames.empty ())
+    return;
+
+  frame_debug_printf ("retaining %zu frames", frames.size ());
+
+  /* Make the thread the most recently retained one.  */
+  retained_frames.erase
+    (std::remove_if (retained_frames.begin (), retained_frames.end (),
+		     [&] (const retained_thread_frames &rt)
+		     {
+		       return rt.target == target && rt.ptid == inferior_ptid;
+		     }),
+     retained_frames.end ());
+  if (retained_frames.size () >= max_retained_threads)
+    retained_frames.erase (retained_frames.begin ());
+  retained_frames.push_back ({ target, inferior_ptid, std::move (frames) });
+}
+
+/* See frame.h.  */
+
+void
+discard_retained_frames ()
+{
+  retained_frames.clear ();
+}
+
 static frame_info_ptr get_prev_frame_always_1 (frame_info_ptr this_frame);
 
 frame_info_ptr
@@ -2097,9 +2536,26 @@ get_next_frame_sentinel_okay (frame_info_ptr this_frame)
 static void
 frame_observer_target_changed (struct target_ops *target)
 {
+  discard_retained_frames ();
   reinit_frame_cache ();
 }
 
+/* Observer for the new_objfile, free_objfile and inferior_exit
+   events.  The frames retained may refer to the objfile, or to a
+   process that is gone.  */
+
+static void
+frame_observer_discard_retained (struct objfile *objfile)
+{
+  discard_retained_frames ();
+}
+
+static void
+frame_observer_inferior_exit (struct inferior *inf)
+{
+  discard_retained_frames ();
+}
+
 /* Flush the entire frame cache.  */
 
 void
@@ -2128,9 +2584,17 @@ reinit_frame_cache (void)
 
   frame_stash_invalidate ();
 
-  /* Since we can't really be sure what the first object allocated was.  */
-  obstack_free (&frame_cache_obstack, 0);
-  obstack_init (&frame_cache_obstack);
+  /* Since we can't really be sure what the first object allocated was.
+     Start a new store instead if some of the caches in this one were
+     retained.  */
+  frame_cache_borrowed.clear ();
+  if (frame_cache_current.use_count () > 1)
+    frame_cache_current = std::make_shared<frame_cache_store> ();
+  else
+    {
+      obstack_free (&frame_cache_current->obstack, 0);
+      obstack_init (&frame_cache_current->obstack);
+    }
 
   for (frame_info_ptr &iter : frame_info_ptr::frame_list)
     iter.invalidate ();
@@ -3332,16 +3796,40 @@ frame_info_ptr::reinflate () const
   return m_ptr;
 }
 
+/* Implement "maintenance set frame-retention".  */
+
+static void
+set_frame_retention (const char *args, int from_tty,
+		     struct cmd_list_element *c)
+{
+  discard_retained_frames ();
+}
+
+/* Implement "maintenance show frame-retention".  */
+
+static void
+show_frame_retention (struct ui_file *file, int from_tty,
+		      struct cmd_list_element *c, const char *value)
+{
+  gdb_printf (file, _("Retaining frames across stops is %s.\n"), value);
+}
+
 void _initialize_frame ();
 void
 _initialize_frame ()
 {
-  obstack_init (&frame_cache_obstack);
+  frame_cache_current = std::make_shared<frame_cache_store> ();
 
   frame_stash_create ();
 
   gdb::observers::target_changed.attach (frame_observer_target_changed,
 					 "frame");
+  gdb::observers::new_objfile.attach (frame_observer_discard_retained,
+				      "frame");
+  gdb::observers::free_objfile.attach (frame_observer_discard_retained,
+				       "frame");
+  gdb::observers::inferior_exit.attach (frame_observer_inferior_exit,
+					"frame");
 
   add_setshow_prefix_cmd ("backtrace", class_maintenance,
 			  _("\
@@ -3380,4 +3868,16 @@ When non-zero, frame specific internal debugging is enabled."),
   add_cmd ("frame-id", class_maintenance, maintenance_print_frame_id,
 	   _("Print the current frame-id."),
 	   &maintenanceprintlist);
+
+  add_setshow_boolean_cmd ("frame-retention", class_maintenance,
+			   &frame_retention_p, _("\
+Set whether unchanged frames are retained across stops."), _("\
+Show whether unchanged frames are retained across stops."), _("\
+When on, the frames of a thread are remembered when it is resumed.  When\n\
+it stops, the unwinding of the frames that are still on the stack,\n\
+unchanged, is not done again."),
+			   set_frame_retention,
+			   show_frame_retention,
+			   &maintenance_set_cmdlist,
+			   &maintenance_show_cmdlist);
 }
@@ -438,6 +438,31 @@ extern bool has_stack_frames ();
    modifies the target invalidating the frame cache).  */
 extern void reinit_frame_cache (void);
 
+/* Remember the frames of the current thread, which the user is about
+   to resume.  When it stops again, the unwinding of those of its
+   frames that are still on the stack, unchanged, can then be skipped.
+   A frame is taken to be unchanged if its code address and ID are the
+   same, if the part of the stack between its stack pointer and its CFA
+   has the same contents, and if the frame inner to it is unchanged
+   too.  This assumes that a function does not change the registers its
+   callers expect to be preserved, other than those it saved in its own
+   frame.  The frames remembered for a thread are kept until
+   retain_frame_cache is called again for it, or
+   discard_retained_frames is called.
+
+   This hashes the stack of each frame, so it is only done once per
+   command resuming the inferior, not each time the frame cache is
+   flushed.  */
+
+extern void retain_frame_cache ();
+
+/* Forget the frames remembered by retain_frame_cache.  This must be
+   done whenever something other than the registers and memory of the
+   thread changes the result of unwinding, e.g. when objfiles are
+   loaded or unwinders are registered.  */
+
+extern void discard_retained_frames ();
+
 /* Return the selected frame.  Always returns non-NULL.  If there
    isn't an inferior sufficient for creating a frame, an error is
    thrown.  When MESSAGE is non-NULL, use it for the error message,
@@ -977,6 +1002,15 @@ extern void frame_prepare_for_sniffer (frame_info_ptr frame,
 
 extern void frame_cleanup_after_sniffer (frame_info_ptr frame);
 
+/* If the frame next to FRAME was found to be unchanged since its
+   thread was last resumed, and FRAME is at the same code address as
+   the frame that was outer to it then, set FRAME's unwinder and its
+   prologue cache *THIS_CACHE to those of that frame, and return true.
+   See retain_frame_cache.  */
+
+extern bool frame_reuse_retained_unwinder (frame_info_ptr frame,
+					   void **this_cache);
+
 /* Notes (cagney/2002-11-27, drow/2003-09-06):
 
    You might think that calls to this function can simply be replaced by a
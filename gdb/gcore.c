@@ -38,12 +38,32 @@
 #include "gdbsupport/gdb_unlinker.h"
 #include "gdbsupport/byte-vector.h"
 #include "gdbsupport/scope-exit.h"
+#include "gdbsupport/filestuff.h"
+#include "gdbsupport/parallel-for.h"
+#include "gdbcmd.h"
+#include "breakpoint.h"
 
 /* The largest amount of memory to read from the target at once.  We
    must throttle it to limit the amount of memory used by GDB during
    generate-core-file for programs with large resident data.  */
 #define MAX_COPY_BYTES (1024 * 1024)
 
+/* The amount of memory the fast dump reads from the target at once,
+   and the size of each of the ranges it is read in.  The ranges are
+   small enough that an unreadable page doesn't lose much around it,
+   and numerous enough that the reads are spread over the worker
+   threads.  */
+#define FAST_COPY_BYTES (64 * 1024 * 1024)
+#define FAST_COPY_RANGE_BYTES (16 * 1024)
+
+/* The granularity at which the fast dump leaves all-zero memory out
+   of the core file, as holes.  */
+#define FAST_COPY_HOLE_BYTES 4096
+
+/* Whether to write the memory of the core file with the fast dump,
+   see gcore_fast_copy_sections.  */
+static bool gcore_fast_dump = false;
+
 static const char *default_gcore_target (void);
 static enum bfd_architecture default_gcore_arch (void);
 static int gcore_memory_sections (bfd *);
@@ -610,6 +630,224 @@ gcore_copy_callback (bfd *obfd, asection *osec)
     }
 }
 
+/* Return true if the LEN bytes at BUF are all zero.  */
+
+static bool
+gcore_zero_p (const gdb_byte *buf, size_t len)
+{
+  return len == 0 || (buf[0] == 0 && memcmp (buf, buf + 1, len - 1) == 0);
+}
+
+/* Write the LEN bytes at BUF to file descriptor FD at file offset
+   OFFSET, leaving the FAST_COPY_HOLE_BYTES blocks that are all zero
+   out as holes.  Return 0 on success, or the errno value of the
+   failed write.  This doesn't use any GDB state, so it can run on
+   worker threads.  */
+
+static int
+gcore_write_sparse (int fd, file_ptr offset, const gdb_byte *buf,
+		    size_t len)
+{
+#ifdef HAVE_PWRITE
+  size_t start = 0;
+  while (start < len)
+    {
+      /* Skip the leading zero blocks, then find the end of the data
+	 up to the next zero block.  */
+      size_t block = std::min (len - start, (size_t) FAST_COPY_HOLE_BYTES);
+      if (gcore_zero_p (buf + start, block))
+	{
+	  start += block;
+	  continue;
+	}
+
+      size_t end = start + block;
+      while (end < len)
+	{
+	  block = std::min (len - end, (size_t) FAST_COPY_HOLE_BYTES);
+	  if (gcore_zero_p (buf + end, block))
+	    break;
+	  end += block;
+	}
+
+      while (start < end)
+	{
+	  ssize_t ret = pwrite (fd, buf + start, end - start, offset + start);
+	  if (ret < 0)
+	    {
+	      if (errno == EINTR)
+		continue;
+	      return errno;
+	    }
+	  start += ret;
+	}
+    }
+
+  return 0;
+#else
+  return ENOSYS;
+#endif
+}
+
+/* Copy the contents of all the "load" sections of OBFD, like
+   gcore_copy_callback does for each of them, but read the memory
+   FAST_COPY_BYTES at a time with target_read_raw_memory_ranges, put
+   the shadows of the inserted breakpoints back, and write it with
+   pwrite on the worker threads, directly at the sections' file
+   positions, without the all-zero blocks.  The sections must all have
+   been created, since their file positions are computed here.
+
+   Return false if the fast dump can't be used, in which case nothing
+   was written.  */
+
+static bool
+gcore_fast_copy_sections (bfd *obfd)
+{
+#ifdef HAVE_PWRITE
+  if (bfd_get_flavour (obfd) != bfd_target_elf_flavour)
+    return false;
+
+  scoped_fd fd = gdb_open_cloexec (bfd_get_filename (obfd), O_WRONLY, 0);
+  if (fd.get () < 0)
+    return false;
+
+  /* Lay the sections out now, as the first bfd_set_section_contents
+     call would, so that their file positions are known.  */
+  if (!_bfd_elf_compute_section_file_positions (obfd, NULL))
+    error (_("Failed to lay out corefile sections (%s)."),
+	   bfd_errmsg (bfd_get_error ()));
+  obfd->output_has_begun = true;
+
+  /* The sections to copy, in the order of their file positions.  */
+  std::vector<asection *> sections;
+  for (asection *osec : gdb_bfd_sections (obfd))
+    if ((bfd_section_flags (osec) & SEC_LOAD) != 0
+	&& startswith (bfd_section_name (osec), "load")
+	&& bfd_section_size (osec) != 0)
+      sections.push_back (osec);
+  std::sort (sections.begin (), sections.end (),
+	     [] (asection *a, asection *b)
+	     {
+	       return a->filepos < b->filepos;
+	     });
+
+  gdb::byte_vector buffer (FAST_COPY_BYTES);
+  std::vector<memory_read_request> requests;
+  std::vector<file_ptr> file_offsets;
+  file_ptr file_end = 0;
+
+  /* Read, then write, the ranges accumulated in REQUESTS.  */
+  auto flush = [&] ()
+    {
+      if (requests.empty ())
+	return;
+
+      if (!target_read_raw_memory_ranges (requests))
+	for (memory_read_request &request : requests)
+	  request.xfered_len = 0;
+
+      /* The raw reads see the breakpoint instructions inserted in the
+	 inferior, if any, e.g. with "set breakpoint always-inserted
+	 on" or in non-stop mode.  Put the shadowed contents back, as
+	 target_read_memory would.  */
+      for (memory_read_request &request : requests)
+	if (request.xfered_len == request.len)
+	  breakpoint_xfer_memory (request.buf, nullptr, nullptr,
+				  request.address, request.len);
+
+      std::atomic<int> write_errno (0);
+      gdb::parallel_for_each (1, (size_t) 0, requests.size (),
+	[&] (size_t first, size_t last)
+	{
+	  for (size_t i = first; i < last; ++i)
+	    {
+	      const memory_read_request &request = requests[i];
+	      if (request.xfered_len != request.len)
+		continue;
+
+	      int err = gcore_write_sparse (fd.get (), file_offsets[i],
+					    request.buf, request.len);
+	      if (err != 0)
+		{
+		  int expected = 0;
+		  write_errno.compare_exchange_strong (expected, err);
+		}
+	    }
+	});
+
+      if (write_errno != 0)
+	error (_("Failed to write corefile contents (%s)."),
+	       safe_strerror (write_errno));
+
+      /* Read the ranges that couldn't be read at once, if any, through
+	 the whole target stack.  */
+      for (size_t i = 0; i < requests.size (); ++i)
+	{
+	  const memory_read_request &request = requests[i];
+	  if (request.xfered_len == request.len)
+	    continue;
+
+	  if (target_read_memory (request.address, request.buf,
+				  request.len) != 0)
+	    {
+	      warning (_("Memory read failed for corefile "
+			 "section, %s bytes at %s."),
+		       pulongest (request.len),
+		       paddress (target_gdbarch (), request.address));
+	      continue;
+	    }
+
+	  int err = gcore_write_sparse (fd.get (), file_offsets[i],
+					request.buf, request.len);
+	  if (err != 0)
+	    error (_("Failed to write corefile contents (%s)."),
+		   safe_strerror (err));
+	}
+
+      requests.clear ();
+      file_offsets.clear ();
+    };
+
+  size_t used = 0;
+  for (asection *osec : sections)
+    {
+      bfd_size_type total_size = bfd_section_size (osec);
+      file_end = std::max (file_end, (file_ptr) (osec->filepos + total_size));
+
+      for (bfd_size_type offset = 0; offset < total_size; )
+	{
+	  if (used == buffer.size ())
+	    {
+	      flush ();
+	      used = 0;
+	    }
+
+	  bfd_size_type size
+	    = std::min ({total_size - offset,
+			 (bfd_size_type) FAST_COPY_RANGE_BYTES,
+			 (bfd_size_type) (buffer.size () - used)});
+	  requests.emplace_back (bfd_section_vma (osec) + offset,
+				 buffer.data () + used, size);
+	  file_offsets.push_back (osec->filepos + offset);
+	  used += size;
+	  offset += size;
+	}
+    }
+  flush ();
+
+  /* Make the file cover the trailing holes, if any.  */
+  struct stat st;
+  if (fstat (fd.get (), &st) == 0 && st.st_size < file_end
+      && ftruncate (fd.get (), file_end) != 0)
+    error (_("Failed to write corefile contents (%s)."),
+	   safe_strerror (errno));
+
+  return true;
+#else
+  return false;
+#endif
+}
+
 /* Callback to copy contents to a particular memory tag section.  */
 
 static void
@@ -652,9 +890,11 @@ gcore_memory_sections (bfd *obfd)
     make_output_phdrs (obfd, sect);
 
   /* Copy memory region and memory tag contents.  */
+  bool fast_copied = gcore_fast_dump && gcore_fast_copy_sections (obfd);
   for (asection *sect : gdb_bfd_sections (obfd))
     {
-      gcore_copy_callback (obfd, sect);
+      if (!fast_copied)
+	gcore_copy_callback (obfd, sect);
       gcore_copy_memtag_section_callback (obfd, sect);
     }
 
@@ -682,6 +922,16 @@ gcore_find_signalled_thread ()
   return nullptr;
 }
 
+/* Implement "show gcore-fast-dump".  */
+
+static void
+show_gcore_fast_dump (struct ui_file *file, int from_tty,
+		      struct cmd_list_element *c, const char *value)
+{
+  gdb_printf (file, _("Writing core files with the fast dump is %s.\n"),
+	      value);
+}
+
 void _initialize_gcore ();
 void
 _initialize_gcore ()
@@ -693,4 +943,16 @@ Usage: generate-core-file [FILENAME]\n\
 Argument is optional filename.  Default filename is 'core.PROCESS_ID'."));
 
   add_com_alias ("gcore", generate_core_file_cmd, class_files, 1);
+
+  add_setshow_boolean_cmd ("gcore-fast-dump", class_files,
+			   &gcore_fast_dump, _("\
+Set whether to write the memory of core files with the fast dump."), _("\
+Show whether to write the memory of core files with the fast dump."), _("\
+When on, generate-core-file reads the memory of the process in large\n\
+batches of ranges, spread over the worker threads when the target\n\
+supports it, writes it directly to the core file, and leaves the pages\n\
+that are all zero out of the file, as holes."),
+			   NULL,
+			   show_gcore_fast_dump,
+			   &setlist, &showlist);
 }
@@ -33,6 +33,9 @@
 #include "gdbsupport/fileio.h"
 #include "inferior.h"
 #include "cli/cli-style.h"
+#include "build-id.h"
+#include "gdbsupport/pathstuff.h"
+#include "gdbsupport/gdb_unlinker.h"
 #include <unordered_map>
 
 /* An object of this type is stored in the section's user data when
@@ -735,6 +738,178 @@ get_section_descriptor (asection *section)
   return result;
 }
 
+/* Whether the section cache is enabled, see section_cache_lookup.  */
+
+static bool section_cache_enabled = false;
+
+/* The directory of the section cache.  */
+
+static std::string section_cache_directory;
+
+/* The suffix of the files of the section cache.  */
+
+#define SECTION_CACHE_SUFFIX ".section"
+
+#ifdef HAVE_MMAP
+
+/* Return the name of the file of the section cache holding the
+   decompressed contents of SECTP, or the empty string if it can't
+   be cached.  */
+
+static std::string
+section_cache_filename (asection *sectp)
+{
+  if (!section_cache_enabled || section_cache_directory.empty ())
+    return {};
+
+  const bfd_build_id *build_id = build_id_bfd_get (sectp->owner);
+  if (build_id == nullptr)
+    return {};
+
+  /* Section names may contain directory separators, in theory.  */
+  const char *name = bfd_section_name (sectp);
+  if (strchr (name, '/') != nullptr || strchr (name, '\\') != nullptr)
+    return {};
+
+  return (section_cache_directory + SLASH_STRING
+	  + build_id_to_string (build_id) + name + SECTION_CACHE_SUFFIX);
+}
+
+/* Map the file FILENAME of the section cache in DESCRIPTOR, if it
+   holds SIZE bytes.  Return true on success.  */
+
+static bool
+section_cache_map (const std::string &filename, bfd_size_type size,
+		   struct gdb_bfd_section_data *descriptor)
+{
+  scoped_fd fd = gdb_open_cloexec (filename, O_RDONLY | O_BINARY, 0);
+  if (fd.get () < 0)
+    return false;
+
+  struct stat st;
+  if (fstat (fd.get (), &st) != 0 || st.st_size != size || size == 0)
+    {
+      bfd_cache_debug_printf ("Section cache file %s has the wrong size",
+			      filename.c_str ());
+      return false;
+    }
+
+  void *data = mmap (nullptr, size, PROT_READ, MAP_SHARED, fd.get (), 0);
+  if (data == MAP_FAILED)
+    return false;
+
+  descriptor->size = size;
+  descriptor->data = data;
+  descriptor->map_addr = data;
+  descriptor->map_len = size;
+  return true;
+}
+
+/* Try to map the decompressed contents of the compressed section
+   SECTP from the section cache, in DESCRIPTOR.  Return true on
+   success.
+
+   The section cache holds the decompressed contents of compressed
+   sections in files named after the build ID of their BFD and the
+   name of the section.  The files are mapped read-only, so that all
+   the GDB processes reading the same sections, e.g. those of several
+   users debugging the same program, share a single copy in the page
+   cache rather than each decompressing its own in its heap.  */
+
+static bool
+section_cache_lookup (asection *sectp,
+		      struct gdb_bfd_section_data *descriptor)
+{
+  std::string filename = section_cache_filename (sectp);
+  if (filename.empty ())
+    return false;
+
+  if (!section_cache_map (filename, bfd_section_size (sectp), descriptor))
+    return false;
+
+  bfd_cache_debug_printf ("Mapped section %s of %s from %s",
+			  bfd_section_name (sectp),
+			  bfd_get_filename (sectp->owner),
+			  filename.c_str ());
+  return true;
+}
+
+/* Store the decompressed contents of the compressed section SECTP,
+   read in DESCRIPTOR, in the section cache.  On success, replace them
+   in DESCRIPTOR with a mapping of the cache file.  */
+
+static void
+section_cache_store (asection *sectp,
+		     struct gdb_bfd_section_data *descriptor)
+{
+  std::string filename = section_cache_filename (sectp);
+  if (filename.empty () || descriptor->size == 0)
+    return;
+
+  try
+    {
+      if (!mkdir_recursive (section_cache_directory.c_str ()))
+	{
+	  warning (_("section cache: could not make cache directory: %s"),
+		   safe_strerror (errno));
+	  return;
+	}
+
+      /* Write a temporary file, and move it in place once complete, so
+	 that other GDB processes never see a partial file.  */
+      gdb::char_vector filename_temp = make_temp_filename (filename);
+      scoped_fd fd = gdb_mkostemp_cloexec (filename_temp.data (), O_BINARY);
+      if (fd.get () == -1)
+	perror_with_name (("mkstemp"));
+      gdb::unlinker unlink_file (filename_temp.data ());
+
+      /* Whoever can get to the cache directory may read the file.  */
+      fchmod (fd.get (), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+      const gdb_byte *data = (const gdb_byte *) descriptor->data;
+      bfd_size_type left = descriptor->size;
+      while (left > 0)
+	{
+	  ssize_t ret = write (fd.get (), data, left);
+	  if (ret < 0)
+	    {
+	      if (errno == EINTR)
+		continue;
+	      perror_with_name (filename_temp.data ());
+	    }
+	  data += ret;
+	  left -= ret;
+	}
+
+      if (rename (filename_temp.data (), filename.c_str ()) != 0)
+	perror_with_name (("rename"));
+      unlink_file.keep ();
+    }
+  catch (const gdb_exception_error &except)
+    {
+      bfd_cache_debug_printf ("Couldn't store section %s of %s: %s",
+			      bfd_section_name (sectp),
+			      bfd_get_filename (sectp->owner),
+			      except.what ());
+      return;
+    }
+
+  bfd_cache_debug_printf ("Stored section %s of %s in %s",
+			  bfd_section_name (sectp),
+			  bfd_get_filename (sectp->owner),
+			  filename.c_str ());
+
+  /* Share the copy in the page cache with the other processes.  */
+  struct gdb_bfd_section_data mapped {};
+  if (section_cache_map (filename, descriptor->size, &mapped))
+    {
+      xfree (descriptor->data);
+      *descriptor = mapped;
+    }
+}
+
+#endif /* HAVE_MMAP */
+
 /* See gdb_bfd.h.  */
 
 const gdb_byte *
@@ -788,6 +963,8 @@ gdb_bfd_map_section (asection *sectp, bfd_size_type *size)
 	  memset (descriptor, 0, sizeof (*descriptor));
 	}
     }
+  else if (section_cache_lookup (sectp, descriptor))
+    goto done;
 #endif /* HAVE_MMAP */
 
   /* Handle compressed sections, or ordinary uncompressed sections in
@@ -809,6 +986,11 @@ gdb_bfd_map_section (asection *sectp, bfd_size_type *size)
     }
   descriptor->data = data;
 
+#ifdef HAVE_MMAP
+  if (bfd_is_section_compressed (abfd, sectp))
+    section_cache_store (sectp, descriptor);
+#endif
+
  done:
   gdb_assert (descriptor->data != NULL);
   *size = descriptor->size;
@@ -1166,6 +1348,41 @@ gdb_bfd_error_handler (const char *fmt, va_list ap)
   (*default_bfd_error_handler) (fmt, ap);
 }
 
+/* The "set section-cache" and "show section-cache" prefix lists.  */
+
+static cmd_list_element *set_section_cache_list;
+static cmd_list_element *show_section_cache_list;
+
+/* Implement "show section-cache enabled".  */
+
+static void
+show_section_cache_enabled (struct ui_file *file, int from_tty,
+			    struct cmd_list_element *c, const char *value)
+{
+  gdb_printf (file, _("The section cache is %s.\n"), value);
+}
+
+/* Implement "set section-cache directory".  */
+
+static void
+set_section_cache_directory (const char *args, int from_tty,
+			     struct cmd_list_element *c)
+{
+  /* Make sure the directory is absolute and tilde-expanded.  */
+  if (!section_cache_directory.empty ())
+    section_cache_directory = gdb_abspath (section_cache_directory.c_str ());
+}
+
+/* Implement "show section-cache directory".  */
+
+static void
+show_section_cache_directory (struct ui_file *file, int from_tty,
+			      struct cmd_list_element *c, const char *value)
+{
+  gdb_printf (file, _("The directory of the section cache is \"%ps\".\n"),
+	      styled_string (file_name_style.style (), value));
+}
+
 void _initialize_gdb_bfd ();
 void
 _initialize_gdb_bfd ()
@@ -1199,6 +1416,37 @@ When non-zero, bfd cache specific debugging is enabled."),
 			   &show_bfd_cache_debug,
 			   &setdebuglist, &showdebuglist);
 
+  /* The section cache shares the directory of the index cache.  */
+  section_cache_directory = get_standard_cache_dir ();
+
+  add_basic_prefix_cmd ("section-cache", class_files,
+			_("Set section-cache options."),
+			&set_section_cache_list, false, &setlist);
+  add_show_prefix_cmd ("section-cache", class_files,
+		       _("Show section-cache options."),
+		       &show_section_cache_list, false, &showlist);
+
+  add_setshow_boolean_cmd ("enabled", class_files,
+			   &section_cache_enabled, _("\
+Enable the section cache."), _("\
+Show whether the section cache is enabled."), _("\
+When on, GDB keeps the decompressed contents of the compressed sections\n\
+of files with a build ID in the section cache directory, and maps them\n\
+from there, so that all the GDB processes using the same directory\n\
+share them."),
+			   NULL,
+			   show_section_cache_enabled,
+			   &set_section_cache_list, &show_section_cache_list);
+
+  add_setshow_filename_cmd ("directory", class_files,
+			    &section_cache_directory, _("\
+Set the directory of the section cache."), _("\
+Show the directory of the section cache."), NULL,
+			    set_section_cache_directory,
+			    show_section_cache_directory,
+			    &set_section_cache_list,
+			    &show_section_cache_list);
+
   /* Hook the BFD error/warning handler to limit amount of output.  */
   default_bfd_error_handler = bfd_set_error_handler (gdb_bfd_error_handler);
 }
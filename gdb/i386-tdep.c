@@ -23,6 +23,7 @@
 #include "command.h"
 #include "dummy-frame.h"
 #include "dwarf2/frame.h"
+#include "sframe-unwind.h"
 #include "frame.h"
 #include "frame-base.h"
 #include "frame-unwind.h"
@@ -8670,9 +8671,11 @@ i386_gdbarch_init (struct gdbarch_info info, struct gdbarch_list *arches)
   if (info.bfd_arch_info->bits_per_word == 32)
     frame_unwind_append_unwinder (gdbarch, &i386_epilogue_override_frame_unwind);
 
-  /* Hook in the DWARF CFI frame unwinder.  This unwinder is appended
-     to the list before the prologue-based unwinders, so that DWARF
-     CFI info will be used if it is available.  */
+  /* Hook in the SFrame and DWARF CFI frame unwinders.  These unwinders
+     are appended to the list before the prologue-based unwinders, so
+     that SFrame or DWARF CFI info will be used if it is available.  The
+     SFrame unwinder only handles AMD64 frames.  */
+  sframe_append_unwinders (gdbarch);
   dwarf2_append_unwinders (gdbarch);
 
   if (info.bfd_arch_info->bits_per_word == 32)
@@ -3285,6 +3285,10 @@ proceed (CORE_ADDR addr, enum gdb_signal siggnal)
   struct gdbarch *gdbarch;
   CORE_ADDR pc;
 
+  /* Remember the frames of the thread the user resumes, while they
+     still match its registers and stack.  */
+  retain_frame_cache ();
+
   /* If we're stopped at a fork/vfork, follow the branch set by the
      "set follow-fork-mode" command; otherwise, we'll just proceed
      resuming the current thread.  */
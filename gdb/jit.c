@@ -188,6 +188,7 @@ jit_reader_load_command (const char *args, int from_tty)
 		       SLASH_STRING, file.get ());
 
   loaded_jit_reader = jit_reader_load (file.get ());
+  discard_retained_frames ();
   reinit_frame_cache ();
   jit_inferior_created_hook (current_inferior ());
 }
@@ -200,6 +201,7 @@ jit_reader_unload_command (const char *args, int from_tty)
   if (!loaded_jit_reader)
     error (_("No JIT reader loaded."));
 
+  discard_retained_frames ();
   reinit_frame_cache ();
   jit_inferior_exit_hook (current_inferior ());
 
@@ -1144,6 +1144,36 @@ maybe_add_address (htab_t set, struct program_space *pspace, CORE_ADDR addr)
   return 1;
 }
 
+/* If not NULL, the only objfiles searched when decoding a linespec.
+   See scoped_linespec_objfile_filter.  */
+
+static const std::unordered_set<objfile *> *linespec_objfile_filter;
+
+/* See linespec.h.  */
+
+scoped_linespec_objfile_filter::scoped_linespec_objfile_filter
+  (const std::unordered_set<objfile *> &objfiles)
+  : m_saved (linespec_objfile_filter)
+{
+  linespec_objfile_filter = &objfiles;
+}
+
+/* See linespec.h.  */
+
+scoped_linespec_objfile_filter::~scoped_linespec_objfile_filter ()
+{
+  linespec_objfile_filter = m_saved;
+}
+
+/* Return true if decoding a linespec should search OBJFILE.  */
+
+static bool
+linespec_searches_objfile (objfile *objfile)
+{
+  return (linespec_objfile_filter == nullptr
+	  || linespec_objfile_filter->count (objfile) != 0);
+}
+
 /* A helper that walks over all matching symtabs in all objfiles and
    calls CALLBACK for each symbol matching NAME.  If SEARCH_PSPACE is
    not NULL, then the search is restricted to just that program
@@ -1170,6 +1200,9 @@ iterate_over_all_matching_symtabs
 
       for (objfile *objfile : current_program_space->objfiles ())
 	{
+	  if (!linespec_searches_objfile (objfile))
+	    continue;
+
 	  objfile->expand_symtabs_matching (NULL, &lookup_name, NULL, NULL,
 					    (SEARCH_GLOBAL_BLOCK
 					     | SEARCH_STATIC_BLOCK),
@@ -3674,6 +3707,9 @@ symtab_collector::operator () (struct symtab *symtab)
 {
   void **slot;
 
+  if (!linespec_searches_objfile (symtab->compunit ()->objfile ()))
+    return false;
+
   slot = htab_find_slot (m_symtab_table.get (), symtab, INSERT);
   if (!*slot)
     {
@@ -4224,6 +4260,9 @@ search_minsyms_for_name (struct collect_info *info,
 
 	  for (objfile *objfile : current_program_space->objfiles ())
 	    {
+	      if (!linespec_searches_objfile (objfile))
+		continue;
+
 	      iterate_over_minimal_symbols (objfile, name,
 					    [&] (struct minimal_symbol *msym)
 					    {
@@ -20,6 +20,7 @@
 struct symtab;
 
 #include "location.h"
+#include <unordered_set>
 
 /* Flags to pass to decode_line_1 and decode_line_full.  */
 
@@ -131,6 +132,29 @@ extern void decode_line_full (struct location_spec *locspec, int flags,
 			      const char *select_mode,
 			      const char *filter);
 
+/* While an instance of this class is alive, decoding a linespec only
+   searches the symbols, minimal symbols and source files of the given
+   objfiles, instead of those of all the objfiles.  This is used to
+   find out whether objfiles that were just added match a location
+   spec.  Some lookups, like the default source file or Objective-C
+   selectors, are not restricted, so results outside of these objfiles
+   may still be returned.  */
+
+class scoped_linespec_objfile_filter
+{
+public:
+  explicit scoped_linespec_objfile_filter
+    (const std::unordered_set<objfile *> &objfiles);
+  ~scoped_linespec_objfile_filter ();
+
+  DISABLE_COPY_AND_ASSIGN (scoped_linespec_objfile_filter);
+
+private:
+
+  /* The filter that was in effect before this one.  */
+  const std::unordered_set<objfile *> *m_saved;
+};
+
 /* Given a string, return the line specified by it, using the current
    source symtab and line as defaults.
    This is for commands like "list" and "breakpoint".  */
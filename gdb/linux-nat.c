@@ -54,6 +54,7 @@
 #include <dirent.h>
 #include "xml-support.h"
 #include <sys/vfs.h>
+#include <sys/uio.h>
 #include "solib.h"
 #include "nat/linux-osdata.h"
 #include "linux-tdep.h"
@@ -69,6 +70,9 @@
 #include "gdbsupport/scope-exit.h"
 #include "gdbsupport/gdb-sigmask.h"
 #include "gdbsupport/common-debug.h"
+#include "gdbsupport/parallel-for.h"
+#include "ax-gdb.h"
+#include <map>
 #include <unordered_map>
 
 /* This comment documents high-level logic of this file.
@@ -246,6 +250,9 @@ static void save_stop_reason (struct lwp_info *lp);
 static bool proc_mem_file_is_writable ();
 static void close_proc_mem_file (pid_t pid);
 static void open_proc_mem_file (ptid_t ptid);
+static enum target_xfer_status linux_proc_xfer_memory_partial
+  (int pid, gdb_byte *readbuf, const gdb_byte *writebuf, ULONGEST offset,
+   LONGEST len, ULONGEST *xfered_len);
 
 /* Return TRUE if LWP is the leader thread of the process.  */
 
@@ -3118,6 +3125,307 @@ filter_exit_event (struct lwp_info *event_child,
   return ptid;
 }
 
+/* Target-side breakpoint conditions and commands.
+
+   When GDB lets the target evaluate breakpoint conditions, or run the
+   commands of agent-style dprintf breakpoints, each software
+   breakpoint inserted with such bytecode is recorded here.  When an
+   LWP reports a hit of one of them, the bytecode is evaluated while
+   the event is being pulled out of the kernel.  If the hit is not to
+   be reported, the LWP is stepped over the breakpoint and resumed
+   without the event ever reaching the core.  */
+
+struct breakpoint_agent
+{
+  /* The original contents of memory at the breakpoint address, and
+     the breakpoint instruction that replaces them.  */
+  gdb::byte_vector shadow;
+  gdb::byte_vector insn;
+
+  /* Copies of the condition and command bytecodes.  */
+  std::vector<agent_expr_up> conditions;
+  std::vector<agent_expr_up> commands;
+};
+
+/* The breakpoints with target-side conditions or commands, indexed by
+   address space and address.  */
+
+static std::map<std::pair<const address_space *, CORE_ADDR>,
+		breakpoint_agent> breakpoint_agents;
+
+/* Read LEN bytes at ADDR from the memory of process PID, without
+   looking through inserted breakpoints.  Return true on success.  */
+
+static bool
+linux_nat_read_raw_memory (int pid, CORE_ADDR addr, gdb_byte *buf, int len)
+{
+  while (len > 0)
+    {
+      ULONGEST xfered_len;
+
+      if (linux_proc_xfer_memory_partial (pid, buf, nullptr, addr, len,
+					  &xfered_len) != TARGET_XFER_OK)
+	return false;
+
+      addr += xfered_len;
+      buf += xfered_len;
+      len -= xfered_len;
+    }
+
+  return true;
+}
+
+/* Write LEN bytes from BUF at ADDR in the memory of process PID.
+   Return true on success.  */
+
+static bool
+linux_nat_write_raw_memory (int pid, CORE_ADDR addr, const gdb_byte *buf,
+			    int len)
+{
+  while (len > 0)
+    {
+      ULONGEST xfered_len;
+
+      if (linux_proc_xfer_memory_partial (pid, nullptr, buf, addr, len,
+					  &xfered_len) != TARGET_XFER_OK)
+	return false;
+
+      addr += xfered_len;
+      buf += xfered_len;
+      len -= xfered_len;
+    }
+
+  return true;
+}
+
+/* Record the conditions and commands of the software breakpoint
+   described by BP_TGT, which has just been inserted in the current
+   inferior, if they can all be evaluated here.  Return false if they
+   can't.  */
+
+static bool
+record_breakpoint_agent (struct bp_target_info *bp_tgt)
+{
+  if (bp_tgt->conditions.empty () && bp_tgt->tcommands.empty ())
+    return true;
+
+  if (inferior_ptid == null_ptid || !proc_mem_file_is_writable ())
+    return false;
+
+  breakpoint_agent agent;
+
+  auto copy_bytecode = [] (const agent_expr *ax,
+			   std::vector<agent_expr_up> &to)
+    {
+      if (!ax_host_eval_p (ax))
+	return false;
+
+      agent_expr_up copy (new agent_expr (ax->gdbarch, ax->scope));
+      copy->buf = ax->buf;
+      to.push_back (std::move (copy));
+      return true;
+    };
+
+  for (const agent_expr *ax : bp_tgt->conditions)
+    if (!copy_bytecode (ax, agent.conditions))
+      return false;
+
+  for (const agent_expr *ax : bp_tgt->tcommands)
+    if (!copy_bytecode (ax, agent.commands))
+      return false;
+
+  int len = bp_tgt->shadow_len;
+  agent.shadow.assign (bp_tgt->shadow_contents,
+		       bp_tgt->shadow_contents + len);
+  agent.insn.resize (len);
+  if (!linux_nat_read_raw_memory (inferior_ptid.pid (),
+				  bp_tgt->placed_address,
+				  agent.insn.data (), len))
+    return false;
+
+  breakpoint_agents.emplace (std::make_pair (bp_tgt->placed_address_space,
+					     bp_tgt->placed_address),
+			     std::move (agent));
+  return true;
+}
+
+/* Step LP, which is stopped at the breakpoint described by AGENT,
+   over it, with all other LWPs of its process stopped meanwhile.  The
+   other LWPs are left stopped, to be resumed by
+   resume_stopped_resumed_lwps like after any other event.  */
+
+static void
+linux_nat_step_over_breakpoint (struct lwp_info *lp,
+				const breakpoint_agent &agent,
+				CORE_ADDR pc)
+{
+  ptid_t ptid = lp->ptid;
+  int pid = ptid.pid ();
+
+  iterate_over_lwps (ptid_t (pid), stop_callback);
+  iterate_over_lwps (ptid_t (pid), stop_wait_callback);
+
+  linux_nat_write_raw_memory (pid, pc, agent.shadow.data (),
+			      agent.shadow.size ());
+
+  lp->status = 0;
+  lp->stop_reason = TARGET_STOPPED_BY_NO_REASON;
+  linux_resume_one_lwp (lp, 1, GDB_SIGNAL_0);
+
+  int status = lp->stopped ? 0 : wait_lwp (lp);
+
+  /* LP may be gone by now.  */
+  lp = find_lwp_pid (ptid);
+
+  /* Don't write the breakpoint into the image of a new program.  */
+  if (lp == nullptr || lp->waitstatus.kind () != TARGET_WAITKIND_EXECD)
+    linux_nat_write_raw_memory (pid, pc, agent.insn.data (),
+				agent.insn.size ());
+
+  if (lp == nullptr)
+    return;
+
+  if (status != 0)
+    {
+      /* Keep the event pending if it is anything but the end of the
+	 step, e.g., a signal or a watchpoint trigger.  */
+      lp->status = status;
+      save_stop_reason (lp);
+      if (WSTOPSIG (status) == SIGTRAP
+	  && lp->stop_reason == TARGET_STOPPED_BY_NO_REASON)
+	lp->status = 0;
+    }
+
+  lp->step = 0;
+}
+
+/* Callback for iterate_over_lwps.  If LP has a pending hit of a
+   breakpoint whose target-side conditions are all false, or whose
+   target-side commands have run, step LP over the breakpoint,
+   discarding the event, and return 1.  Otherwise, return 0.  */
+
+static int
+filter_breakpoint_hit_callback (struct lwp_info *lp)
+{
+  if (!lp->resumed
+      || !lp->stopped
+      || lp->signalled
+      || lp->step
+      || lp->last_resume_kind != resume_continue
+      || lp->status == 0
+      || !WIFSTOPPED (lp->status)
+      || WSTOPSIG (lp->status) != SIGTRAP
+      || lp->waitstatus.kind () != TARGET_WAITKIND_IGNORE
+      || lp->stop_reason != TARGET_STOPPED_BY_SW_BREAKPOINT)
+    return 0;
+
+  inferior *inf = find_inferior_ptid (linux_target, lp->ptid);
+  if (inf == nullptr || inf->starting_up || inf->vfork_child != nullptr)
+    return 0;
+
+  int pid = lp->ptid.pid ();
+  struct regcache *regcache = get_thread_regcache (linux_target, lp->ptid);
+  struct gdbarch *gdbarch = regcache->arch ();
+
+  /* We need hardware single-stepping to step over the breakpoint.  */
+  if (gdbarch_software_single_step_p (gdbarch))
+    return 0;
+
+  CORE_ADDR pc = regcache_read_pc (regcache);
+  if (pc != lp->stop_pc)
+    return 0;
+
+  auto it = breakpoint_agents.find (std::make_pair (regcache->aspace (), pc));
+  if (it == breakpoint_agents.end ())
+    return 0;
+
+  const breakpoint_agent &agent = it->second;
+  gdb::byte_vector insn (agent.insn.size ());
+
+  if (!software_breakpoint_inserted_here_p (regcache->aspace (), pc)
+      || !linux_nat_read_raw_memory (pid, pc, insn.data (), insn.size ())
+      || insn != agent.insn)
+    return 0;
+
+  auto read_memory = [pid] (CORE_ADDR addr, gdb_byte *buf, int len)
+    {
+      return linux_nat_read_raw_memory (pid, addr, buf, len);
+    };
+
+  /* Like GDBserver, report the hit if any condition is true or fails
+     to evaluate, unless there are commands to run instead.  */
+  bool report = false;
+  bool hit = agent.conditions.empty ();
+
+  try
+    {
+      for (const agent_expr_up &cond : agent.conditions)
+	{
+	  ULONGEST value;
+
+	  if (cond->gdbarch != gdbarch
+	      || !ax_host_eval (cond.get (), regcache, read_memory, &value))
+	    {
+	      report = true;
+	      break;
+	    }
+
+	  if (value != 0)
+	    {
+	      hit = true;
+	      break;
+	    }
+	}
+
+      if (hit && !report)
+	{
+	  report = agent.commands.empty ();
+
+	  for (const agent_expr_up &cmd : agent.commands)
+	    {
+	      ULONGEST value;
+
+	      if (cmd->gdbarch != gdbarch
+		  || !ax_host_eval (cmd.get (), regcache, read_memory, &value))
+		{
+		  report = true;
+		  break;
+		}
+	    }
+	}
+    }
+  catch (const gdb_exception_error &ex)
+    {
+      report = true;
+    }
+
+  if (report)
+    return 0;
+
+  linux_nat_debug_printf ("%s hit breakpoint at %s, not reporting",
+			  lp->ptid.to_string ().c_str (),
+			  paddress (gdbarch, pc));
+
+  linux_nat_step_over_breakpoint (lp, agent, pc);
+  return 1;
+}
+
+/* Step any LWP with a pending hit of a breakpoint that is not to be
+   reported over it.  See breakpoint_agent.  */
+
+static void
+filter_breakpoint_hits ()
+{
+  if (breakpoint_agents.empty ())
+    return;
+
+  /* Stepping an LWP over a breakpoint may add or delete LWPs, so
+     start over after each one.  */
+  while (iterate_over_lwps (minus_one_ptid,
+			    filter_breakpoint_hit_callback) != nullptr)
+    ;
+}
+
 static ptid_t
 linux_nat_wait_1 (ptid_t ptid, struct target_waitstatus *ourstatus,
 		  target_wait_flags target_options)
@@ -3145,6 +3453,10 @@ linux_nat_wait_1 (ptid_t ptid, struct target_waitstatus *ourstatus,
   /* Make sure SIGCHLD is blocked until the sigsuspend below.  */
   block_child_signals (&prev_mask);
 
+  /* Discard the pending breakpoint hits the core doesn't need to
+     see.  */
+  filter_breakpoint_hits ();
+
   /* First check if there is a LWP with a wait status pending.  */
   lp = iterate_over_lwps (ptid, status_callback);
   if (lp != NULL)
@@ -3194,8 +3506,10 @@ linux_nat_wait_1 (ptid_t ptid, struct target_waitstatus *ourstatus,
 	  continue;
 	}
 
-      /* Now that we've pulled all events out of the kernel, resume
+      /* Now that we've pulled all events out of the kernel, handle
+	 the breakpoint hits the core doesn't need to see, and resume
 	 LWPs that don't have an interesting event to report.  */
+      filter_breakpoint_hits ();
       iterate_over_lwps (minus_one_ptid,
 			 [] (struct lwp_info *info)
 			 {
@@ -3588,6 +3902,14 @@ linux_nat_target::mourn_inferior ()
 
   close_proc_mem_file (pid);
 
+  /* Forget the target-side conditions of the process' breakpoints.  */
+  const address_space *aspace = current_inferior ()->aspace;
+  for (auto it = breakpoint_agents.begin (); it != breakpoint_agents.end (); )
+    if (it->first.first == aspace)
+      it = breakpoint_agents.erase (it);
+    else
+      ++it;
+
   if (! forks_exist_p ())
     /* Normal case, no other forks available.  */
     inf_ptrace_target::mourn_inferior ();
@@ -3673,11 +3995,6 @@ linux_nat_xfer_osdata (enum target_object object,
 		       const gdb_byte *writebuf, ULONGEST offset, ULONGEST len,
 		       ULONGEST *xfered_len);
 
-static enum target_xfer_status
-linux_proc_xfer_memory_partial (int pid, gdb_byte *readbuf,
-				const gdb_byte *writebuf, ULONGEST offset,
-				LONGEST len, ULONGEST *xfered_len);
-
 enum target_xfer_status
 linux_nat_target::xfer_partial (enum target_object object,
 				const char *annex, gdb_byte *readbuf,
@@ -3972,6 +4289,142 @@ linux_proc_xfer_memory_partial (int pid, gdb_byte *readbuf,
 					    len, xfered_len);
 }
 
+#ifdef __NR_process_vm_readv
+
+/* The maximum number of ranges the kernel accepts in a single
+   process_vm_readv call, UIO_MAXIOV.  */
+static const size_t max_process_vm_readv_ranges = 1024;
+
+/* Read the memory ranges of REQUESTS from process PID with as few
+   process_vm_readv calls as possible, and set the xfered_len of each
+   request.  ADDR_MASK is applied to the addresses.  Return the errno
+   value of the first call if it shows that process_vm_readv isn't
+   usable, 0 otherwise.  This doesn't use any GDB state, so it can run
+   on worker threads.  */
+
+static int
+linux_proc_read_memory_ranges_1 (int pid,
+				 gdb::array_view<memory_read_request> requests,
+				 ULONGEST addr_mask)
+{
+  const size_t max_ranges = max_process_vm_readv_ranges;
+  std::vector<struct iovec> local (std::min (requests.size (), max_ranges));
+  std::vector<struct iovec> remote (local.size ());
+
+  size_t i = 0;
+  while (i < requests.size ())
+    {
+      size_t count = std::min (requests.size () - i, max_ranges);
+      for (size_t j = 0; j < count; ++j)
+	{
+	  memory_read_request &request = requests[i + j];
+	  local[j].iov_base = request.buf;
+	  local[j].iov_len = request.len;
+	  remote[j].iov_base
+	    = (void *) (uintptr_t) (request.address & addr_mask);
+	  remote[j].iov_len = request.len;
+	}
+
+      ssize_t ret = syscall (__NR_process_vm_readv, pid, local.data (),
+			     count, remote.data (), count, 0);
+      if (ret == -1)
+	{
+	  /* The system call isn't available, or not allowed.  */
+	  if (i == 0 && (errno == ENOSYS || errno == EPERM))
+	    return errno;
+
+	  /* The first range isn't readable, retry from the next one.  */
+	  ret = 0;
+	}
+
+      /* The kernel stops at the first byte it can't read, so skip the
+	 ranges that were read completely, and the one where the read
+	 stopped, which may have been read partially.  The ranges after
+	 it weren't read at all, retry from the next one.  */
+      size_t end = i + count;
+      for (; i < end; ++i)
+	{
+	  if (ret < (ssize_t) requests[i].len)
+	    {
+	      requests[i++].xfered_len = ret;
+	      break;
+	    }
+	  requests[i].xfered_len = requests[i].len;
+	  ret -= requests[i].len;
+	}
+    }
+
+  return 0;
+}
+
+#endif
+
+/* Read the memory ranges of REQUESTS from process PID, and set the
+   xfered_len of each request.  ADDR_MASK is applied to the addresses.
+   Return false if process_vm_readv isn't usable.
+
+   The reads of many ranges, e.g. the tops of the stacks of thousands
+   of threads, are spread over the worker threads.  */
+
+static bool
+linux_proc_read_memory_ranges (int pid,
+			       gdb::array_view<memory_read_request> requests,
+			       ULONGEST addr_mask)
+{
+#ifdef __NR_process_vm_readv
+  /* Probe with the first batch of ranges, so that the workers don't
+     all find out that the system call isn't usable.  */
+  size_t first_count = std::min (requests.size (),
+				 max_process_vm_readv_ranges);
+  int err = linux_proc_read_memory_ranges_1 (pid,
+					     requests.slice (0, first_count),
+					     addr_mask);
+  if (err != 0)
+    {
+      linux_nat_debug_printf ("process_vm_readv for pid %d failed: %s (%d)",
+			      pid, safe_strerror (err), err);
+      return false;
+    }
+
+  gdb::parallel_for_each (max_process_vm_readv_ranges,
+			  first_count, requests.size (),
+    [&] (size_t first, size_t last)
+    {
+      linux_proc_read_memory_ranges_1 (pid,
+				       requests.slice (first, last - first),
+				       addr_mask);
+    });
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+/* Implement the "read_raw_memory_ranges" target method.  */
+
+bool
+linux_nat_target::read_raw_memory_ranges
+  (gdb::array_view<memory_read_request> requests)
+{
+  if (inferior_ptid == null_ptid)
+    return false;
+
+  /* Don't read the memory of a process whose /proc/PID/mem file isn't
+     open, e.g. after it execed, see open_proc_mem_file.  */
+  int pid = inferior_ptid.pid ();
+  if (proc_mem_file_map.find (pid) == proc_mem_file_map.end ())
+    return false;
+
+  /* Mask the addresses like xfer_partial.  */
+  ULONGEST addr_mask = ~(ULONGEST) 0;
+  int addr_bit = gdbarch_addr_bit (target_gdbarch ());
+  if (addr_bit < (sizeof (ULONGEST) * HOST_CHAR_BIT))
+    addr_mask = ((ULONGEST) 1 << addr_bit) - 1;
+
+  return linux_proc_read_memory_ranges (pid, requests, addr_mask);
+}
+
 /* Check whether /proc/pid/mem is writable in the current kernel, and
    return true if so.  It wasn't writable before Linux 2.6.39, but
    there's no way to know whether the feature was backported to older
@@ -4197,6 +4650,73 @@ linux_nat_target::supports_disable_randomization ()
   return true;
 }
 
+/* Implement the "insert_breakpoint" target_ops method.  */
+
+int
+linux_nat_target::insert_breakpoint (struct gdbarch *gdbarch,
+				     struct bp_target_info *bp_tgt)
+{
+  /* This may be a reinsertion to update the conditions.  */
+  breakpoint_agents.erase (std::make_pair (bp_tgt->placed_address_space,
+					   bp_tgt->placed_address));
+
+  int ret = inf_ptrace_target::insert_breakpoint (gdbarch, bp_tgt);
+
+  /* Tell GDB to evaluate the conditions and run the commands itself if
+     they can't be done here.  */
+  if (ret == 0 && !record_breakpoint_agent (bp_tgt))
+    {
+      bp_tgt->conditions.clear ();
+      bp_tgt->tcommands.clear ();
+    }
+
+  return ret;
+}
+
+/* Implement the "remove_breakpoint" target_ops method.  */
+
+int
+linux_nat_target::remove_breakpoint (struct gdbarch *gdbarch,
+				     struct bp_target_info *bp_tgt,
+				     enum remove_bp_reason reason)
+{
+  /* When detaching breakpoints from a fork child, the parent keeps
+     them.  */
+  if (reason == REMOVE_BREAKPOINT)
+    breakpoint_agents.erase (std::make_pair (bp_tgt->placed_address_space,
+					     bp_tgt->placed_address));
+
+  return inf_ptrace_target::remove_breakpoint (gdbarch, bp_tgt, reason);
+}
+
+/* Return whether the breakpoint hits of the current inferior can be
+   filtered with their target-side bytecode.  Discarding a hit steps
+   the LWP over the breakpoint with hardware single-stepping, see
+   filter_breakpoint_hit_callback.  */
+
+static bool
+linux_nat_can_filter_breakpoint_hits ()
+{
+  return !gdbarch_software_single_step_p (target_gdbarch ());
+}
+
+/* Implement the "supports_evaluation_of_breakpoint_conditions"
+   target_ops method.  */
+
+bool
+linux_nat_target::supports_evaluation_of_breakpoint_conditions ()
+{
+  return linux_nat_can_filter_breakpoint_hits ();
+}
+
+/* Implement the "can_run_breakpoint_commands" target_ops method.  */
+
+bool
+linux_nat_target::can_run_breakpoint_commands ()
+{
+  return linux_nat_can_filter_breakpoint_hits ();
+}
+
 /* SIGCHLD handler that serves two purposes: In non-stop/async mode,
    so we notice when any child changes state, and notify the
    event-loop; it allows us to use sigsuspend in linux_nat_wait_1
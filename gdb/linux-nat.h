@@ -57,6 +57,9 @@ class linux_nat_target : public inf_ptrace_target
 					ULONGEST offset, ULONGEST len,
 					ULONGEST *xfered_len) override;
 
+  bool read_raw_memory_ranges
+    (gdb::array_view<memory_read_request> requests) override;
+
   void kill () override;
 
   void mourn_inferior () override;
@@ -95,6 +98,13 @@ class linux_nat_target : public inf_ptrace_target
 
   bool supports_disable_randomization () override;
 
+  int insert_breakpoint (struct gdbarch *, struct bp_target_info *) override;
+  int remove_breakpoint (struct gdbarch *, struct bp_target_info *,
+			 enum remove_bp_reason) override;
+
+  bool supports_evaluation_of_breakpoint_conditions () override;
+  bool can_run_breakpoint_commands () override;
+
   int core_of_thread (ptid_t ptid) override;
 
   bool filesystem_is_local () override;
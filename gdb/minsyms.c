@@ -190,40 +190,6 @@ msymbol_hash (const char *string)
   return hash;
 }
 
-/* Add the minimal symbol SYM to an objfile's minsym hash table, TABLE.  */
-static void
-add_minsym_to_hash_table (struct minimal_symbol *sym,
-			  struct minimal_symbol **table,
-			  unsigned int hash_value)
-{
-  if (sym->hash_next == NULL)
-    {
-      unsigned int hash = hash_value % MINIMAL_SYMBOL_HASH_SIZE;
-
-      sym->hash_next = table[hash];
-      table[hash] = sym;
-    }
-}
-
-/* Add the minimal symbol SYM to an objfile's minsym demangled hash table,
-   TABLE.  */
-static void
-add_minsym_to_demangled_hash_table (struct minimal_symbol *sym,
-				    struct objfile *objfile,
-				    unsigned int hash_value)
-{
-  if (sym->demangled_hash_next == NULL)
-    {
-      objfile->per_bfd->demangled_hash_languages.set (sym->language ());
-
-      struct minimal_symbol **table
-	= objfile->per_bfd->msymbol_demangled_hash;
-      unsigned int hash_index = hash_value % MINIMAL_SYMBOL_HASH_SIZE;
-      sym->demangled_hash_next = table[hash_index];
-      table[hash_index] = sym;
-    }
-}
-
 /* Worker object for lookup_minimal_symbol.  Stores temporary results
    while walking the symbol tables.  */
 
@@ -1351,36 +1317,161 @@ struct computed_hash_values
   unsigned int minsym_demangled_hash;
 };
 
+/* The bucket chains of the minimal symbol hash tables, built from a
+   range of the minimal symbols.  */
+
+struct minimal_symbol_hash_chains
+{
+  minimal_symbol_hash_chains ()
+    : heads (MINIMAL_SYMBOL_HASH_SIZE),
+      tails (MINIMAL_SYMBOL_HASH_SIZE),
+      demangled_heads (MINIMAL_SYMBOL_HASH_SIZE),
+      demangled_tails (MINIMAL_SYMBOL_HASH_SIZE)
+  {
+  }
+
+  /* The first and the last symbol of the chain of each bucket of
+     msymbol_hash.  */
+  std::vector<minimal_symbol *> heads;
+  std::vector<minimal_symbol *> tails;
+
+  /* Likewise for msymbol_demangled_hash.  */
+  std::vector<minimal_symbol *> demangled_heads;
+  std::vector<minimal_symbol *> demangled_tails;
+
+  /* The languages of the symbols in the demangled chains.  */
+  std::bitset<nr_languages> languages;
+};
+
 /* Build (or rebuild) the minimal symbol hash tables.  This is necessary
    after compacting or sorting the table since the entries move around
-   thus causing the internal minimal_symbol pointers to become jumbled.  */
-  
+   thus causing the internal minimal_symbol pointers to become jumbled.
+
+   The table is split into ranges of symbols, and the worker threads
+   build the bucket chains of each range.  The chains of the ranges are
+   then joined, in table order, so that the tables are the same as if
+   they were built by a single thread.  */
+
 static void
 build_minimal_symbol_hash_tables
   (struct objfile *objfile,
    const std::vector<computed_hash_values>& hash_values)
 {
-  int i;
-  struct minimal_symbol *msym;
-
-  /* (Re)insert the actual entries.  */
   int mcount = objfile->per_bfd->minimal_symbol_count;
-  for ((i = 0,
-	msym = objfile->per_bfd->msymbols.get ());
-       i < mcount;
-       i++, msym++)
+  minimal_symbol *msymbols = objfile->per_bfd->msymbols.get ();
+
+  /* Arbitrarily require at least 1000 symbols in a thread, since each
+     range needs its own bucket chains.  */
+  std::vector<minimal_symbol_hash_chains> ranges
+    = gdb::parallel_for_each (1000, 0, mcount,
+      [&] (int first, int last)
+      {
+	minimal_symbol_hash_chains chains;
+
+	for (int i = first; i < last; ++i)
+	  {
+	    minimal_symbol *msym = &msymbols[i];
+
+	    unsigned int hash
+	      = hash_values[i].minsym_hash % MINIMAL_SYMBOL_HASH_SIZE;
+	    msym->hash_next = chains.heads[hash];
+	    chains.heads[hash] = msym;
+	    if (chains.tails[hash] == nullptr)
+	      chains.tails[hash] = msym;
+
+	    msym->demangled_hash_next = nullptr;
+	    if (msym->search_name () != msym->linkage_name ())
+	      {
+		hash = (hash_values[i].minsym_demangled_hash
+			% MINIMAL_SYMBOL_HASH_SIZE);
+		chains.languages.set (msym->language ());
+		msym->demangled_hash_next = chains.demangled_heads[hash];
+		chains.demangled_heads[hash] = msym;
+		if (chains.demangled_tails[hash] == nullptr)
+		  chains.demangled_tails[hash] = msym;
+	      }
+	  }
+
+	return chains;
+      });
+
+  /* (Re)insert the actual entries.  The symbols are pushed at the front
+     of the chains, so each range is put in front of the previous
+     ones.  */
+  minimal_symbol **table = objfile->per_bfd->msymbol_hash;
+  minimal_symbol **demangled_table = objfile->per_bfd->msymbol_demangled_hash;
+  for (const minimal_symbol_hash_chains &chains : ranges)
     {
-      msym->hash_next = 0;
-      add_minsym_to_hash_table (msym, objfile->per_bfd->msymbol_hash,
-				hash_values[i].minsym_hash);
-
-      msym->demangled_hash_next = 0;
-      if (msym->search_name () != msym->linkage_name ())
-	add_minsym_to_demangled_hash_table
-	  (msym, objfile, hash_values[i].minsym_demangled_hash);
+      for (size_t hash = 0; hash < MINIMAL_SYMBOL_HASH_SIZE; ++hash)
+	{
+	  if (chains.heads[hash] != nullptr)
+	    {
+	      chains.tails[hash]->hash_next = table[hash];
+	      table[hash] = chains.heads[hash];
+	    }
+	  if (chains.demangled_heads[hash] != nullptr)
+	    {
+	      chains.demangled_tails[hash]->demangled_hash_next
+		= demangled_table[hash];
+	      demangled_table[hash] = chains.demangled_heads[hash];
+	    }
+	}
+
+      objfile->per_bfd->demangled_hash_languages |= chains.languages;
     }
 }
 
+/* Sort the COUNT minimal symbols starting at MSYMBOLS by address.  Large
+   tables are split into one chunk per worker thread, the chunks are
+   sorted in parallel, and then merged pairwise, also in parallel.  */
+
+static void
+sort_minimal_symbols (minimal_symbol *msymbols, int count)
+{
+  /* Arbitrarily require at least this many symbols per chunk, sorting
+     smaller tables isn't worth using the worker threads.  */
+  const size_t min_chunk_size = 10000;
+
+  size_t n_chunks
+    = std::min (gdb::thread_pool::g_thread_pool->thread_count (),
+		count / min_chunk_size);
+  if (n_chunks <= 1)
+    {
+      std::sort (msymbols, msymbols + count, minimal_symbol_is_less_than);
+      return;
+    }
+
+  auto chunk_start = [&] (size_t chunk)
+    {
+      return msymbols + count * chunk / n_chunks;
+    };
+
+  gdb::parallel_for_each (1, (size_t) 0, n_chunks,
+    [&] (size_t first, size_t last)
+    {
+      for (size_t chunk = first; chunk < last; ++chunk)
+	std::sort (chunk_start (chunk), chunk_start (chunk + 1),
+		   minimal_symbol_is_less_than);
+    });
+
+  for (size_t width = 1; width < n_chunks; width *= 2)
+    gdb::parallel_for_each (1, (size_t) 0,
+			    (n_chunks + 2 * width - 1) / (2 * width),
+      [&] (size_t first, size_t last)
+      {
+	for (size_t pair = first; pair < last; ++pair)
+	  {
+	    size_t left = pair * 2 * width;
+	    size_t middle = std::min (left + width, n_chunks);
+	    size_t right = std::min (left + 2 * width, n_chunks);
+	    if (middle < right)
+	      std::inplace_merge (chunk_start (left), chunk_start (middle),
+				  chunk_start (right),
+				  minimal_symbol_is_less_than);
+	  }
+      });
+}
+
 /* Add the minimal symbols in the existing bunches to the objfile's official
    minimal symbol table.  In most cases there is no minimal symbol table yet
    for this objfile, and the existing bunches are used to create one.  Once
@@ -1438,7 +1529,7 @@ minimal_symbol_reader::install ()
 
       /* Sort the minimal symbols by address.  */
 
-      std::sort (msymbols, msymbols + mcount, minimal_symbol_is_less_than);
+      sort_minimal_symbols (msymbols, mcount);
 
       /* Compact out any duplicates, and free up whatever space we are
 	 no longer using.  */
@@ -1012,6 +1012,7 @@ gdbpy_parse_and_eval (PyObject *self, PyObject *args, PyObject *kw)
 static PyObject *
 gdbpy_invalidate_cached_frames (PyObject *self, PyObject *args)
 {
+  discard_retained_frames ();
   reinit_frame_cache ();
   Py_RETURN_NONE;
 }
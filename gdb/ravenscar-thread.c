@@ -91,6 +91,7 @@ struct ravenscar_thread_target final : public target_ops
   void resume (ptid_t, int, enum gdb_signal) override;
 
   void fetch_registers (struct regcache *, int) override;
+  void prefetch_registers (gdb::array_view<thread_info *> threads) override;
   void store_registers (struct regcache *, int) override;
 
   void prepare_to_store (struct regcache *) override;
@@ -719,6 +720,19 @@ ravenscar_thread_target::fetch_registers (struct regcache *regcache,
     beneath ()->fetch_registers (regcache, regnum);
 }
 
+void
+ravenscar_thread_target::prefetch_registers
+  (gdb::array_view<thread_info *> threads)
+{
+  /* The registers of the tasks are fetched by fetch_registers.  */
+  std::vector<thread_info *> others;
+  for (thread_info *tp : threads)
+    if (!runtime_initialized () || !is_ravenscar_task (tp->ptid))
+      others.push_back (tp);
+
+  beneath ()->prefetch_registers (others);
+}
+
 void
 ravenscar_thread_target::store_registers (struct regcache *regcache,
 					  int regnum)
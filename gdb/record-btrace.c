@@ -104,12 +104,16 @@ class record_btrace_target final : public target_ops
 					ULONGEST offset, ULONGEST len,
 					ULONGEST *xfered_len) override;
 
+  bool read_raw_memory_ranges
+    (gdb::array_view<memory_read_request> requests) override;
+
   int insert_breakpoint (struct gdbarch *,
 			 struct bp_target_info *) override;
   int remove_breakpoint (struct gdbarch *, struct bp_target_info *,
 			 enum remove_bp_reason) override;
 
   void fetch_registers (struct regcache *, int) override;
+  void prefetch_registers (gdb::array_view<thread_info *> threads) override;
 
   void store_registers (struct regcache *, int) override;
   void prepare_to_store (struct regcache *) override;
@@ -1480,6 +1484,21 @@ record_btrace_target::xfer_partial (enum target_object object,
 					 offset, len, xfered_len);
 }
 
+/* The read_raw_memory_ranges method of target record-btrace.  */
+
+bool
+record_btrace_target::read_raw_memory_ranges
+  (gdb::array_view<memory_read_request> requests)
+{
+  /* Let xfer_partial filter the requests during replay.  */
+  if (replay_memory_access == replay_memory_access_read_only
+      && !record_btrace_generating_corefile
+      && record_is_replaying (inferior_ptid))
+    return false;
+
+  return this->beneath ()->read_raw_memory_ranges (requests);
+}
+
 /* The insert_breakpoint method of target record-btrace.  */
 
 int
@@ -1578,6 +1597,21 @@ record_btrace_target::fetch_registers (struct regcache *regcache, int regno)
     this->beneath ()->fetch_registers (regcache, regno);
 }
 
+/* The prefetch_registers method of target record-btrace.  */
+
+void
+record_btrace_target::prefetch_registers
+  (gdb::array_view<thread_info *> threads)
+{
+  /* Leave the replaying threads to fetch_registers.  */
+  std::vector<thread_info *> live;
+  for (thread_info *tp : threads)
+    if (tp->btrace.replay == nullptr || record_btrace_generating_corefile)
+      live.push_back (tp);
+
+  this->beneath ()->prefetch_registers (live);
+}
+
 /* The store_registers method of target record-btrace.  */
 
 void
@@ -42,6 +42,7 @@
 #include "valprint.h"
 #include "interps.h"
 
+#include <map>
 #include <signal.h>
 
 /* This module implements "target record-full", also known as "process
@@ -379,6 +380,111 @@ static struct cmd_list_element *record_full_cmdlist;
 static void record_full_goto_insn (struct record_full_entry *entry,
 				   enum exec_direction_kind dir);
 
+/* Log entries are carved out of chunks of RECORD_FULL_POOL_CHUNK
+   entries instead of being allocated one by one: the log holds several
+   small entries per recorded instruction, and the per-allocation
+   overhead of the heap would make up a good part of its size.
+
+   Each chunk keeps its own free list, threaded through the "next"
+   field of its freed entries, and a chunk is released as soon as none
+   of its entries is in use.  The log is only ever trimmed at its
+   beginning ("set record full insn-number-max") or truncated at its
+   end ("record delete", or recording after going back in the log), so
+   the entries freed together tend to come from the same chunks, and
+   the memory of a trimmed log goes back to the system.  New entries
+   only come from the chunk allocated last, so that older chunks are
+   not kept alive by the entries reused in them.  */
+
+#define RECORD_FULL_POOL_CHUNK	4096
+
+struct record_full_pool_chunk
+{
+  std::unique_ptr<record_full_entry[]> entries;
+
+  /* The number of entries handed out from the start of ENTRIES.  */
+  size_t used = 0;
+
+  /* The number of entries in use.  */
+  size_t live = 0;
+
+  /* The freed entries of this chunk.  */
+  struct record_full_entry *free_list = nullptr;
+};
+
+/* The chunks of the pool, keyed by the address of their entries.  */
+static std::map<const record_full_entry *, record_full_pool_chunk>
+  record_full_pool;
+
+/* The chunk new entries are taken from, or NULL if it was released.  */
+static record_full_pool_chunk *record_full_pool_current;
+
+/* Return a zeroed entry from the pool.  */
+
+static struct record_full_entry *
+record_full_entry_alloc (void)
+{
+  record_full_pool_chunk *chunk = record_full_pool_current;
+  struct record_full_entry *rec;
+
+  if (chunk == nullptr
+      || (chunk->free_list == nullptr
+	  && chunk->used == RECORD_FULL_POOL_CHUNK))
+    {
+      std::unique_ptr<record_full_entry[]> entries
+	(new record_full_entry[RECORD_FULL_POOL_CHUNK]);
+
+      chunk = &record_full_pool[entries.get ()];
+      chunk->entries = std::move (entries);
+      record_full_pool_current = chunk;
+    }
+
+  if (chunk->free_list != nullptr)
+    {
+      rec = chunk->free_list;
+      chunk->free_list = rec->next;
+    }
+  else
+    rec = &chunk->entries[chunk->used++];
+  chunk->live++;
+
+  memset (rec, 0, sizeof (*rec));
+  return rec;
+}
+
+/* Return REC to the pool, releasing its chunk if none of the chunk's
+   entries is in use anymore.  */
+
+static void
+record_full_entry_free (struct record_full_entry *rec)
+{
+  auto it = record_full_pool.upper_bound (rec);
+  gdb_assert (it != record_full_pool.begin ());
+  --it;
+  gdb_assert (rec < it->first + RECORD_FULL_POOL_CHUNK);
+
+  record_full_pool_chunk *chunk = &it->second;
+  gdb_assert (chunk->live > 0);
+  if (--chunk->live == 0)
+    {
+      if (record_full_pool_current == chunk)
+	record_full_pool_current = nullptr;
+      record_full_pool.erase (it);
+      return;
+    }
+
+  rec->next = chunk->free_list;
+  chunk->free_list = rec;
+}
+
+/* Release the pool along with the whole log.  */
+
+static void
+record_full_pool_clear (void)
+{
+  record_full_pool.clear ();
+  record_full_pool_current = nullptr;
+}
+
 /* Alloc and free functions for record_full_reg, record_full_mem, and
    record_full_end entries.  */
 
@@ -390,7 +496,7 @@ record_full_reg_alloc (struct regcache *regcache, int regnum)
   struct record_full_entry *rec;
   struct gdbarch *gdbarch = regcache->arch ();
 
-  rec = XCNEW (struct record_full_entry);
+  rec = record_full_entry_alloc ();
   rec->type = record_full_reg;
   rec->u.reg.num = regnum;
   rec->u.reg.len = register_size (gdbarch, regnum);
@@ -408,7 +514,7 @@ record_full_reg_release (struct record_full_entry *rec)
   gdb_assert (rec->type == record_full_reg);
   if (rec->u.reg.len > sizeof (rec->u.reg.u.buf))
     xfree (rec->u.reg.u.ptr);
-  xfree (rec);
+  record_full_entry_free (rec);
 }
 
 /* Alloc a record_full_mem record entry.  */
@@ -418,7 +524,7 @@ record_full_mem_alloc (CORE_ADDR addr, int len)
 {
   struct record_full_entry *rec;
 
-  rec = XCNEW (struct record_full_entry);
+  rec = record_full_entry_alloc ();
   rec->type = record_full_mem;
   rec->u.mem.addr = addr;
   rec->u.mem.len = len;
@@ -436,7 +542,7 @@ record_full_mem_release (struct record_full_entry *rec)
   gdb_assert (rec->type == record_full_mem);
   if (rec->u.mem.len > sizeof (rec->u.mem.u.buf))
     xfree (rec->u.mem.u.ptr);
-  xfree (rec);
+  record_full_entry_free (rec);
 }
 
 /* Alloc a record_full_end record entry.  */
@@ -446,7 +552,7 @@ record_full_end_alloc (void)
 {
   struct record_full_entry *rec;
 
-  rec = XCNEW (struct record_full_entry);
+  rec = record_full_entry_alloc ();
   rec->type = record_full_end;
 
   return rec;
@@ -457,7 +563,7 @@ record_full_end_alloc (void)
 static inline void
 record_full_end_release (struct record_full_entry *rec)
 {
-  xfree (rec);
+  record_full_entry_free (rec);
 }
 
 /* Free one record entry, any type.
@@ -810,6 +916,71 @@ record_full_gdb_operation_disable_set (void)
 static enum target_stop_reason record_full_stop_reason
   = TARGET_STOPPED_BY_NO_REASON;
 
+/* While the log is walked by record_full_exec_insn, the register
+   changes of its entries are only supplied to the regcache, and each
+   changed register is written to the target once, when the walk is
+   over, instead of once per entry.  A walk over many instructions then
+   does not cost a register write, i.e., a system call or two on a
+   native target, per recorded register change.  */
+
+class record_full_deferred_registers
+{
+public:
+  explicit record_full_deferred_registers (struct regcache *regcache)
+    : m_regcache (regcache),
+      m_changed (gdbarch_num_regs (regcache->arch ()), false)
+  {
+    gdb_assert (current == nullptr);
+    current = this;
+  }
+
+  ~record_full_deferred_registers ()
+  {
+    current = nullptr;
+
+    try
+      {
+	flush ();
+      }
+    catch (const gdb_exception_error &ex)
+      {
+	exception_print (gdb_stderr, ex);
+      }
+  }
+
+  DISABLE_COPY_AND_ASSIGN (record_full_deferred_registers);
+
+  /* Supply BUF as the new value of register REGNUM of REGCACHE, to be
+     written to the target later.  */
+  void supply (struct regcache *regcache, int regnum, const gdb_byte *buf)
+  {
+    gdb_assert (regcache == m_regcache);
+
+    regcache->raw_supply (regnum, buf);
+    m_changed[regnum] = true;
+  }
+
+  /* Write the changed registers to the target.  */
+  void flush ()
+  {
+    for (int regnum = 0; regnum < m_changed.size (); regnum++)
+      if (m_changed[regnum])
+	{
+	  m_changed[regnum] = false;
+	  target_store_registers (m_regcache, regnum);
+	}
+  }
+
+  /* The walk in progress, if any.  */
+  static record_full_deferred_registers *current;
+
+private:
+  struct regcache *m_regcache;
+  std::vector<bool> m_changed;
+};
+
+record_full_deferred_registers *record_full_deferred_registers::current;
+
 /* Execute one instruction from the record log.  Each instruction in
    the log will be represented by an arbitrary sequence of register
    entries and memory entries, followed by an 'end' entry.  */
@@ -833,7 +1004,12 @@ record_full_exec_insn (struct regcache *regcache,
 		      entry->u.reg.num);
 
 	regcache->cooked_read (entry->u.reg.num, reg.data ());
-	regcache->cooked_write (entry->u.reg.num, record_full_get_loc (entry));
+	if (record_full_deferred_registers::current != nullptr)
+	  record_full_deferred_registers::current->supply
+	    (regcache, entry->u.reg.num, record_full_get_loc (entry));
+	else
+	  regcache->cooked_write (entry->u.reg.num,
+				  record_full_get_loc (entry));
 	memcpy (record_full_get_loc (entry), reg.data (), entry->u.reg.len);
       }
       break;
@@ -996,6 +1172,7 @@ record_full_base_target::close ()
     gdb_printf (gdb_stdlog, "Process record: record_full_close\n");
 
   record_full_list_release (record_full_list);
+  record_full_pool_clear ();
 
   /* Release record_full_core_regbuf.  */
   if (record_full_core_regbuf)
@@ -1291,6 +1468,7 @@ record_full_wait_1 (struct target_ops *ops,
       const struct address_space *aspace = regcache->aspace ();
       int continue_flag = 1;
       int first_record_full_end = 1;
+      record_full_deferred_registers deferred_registers (regcache);
 
       try
 	{
@@ -2553,18 +2731,23 @@ record_full_base_target::save_record (const char *recfilename)
   scoped_restore restore_operation_disable
     = record_full_gdb_operation_disable_set ();
 
-  /* Reverse execute to the begin of record list.  */
-  while (1)
-    {
-      /* Check for beginning and end of log.  */
-      if (record_full_list == &record_full_first)
-	break;
+  /* Reverse execute to the begin of record list.  The registers must
+     be written by the time the corefile state is saved.  */
+  {
+    record_full_deferred_registers deferred_registers (regcache);
 
-      record_full_exec_insn (regcache, gdbarch, record_full_list);
+    while (1)
+      {
+	/* Check for beginning and end of log.  */
+	if (record_full_list == &record_full_first)
+	  break;
 
-      if (record_full_list->prev)
-	record_full_list = record_full_list->prev;
-    }
+	record_full_exec_insn (regcache, gdbarch, record_full_list);
+
+	if (record_full_list->prev)
+	  record_full_list = record_full_list->prev;
+      }
+  }
 
   /* Compute the size needed for the extra bfd section.  */
   save_size = 4;	/* magic cookie */
@@ -2608,6 +2791,8 @@ record_full_base_target::save_record (const char *recfilename)
 		phex_nz (magic, 4));
   bfdcore_write (obfd.get (), osec, &magic, sizeof (magic), &bfd_offset);
 
+  record_full_deferred_registers deferred_registers (regcache);
+
   /* Save the entries to recfd and forward execute to the end of
      record list.  */
   record_full_list = &record_full_first;
@@ -2733,6 +2918,7 @@ record_full_goto_insn (struct record_full_entry *entry,
     = record_full_gdb_operation_disable_set ();
   struct regcache *regcache = get_current_regcache ();
   struct gdbarch *gdbarch = regcache->arch ();
+  record_full_deferred_registers deferred_registers (regcache);
 
   /* Assume everything is valid: we will hit the entry,
      and we will not hit the end of the recording.  */
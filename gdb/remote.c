@@ -74,11 +74,13 @@
 #include "gdbsupport/environ.h"
 #include "gdbsupport/byte-vector.h"
 #include "gdbsupport/search.h"
+#include "gdbsupport/gdb_vecs.h"
 #include <algorithm>
 #include <iterator>
 #include <unordered_map>
 #include "async-event.h"
 #include "gdbsupport/selftest.h"
+#include <zlib.h>
 
 /* The remote target.  */
 
@@ -302,6 +304,16 @@ enum {
      packets and the tag violation stop replies.  */
   PACKET_memory_tagging_feature,
 
+  /* Support for the vMultiMemRead packet.  */
+  PACKET_vMultiMemRead,
+
+  /* Support for sending requests before the replies to the previous
+     ones are received.  */
+  PACKET_pipelined_requests_feature,
+
+  /* Support for the QCompression packet.  */
+  PACKET_QCompression,
+
   PACKET_MAX
 };
 
@@ -399,6 +411,14 @@ struct remote_arch_state
   long remote_packet_size;
 };
 
+/* The algorithms the replies of the stub may be compressed with.  */
+
+enum class remote_compression
+{
+  none,
+  zlib,
+};
+
 /* Description of the remote protocol state for the currently
    connected target.  This is per-target state, and independent of the
    selected architecture.  */
@@ -438,6 +458,14 @@ class remote_state
      reliable.  */
   bool noack_mode = false;
 
+  /* The algorithms the stub can compress its replies with, as it
+     reported them in qSupported.  */
+  std::string compression_algorithms;
+
+  /* The algorithm the stub compresses its long replies with, see the
+     QCompression packet.  */
+  remote_compression compression = remote_compression::none;
+
   /* True if we're connected in extended remote mode.  */
   bool extended = false;
 
@@ -800,6 +828,11 @@ class remote_target : public process_stratum_target
 					ULONGEST offset, ULONGEST len,
 					ULONGEST *xfered_len) override;
 
+  bool read_raw_memory_ranges (gdb::array_view<memory_read_request> requests)
+    override;
+
+  void prefetch_registers (gdb::array_view<thread_info *> threads) override;
+
   ULONGEST get_memory_xfer_limit () override;
 
   void rcmd (const char *command, struct ui_file *output) override;
@@ -1195,6 +1228,10 @@ class remote_target : public process_stratum_target
   packet_result remote_send_printf (const char *format, ...)
     ATTRIBUTE_PRINTF (2, 3);
 
+  void send_pipelined_requests
+    (gdb::array_view<const std::string> packets, long max_reply_len,
+     gdb::function_view<void (size_t index, int reply_len)> handle_reply);
+
   target_xfer_status remote_flash_write (ULONGEST address,
 					 ULONGEST length, ULONGEST *xfered_len,
 					 const gdb_byte *data);
@@ -4995,6 +5032,32 @@ remote_target::start_remote_1 (int from_tty, int extended_p)
 	rs->noack_mode = 1;
     }
 
+  /* Next, ask the stub to compress its long replies, with the first
+     algorithm it reported that we support.  */
+  if (m_features.packet_support (PACKET_QCompression) != PACKET_DISABLE)
+    {
+      remote_compression compression = remote_compression::none;
+      std::string name;
+      for (const gdb::unique_xmalloc_ptr<char> &algorithm
+	     : delim_string_to_char_ptr_vec (rs->compression_algorithms.c_str (),
+					     ','))
+	if (strcmp (algorithm.get (), "zlib") == 0)
+	  {
+	    compression = remote_compression::zlib;
+	    name = algorithm.get ();
+	    break;
+	  }
+
+      if (compression != remote_compression::none)
+	{
+	  std::string packet = std::string ("QCompression:") + name;
+	  putpkt (packet.c_str ());
+	  getpkt (&rs->buf, 0);
+	  if (m_features.packet_ok (rs->buf, PACKET_QCompression) == PACKET_OK)
+	    rs->compression = compression;
+	}
+    }
+
   if (extended_p)
     {
       /* Tell the remote that we are using the extended protocol.  */
@@ -5490,6 +5553,22 @@ remote_target::remote_packet_size (const protocol_feature *feature,
   rs->explicit_packet_size = packet_size;
 }
 
+/* Record the compression algorithms the stub reported along with the
+   QCompression feature.  */
+
+static void
+remote_supported_compression (remote_target *remote,
+			      const protocol_feature *feature,
+			      enum packet_support support,
+			      const char *value)
+{
+  remote->m_features.m_protocol_packets[feature->packet].support = support;
+
+  if (support == PACKET_ENABLE)
+    remote->get_remote_state ()->compression_algorithms
+      = value != nullptr ? value : "zlib";
+}
+
 static void
 remote_packet_size (remote_target *remote, const protocol_feature *feature,
 		    enum packet_support support, const char *value)
@@ -5602,6 +5681,12 @@ static const struct protocol_feature remote_protocol_features[] = {
   { "no-resumed", PACKET_DISABLE, remote_supported_packet, PACKET_no_resumed },
   { "memory-tagging", PACKET_DISABLE, remote_supported_packet,
     PACKET_memory_tagging_feature },
+  { "vMultiMemRead", PACKET_DISABLE, remote_supported_packet,
+    PACKET_vMultiMemRead },
+  { "pipelined-requests", PACKET_DISABLE, remote_supported_packet,
+    PACKET_pipelined_requests_feature },
+  { "QCompression", PACKET_DISABLE, remote_supported_compression,
+    PACKET_QCompression },
 };
 
 static char *remote_support_xml;
@@ -8823,6 +8908,97 @@ remote_target::fetch_registers (struct regcache *regcache, int regnum)
 	}
 }
 
+/* Implement the "prefetch_registers" target_ops method, by sending
+   the 'Hg' and 'g' packets of all the threads at once, when the stub
+   supports pipelined requests.  The registers that aren't in the 'g'
+   packet are left for fetch_registers.  */
+
+void
+remote_target::prefetch_registers (gdb::array_view<thread_info *> threads)
+{
+  struct remote_state *rs = get_remote_state ();
+
+  /* Sending the packets one at a time wouldn't save anything over
+     fetching the registers when they are needed.  */
+  if (!rs->noack_mode
+      || (m_features.packet_support (PACKET_pipelined_requests_feature)
+	  != PACKET_ENABLE))
+    return;
+
+  if (get_traceframe_number () != -1)
+    return;
+
+  std::vector<thread_info *> to_fetch;
+  std::vector<std::string> packets;
+  for (thread_info *tp : threads)
+    {
+      if (tp->state == THREAD_EXITED
+	  || tp->executing ()
+	  || tp->inf->process_target () != this)
+	continue;
+
+      /* Skip the threads whose registers are known already.  */
+      regcache *regcache = get_thread_regcache (tp);
+      int pc_regnum = gdbarch_pc_regnum (regcache->arch ());
+      if (regcache->get_register_status (pc_regnum >= 0 ? pc_regnum : 0)
+	  != REG_UNKNOWN)
+	continue;
+
+      char buf[64];
+      write_ptid (buf, buf + sizeof (buf), tp->ptid);
+      packets.push_back (std::string ("Hg") + buf);
+      packets.push_back ("g");
+      to_fetch.push_back (tp);
+    }
+
+  if (to_fetch.empty ())
+    return;
+
+  /* The thread that the stub has selected, as far as we know.  */
+  ptid_t general_thread = null_ptid;
+  auto handle_reply = [&] (size_t index, int reply_len)
+    {
+      thread_info *tp = to_fetch[index / 2];
+
+      if (index % 2 == 0)
+	{
+	  /* The reply to 'Hg'.  */
+	  if (reply_len >= 0 && strcmp (rs->buf.data (), "OK") == 0)
+	    general_thread = tp->ptid;
+	  else
+	    general_thread = null_ptid;
+	}
+      else if (general_thread == tp->ptid
+	       && reply_len > 0
+	       && packet_check_result (rs->buf) == PACKET_OK
+	       && (isxdigit (rs->buf[0]) || rs->buf[0] == 'x'))
+	{
+	  /* The reply to 'g', for the right thread.  */
+	  process_g_packet (get_thread_regcache (tp));
+	}
+    };
+
+  try
+    {
+      send_pipelined_requests (packets, get_remote_packet_size (),
+			       handle_reply);
+
+      /* All the replies were processed, so GENERAL_THREAD is the thread
+	 selected by the last 'Hg' packet.  */
+      rs->general_thread = general_thread;
+    }
+  catch (const gdb_exception_error &ex)
+    {
+      /* The replies to the packets after the failure weren't looked at,
+	 so the thread selected by the stub isn't known.  */
+      rs->general_thread = null_ptid;
+
+      /* This was only an optimization; fetch_registers will find out
+	 about the problem if it persists.  */
+      remote_debug_printf ("prefetching registers failed: %s", ex.what ());
+    }
+}
+
 /* Prepare to store registers.  Since we may send them all (using a
    'G' request), we have to read out the ones we don't want to change
    first.  */
@@ -9501,7 +9677,164 @@ remote_target::remote_read_bytes (CORE_ADDR memaddr,
   return remote_read_bytes_1 (memaddr, myaddr, len, unit_size, xfered_len);
 }
 
-
+/* Implement the "read_raw_memory_ranges" target_ops method, using
+   as few vMultiMemRead packets as the packet size allows.
+
+   The packet is "vMultiMemRead:"<addr>","<len>[";"<addr>","<len>]...,
+   and the reply lists the number of bytes read from each range,
+   ","-separated, then ";" and the bytes read, escaped as binary data.
+   The stub may read less than requested, e.g. when the escaped data
+   doesn't fit in the reply.  */
+
+bool
+remote_target::read_raw_memory_ranges
+  (gdb::array_view<memory_read_request> requests)
+{
+  if (m_features.packet_support (PACKET_vMultiMemRead) == PACKET_DISABLE)
+    return false;
+
+  /* Memory read from a traceframe needs remote_read_bytes's care.  */
+  if (get_traceframe_number () != -1)
+    return false;
+
+  /* The reply counts bytes, not addressable units.  */
+  if (gdbarch_addressable_memory_unit_size (target_gdbarch ()) != 1)
+    return false;
+
+  /* The stub reads the memory of its general thread, like for the 'm'
+     packet; see xfer_partial.  */
+  set_remote_traceframe ();
+  set_general_thread (inferior_ptid);
+
+  /* Let the caller read from a lower stratum, e.g. the executable
+     file, if the remote target is connected but not running.  */
+  if (!target_has_execution ())
+    return false;
+
+  struct remote_state *rs = get_remote_state ();
+  const char *prefix = "vMultiMemRead:";
+  const long max_reply_len = get_memory_read_packet_size ();
+
+  /* The most characters a range may take in the packet, and its
+     length in the reply.  */
+  const long max_range_chars = 2 * (2 * sizeof (ULONGEST)) + 2;
+  const long max_len_chars = 2 * sizeof (ULONGEST) + 1;
+
+  /* Split the requests into packets, choosing how much of each range
+     to request so that both the packets and their replies fit.  The
+     Nth packet covers the requests from FIRST[N] to FIRST[N + 1].  */
+  std::vector<std::string> packets;
+  std::vector<size_t> first;
+  std::vector<ULONGEST> lens;
+  size_t i = 0;
+  while (i < requests.size ())
+    {
+      long packet_left = get_remote_packet_size () - strlen (prefix) - 1;
+      long reply_left = max_reply_len;
+      std::string packet = prefix;
+
+      size_t k;
+      for (k = i; k < requests.size (); ++k)
+	{
+	  if (packet_left < max_range_chars
+	      || reply_left <= max_len_chars)
+	    break;
+	  ULONGEST len = std::min<ULONGEST> (requests[k].len,
+					     reply_left - max_len_chars);
+	  packet_left -= max_range_chars;
+	  reply_left -= max_len_chars + len;
+
+	  if (k != i)
+	    packet += ';';
+	  CORE_ADDR addr = remote_address_masked (requests[k].address);
+	  packet += phex_nz (addr, sizeof (addr));
+	  packet += ',';
+	  packet += phex_nz (len, sizeof (len));
+	  lens.push_back (len);
+	}
+      if (k == i)
+	break;
+
+      packets.push_back (std::move (packet));
+      first.push_back (i);
+      i = k;
+    }
+  first.push_back (i);
+
+  /* Store the data of the reply to the Nth packet.  */
+  auto handle_reply = [&] (size_t n, int packet_len)
+    {
+      if (packet_len < 0)
+	return;
+      if (m_features.packet_ok (rs->buf, PACKET_vMultiMemRead) != PACKET_OK)
+	{
+	  /* On error, leave these ranges to the individual reads.  */
+	  return;
+	}
+
+      /* Check the lengths before storing anything.  */
+      const char *p = rs->buf.data ();
+      size_t count = first[n + 1] - first[n];
+      std::vector<ULONGEST> xfered (count);
+      ULONGEST xfered_total = 0;
+      for (size_t k = 0; k < count; ++k)
+	{
+	  p = unpack_varlen_hex (p, &xfered[k]);
+	  if (*p != (k + 1 < count ? ',' : ';')
+	      || xfered[k] > lens[first[n] + k])
+	    error (_("Invalid remote vMultiMemRead reply: %s"),
+		   rs->buf.data ());
+	  ++p;
+	  xfered_total += xfered[k];
+	}
+
+      gdb::byte_vector data (xfered_total);
+      int header_len = p - rs->buf.data ();
+      int data_len = remote_unescape_input ((gdb_byte *) p,
+					    packet_len - header_len,
+					    data.data (), xfered_total);
+      if (data_len != (LONGEST) xfered_total)
+	error (_("Remote vMultiMemRead reply has %d bytes, "
+		 "but %s were expected."),
+	       data_len, pulongest (xfered_total));
+
+      const gdb_byte *src = data.data ();
+      for (size_t k = 0; k < count; ++k)
+	{
+	  memory_read_request &req = requests[first[n] + k];
+	  memcpy (req.buf, src, xfered[k]);
+	  req.xfered_len = xfered[k];
+	  src += xfered[k];
+	}
+    };
+
+  if (packets.empty ())
+    return false;
+
+  /* If we don't know yet whether the stub supports the packet, find
+     out with the first one before sending the others.  */
+  size_t n = 0;
+  if (m_features.packet_support (PACKET_vMultiMemRead)
+      == PACKET_SUPPORT_UNKNOWN)
+    {
+      send_pipelined_requests (gdb::make_array_view (&packets[0], 1),
+			       max_reply_len, handle_reply);
+      if (m_features.packet_support (PACKET_vMultiMemRead)
+	  == PACKET_DISABLE)
+	return false;
+      n = 1;
+    }
+
+  send_pipelined_requests
+    (gdb::array_view<const std::string> (packets).slice (n),
+     max_reply_len,
+     [&] (size_t index, int packet_len)
+       {
+	 handle_reply (n + index, packet_len);
+       });
+
+  return true;
+}
 
 /* Sends a packet with content determined by the printf format string
    FORMAT and the remaining arguments, then gets the reply.  Returns
@@ -9533,6 +9866,72 @@ remote_target::remote_send_printf (const char *format, ...)
   return packet_check_result (rs->buf);
 }
 
+/* The number of bytes the replies to the requests sent by
+   send_pipelined_requests may take before it waits for them.  This
+   keeps the replies within what the stub and GDB can buffer, since
+   GDB doesn't read any of them while it sends requests.  */
+static const long remote_pipeline_window = 64 * 1024;
+
+/* Send each of PACKETS, and call HANDLE_REPLY with the index of the
+   packet and the length of its reply, which is in the remote state's
+   buffer.  If the stub supports it, the packets are sent before the
+   replies to the previous ones are received, so that their round
+   trips overlap.  The stub replies to the packets in order, which is
+   how the replies are matched to them.  Each reply is expected to be
+   at most MAX_REPLY_LEN bytes long.
+
+   The packets must not resume the inferior, as the stub might not
+   read the packets that follow then.  */
+
+void
+remote_target::send_pipelined_requests
+  (gdb::array_view<const std::string> packets, long max_reply_len,
+   gdb::function_view<void (size_t index, int reply_len)> handle_reply)
+{
+  struct remote_state *rs = get_remote_state ();
+
+  /* The number of requests that may be outstanding.  Without
+     acknowledgments, the stub reads the packets like any stream, but
+     otherwise each packet must be acknowledged before the next one
+     is sent.  */
+  size_t depth = 1;
+  if (rs->noack_mode
+      && (m_features.packet_support (PACKET_pipelined_requests_feature)
+	  == PACKET_ENABLE))
+    depth = std::max (remote_pipeline_window / std::max (max_reply_len, 1L),
+		      1L);
+
+  size_t sent = 0;
+  size_t received = 0;
+  try
+    {
+      while (received < packets.size ())
+	{
+	  while (sent < packets.size () && sent - received < depth)
+	    {
+	      const std::string &packet = packets[sent];
+	      if (putpkt_binary (packet.data (), packet.size ()) < 0)
+		error (_("Communication problem with target."));
+	      ++sent;
+	    }
+
+	  int reply_len = getpkt_sane (&rs->buf, 0);
+	  handle_reply (received++, reply_len);
+	}
+    }
+  catch (const gdb_exception &)
+    {
+      /* Consume the replies to the packets already sent, so that they
+	 aren't taken for the replies to later packets.  */
+      while (received < sent)
+	{
+	  getpkt_sane (&rs->buf, 0);
+	  ++received;
+	}
+      throw;
+    }
+}
+
 /* Flash writing can take quite some time.  We'll set
    effectively infinite timeout for flash operations.
    In future, we'll need to decide on a better approach.  */
@@ -10061,6 +10460,67 @@ remote_target::getpkt (gdb::char_vector *buf, int forever)
 }
 
 
+/* Decompress the reply in BUF, LEN bytes long, which the stub
+   compressed with COMPRESSION.  The compressed reply is
+   "z"<length>":"<data>, where LENGTH is the length of the original
+   reply in hex, and DATA is the compressed original reply, escaped as
+   binary data.  The stub may also send "z:"<reply>, where REPLY is the
+   original reply, when it couldn't compress a reply that starts with
+   'z'.  Replace the contents of BUF with the original reply, and
+   return its length.  */
+
+static int
+remote_decompress_reply (remote_compression compression,
+			 gdb::char_vector *buf, int len)
+{
+  const char *p = buf->data () + 1;
+  const char *end = buf->data () + len;
+
+  if (p < end && *p == ':')
+    {
+      len = end - (p + 1);
+      memmove (buf->data (), p + 1, len);
+      (*buf)[len] = '\0';
+      return len;
+    }
+
+  ULONGEST reply_len;
+  p = unpack_varlen_hex (p, &reply_len);
+  if (p >= end || *p != ':' || reply_len >= INT_MAX)
+    error (_("Invalid compressed remote reply."));
+  ++p;
+
+  gdb::byte_vector compressed (end - p);
+  int compressed_len = remote_unescape_input ((const gdb_byte *) p, end - p,
+					      compressed.data (),
+					      compressed.size ());
+
+  if (buf->size () <= reply_len)
+    buf->resize (reply_len + 1);
+
+  bool ok = false;
+  switch (compression)
+    {
+    case remote_compression::zlib:
+      {
+	uLongf dest_len = reply_len;
+	ok = (uncompress ((Bytef *) buf->data (), &dest_len,
+			  compressed.data (), compressed_len) == Z_OK
+	      && dest_len == reply_len);
+	break;
+      }
+
+    default:
+      gdb_assert_not_reached ("unexpected compression algorithm");
+    }
+
+  if (!ok)
+    error (_("Could not decompress remote reply."));
+
+  (*buf)[reply_len] = '\0';
+  return reply_len;
+}
+
 /* Read a packet from the remote machine, with error checking, and
    store it in *BUF.  Resize *BUF if necessary to hold the result.  If
    FOREVER, wait forever rather than timing out; this is used (in
@@ -10184,6 +10644,15 @@ remote_target::getpkt_or_notif_sane_1 (gdb::char_vector *buf,
 	  /* Skip the ack char if we're in no-ack mode.  */
 	  if (!rs->noack_mode)
 	    remote_serial_write ("+", 1);
+
+	  if (rs->compression != remote_compression::none
+	      && (*buf)[0] == 'z')
+	    {
+	      val = remote_decompress_reply (rs->compression, buf, val);
+	      remote_debug_printf_nofunc ("Packet decompressed: %d bytes",
+					  val);
+	    }
+
 	  if (is_notif != NULL)
 	    *is_notif = 0;
 	  return val;
@@ -15407,6 +15876,16 @@ Show the maximum size of the address (in bits) in a memory packet."), NULL,
   add_packet_config_cmd (PACKET_memory_tagging_feature,
 			 "memory-tagging-feature", "memory-tagging-feature", 0);
 
+  add_packet_config_cmd (PACKET_vMultiMemRead, "vMultiMemRead",
+			 "multi-memory-read", 0);
+
+  add_packet_config_cmd (PACKET_pipelined_requests_feature,
+			 "pipelined-requests-feature",
+			 "pipelined-requests-feature", 0);
+
+  add_packet_config_cmd (PACKET_QCompression, "QCompression", "compression",
+			 0);
+
   /* Assert that we've registered "set remote foo-packet" commands
      for all packet configs.  */
   {
@@ -0,0 +1,540 @@
+/* Serve jobs of GDB commands over a local socket.
+
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* The "serve-jobs" command makes GDB listen on a local socket, and
+   run the GDB commands that each connection sends, one per line, in an
+   inferior and program space of its own.  The output of the commands
+   is sent back on the connection, which is closed once the client has
+   shut its side down and all its commands have run.  For example:
+
+     $ gdb -batch -ex "serve-jobs /tmp/gdb.sock" &
+     $ printf 'file ./prog\ncore core.1234\nbt\n' | nc -U -N /tmp/gdb.sock
+
+   This avoids paying for starting GDB, and for reading the same
+   programs and libraries over and over, when triaging many core
+   files: the BFDs of the objfiles of the finished jobs are kept open,
+   and since the DWARF index of an objfile is shared by all the
+   objfiles of its BFD, the next jobs that load the same files reuse
+   them.  */
+
+#include "defs.h"
+#include "gdbcmd.h"
+#include "inferior.h"
+#include "gdbthread.h"
+#include "frame.h"
+#include "objfiles.h"
+#include "progspace.h"
+#include "gdb_bfd.h"
+#include "top.h"
+#include "ui.h"
+#include "cli/cli-style.h"
+#include "readline/tilde.h"
+#include "gdbsupport/event-loop.h"
+#include "gdbsupport/filestuff.h"
+#include "gdbsupport/scope-exit.h"
+#include <fcntl.h>
+#include <list>
+#include <memory>
+
+#ifdef HAVE_SYS_UN_H
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+/* The maximum number of BFDs of finished jobs to keep open, or -1 for
+   no limit.  */
+static int serve_jobs_retained_files = 256;
+
+/* The BFDs of the objfiles of finished jobs, most recently used
+   first.  */
+static std::list<gdb_bfd_ref_ptr> retained_bfds;
+
+/* Drop the least recently used retained BFDs beyond the limit.  */
+
+static void
+trim_retained_bfds ()
+{
+  if (serve_jobs_retained_files < 0)
+    return;
+
+  while (retained_bfds.size () > (size_t) serve_jobs_retained_files)
+    retained_bfds.pop_back ();
+}
+
+/* Keep ABFD open after its objfile is gone, so that loading the same
+   file again reuses it, with its DWARF index.  */
+
+static void
+retain_bfd (const gdb_bfd_ref_ptr &abfd)
+{
+  if (abfd == nullptr || serve_jobs_retained_files == 0)
+    return;
+
+  for (auto it = retained_bfds.begin (); it != retained_bfds.end (); ++it)
+    if (it->get () == abfd.get ())
+      {
+	retained_bfds.splice (retained_bfds.begin (), retained_bfds, it);
+	return;
+      }
+
+  retained_bfds.push_front (abfd);
+  trim_retained_bfds ();
+}
+
+#ifdef HAVE_SYS_UN_H
+
+#ifndef UNIX_PATH_MAX
+#define UNIX_PATH_MAX sizeof(((struct sockaddr_un *) NULL)->sun_path)
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+struct job_server;
+
+/* A connection to the job server, and the inferior its commands run
+   in.  */
+
+struct serve_job
+{
+  serve_job (job_server *server_, int fd_, inferior *inf_)
+    : server (server_),
+      fd (fd_),
+      inf (inf_)
+  {
+  }
+
+  /* The server that accepted the connection.  */
+  job_server *server;
+
+  /* The socket of the connection.  */
+  int fd;
+
+  /* The inferior the commands run in.  */
+  inferior *inf;
+
+  /* The input received so far whose commands haven't run yet.  */
+  std::string input;
+
+  /* Whether the client has shut its side of the connection down.  */
+  bool eof = false;
+
+  /* The thread and frame that were selected after the previous
+     command, to select again before the next one.  */
+  thread_info_ref thread;
+  frame_id selected_frame_id = null_frame_id;
+  int selected_frame_level = -1;
+};
+
+/* The state of a "serve-jobs" command.  */
+
+struct job_server
+{
+  explicit job_server (const char *path);
+  ~job_server ();
+
+  DISABLE_COPY_AND_ASSIGN (job_server);
+
+  /* Accept a new connection on the listening socket.  */
+  void accept_job ();
+
+  /* Read what JOB's client sent, and queue the commands in it.  */
+  void read_job (serve_job *job);
+
+  /* Run the queued commands of the jobs, and finish the jobs whose
+     client has shut down and whose commands have all run, until
+     there is nothing left to do.  */
+  void run_jobs ();
+
+  /* Run the command LINE for JOB, and send its output back.  */
+  void run_command (serve_job *job, const char *line);
+
+  /* Close JOB's connection and get rid of its inferior.  */
+  void finish_job (serve_job *job);
+
+  /* The path of the listening socket.  */
+  std::string path;
+
+  /* The listening socket.  */
+  int fd = -1;
+
+  /* The jobs in progress.  */
+  std::list<std::unique_ptr<serve_job>> jobs;
+
+  /* Whether a command of a job is running.  The event loop can be run
+     from within a command, e.g. to wait for the inferior to stop, and
+     call the read handlers of the jobs; the commands they read must
+     then only be queued, since running them, or finishing their job,
+     would pull the state of the running command from under it.  */
+  bool running = false;
+};
+
+/* Send the LEN bytes at BUF to socket FD, ignoring errors, since a
+   client that went away just doesn't get the rest of its output.  */
+
+static void
+send_all (int fd, const char *buf, size_t len)
+{
+  while (len > 0)
+    {
+      ssize_t ret = send (fd, buf, len, MSG_NOSIGNAL);
+      if (ret < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  return;
+	}
+      buf += ret;
+      len -= ret;
+    }
+}
+
+/* Event loop callbacks for the sockets.  */
+
+static void
+job_server_accept_handler (int error, gdb_client_data client_data)
+{
+  ((job_server *) client_data)->accept_job ();
+}
+
+static void
+job_server_read_handler (int error, gdb_client_data client_data)
+{
+  serve_job *job = (serve_job *) client_data;
+  job_server *server = job->server;
+
+  server->read_job (job);
+  if (!server->running)
+    server->run_jobs ();
+}
+
+/* Have the event loop call job_server_read_handler when JOB's client
+   sent something.  */
+
+static void
+add_job_file_handler (serve_job *job)
+{
+  add_file_handler (job->fd, job_server_read_handler, job,
+		    string_printf ("serve-jobs job %d", job->inf->num));
+}
+
+job_server::job_server (const char *path_)
+  : path (path_)
+{
+  if (path.size () > UNIX_PATH_MAX - 1)
+    error (_("The socket name is too long.  "
+	     "It may be no longer than %s bytes."),
+	   pulongest (UNIX_PATH_MAX - 1L));
+
+  struct sockaddr_un addr;
+  memset (&addr, 0, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  strncpy (addr.sun_path, path.c_str (), UNIX_PATH_MAX - 1);
+
+  fd = gdb_socket_cloexec (AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    perror_with_name (_("Can't create socket"));
+
+  /* Only let the user connect, since the jobs can run any command.  */
+  mode_t old_umask = umask (S_IRWXG | S_IRWXO);
+  int ret = bind (fd, (struct sockaddr *) &addr, sizeof addr);
+  umask (old_umask);
+  if (ret < 0 || listen (fd, SOMAXCONN) < 0)
+    {
+      int save_errno = errno;
+      close (fd);
+      errno = save_errno;
+      perror_with_name (path.c_str ());
+    }
+
+  add_file_handler (fd, job_server_accept_handler, this,
+		    string_printf ("serve-jobs %s", path.c_str ()));
+}
+
+job_server::~job_server ()
+{
+  while (!jobs.empty ())
+    finish_job (jobs.front ().get ());
+
+  delete_file_handler (fd);
+  close (fd);
+  unlink (path.c_str ());
+}
+
+void
+job_server::accept_job ()
+{
+  int job_fd = accept (fd, nullptr, nullptr);
+  if (job_fd < 0)
+    return;
+  fcntl (job_fd, F_SETFD, FD_CLOEXEC);
+
+  inferior *inf = add_inferior_with_spaces ();
+  jobs.emplace_back (new serve_job (this, job_fd, inf));
+  add_job_file_handler (jobs.back ().get ());
+}
+
+void
+job_server::read_job (serve_job *job)
+{
+  char buf[4096];
+  ssize_t ret = recv (job->fd, buf, sizeof buf, 0);
+  if (ret < 0 && errno == EINTR)
+    return;
+
+  if (ret > 0)
+    {
+      job->input.append (buf, ret);
+      return;
+    }
+
+  /* There is nothing more to read.  Run what's left of the input as
+     the last command.  */
+  job->eof = true;
+  delete_file_handler (job->fd);
+  if (!job->input.empty () && job->input.back () != '\n')
+    job->input += '\n';
+}
+
+void
+job_server::run_jobs ()
+{
+  gdb_assert (!running);
+
+  bool progress = true;
+  while (progress)
+    {
+      progress = false;
+
+      /* Run one command of each job in turn.  */
+      for (auto it = jobs.begin (); it != jobs.end (); )
+	{
+	  serve_job *job = (it++)->get ();
+
+	  size_t pos = job->input.find ('\n');
+	  if (pos != std::string::npos)
+	    {
+	      std::string line = job->input.substr (0, pos);
+	      job->input.erase (0, pos + 1);
+	      run_command (job, line.c_str ());
+	      progress = true;
+	    }
+	  else if (job->eof)
+	    {
+	      finish_job (job);
+	      progress = true;
+	    }
+	}
+    }
+}
+
+void
+job_server::run_command (serve_job *job, const char *line)
+{
+  scoped_restore_current_thread restore_thread;
+  scoped_restore save_confirm = make_scoped_restore (&confirm, false);
+
+  switch_to_inferior_no_thread (job->inf);
+  if (job->thread != nullptr
+      && job->thread->inf == job->inf
+      && job->thread->state != THREAD_EXITED)
+    {
+      switch_to_thread (job->thread.get ());
+      restore_selected_frame (job->selected_frame_id,
+			      job->selected_frame_level);
+    }
+
+  /* Don't read JOB's input while its command runs, and only queue the
+     input of the other jobs.  */
+  gdb_assert (!running);
+  running = true;
+  if (!job->eof)
+    delete_file_handler (job->fd);
+  SCOPE_EXIT
+    {
+      running = false;
+      if (!job->eof)
+	add_job_file_handler (job);
+
+      /* A command that resumed the inferior gave the terminal back to
+	 the UI when the inferior stopped, see async_enable_stdin.  Keep
+	 it from reading commands, as serve_jobs_command does.  */
+      current_ui->unregister_file_handler ();
+    };
+
+  std::string output;
+  try
+    {
+      execute_command_to_string (output, line, 0, false);
+    }
+  catch (const gdb_exception_error &ex)
+    {
+      output += ex.what ();
+      output += '\n';
+    }
+
+  /* Keep the job in its own inferior, even if the command switched to
+     another one.  */
+  if (current_inferior () == job->inf && inferior_ptid != null_ptid)
+    {
+      job->thread = thread_info_ref::new_reference (inferior_thread ());
+      save_selected_frame (&job->selected_frame_id,
+			   &job->selected_frame_level);
+    }
+  else
+    job->thread = nullptr;
+
+  send_all (job->fd, output.data (), output.size ());
+}
+
+void
+job_server::finish_job (serve_job *job)
+{
+  delete_file_handler (job->fd);
+  close (job->fd);
+  job->thread = nullptr;
+
+  inferior *inf = job->inf;
+  for (objfile *objf : inf->pspace->objfiles ())
+    retain_bfd (objf->obfd);
+
+  try
+    {
+      scoped_restore_current_thread restore_thread;
+      switch_to_inferior_no_thread (inf);
+      if (inf->pid != 0 && target_has_execution ())
+	target_kill ();
+      inf->pop_all_targets ();
+    }
+  catch (const gdb_exception_error &ex)
+    {
+      exception_print (gdb_stderr, ex);
+    }
+
+  /* The inferior can't be deleted while it's the current one.  */
+  if (inf == current_inferior ())
+    for (inferior *other : all_inferiors ())
+      if (other != inf)
+	{
+	  switch_to_inferior_no_thread (other);
+	  break;
+	}
+  if (inf->deletable ())
+    delete_inferior (inf);
+
+  jobs.remove_if ([job] (const std::unique_ptr<serve_job> &j)
+		  {
+		    return j.get () == job;
+		  });
+}
+
+#endif /* HAVE_SYS_UN_H */
+
+/* Implement the "serve-jobs" command.  */
+
+static void
+serve_jobs_command (const char *args, int from_tty)
+{
+#ifdef HAVE_SYS_UN_H
+  if (args == nullptr || *args == '\0')
+    error_no_arg (_("socket file name"));
+
+  gdb::unique_xmalloc_ptr<char> path (tilde_expand (args));
+  job_server server (path.get ());
+
+  gdb_printf (_("Serving jobs on %ps.\n"),
+	      styled_string (file_name_style.style (), path.get ()));
+  gdb_flush (gdb_stdout);
+
+  /* The jobs run their commands from the event loop, so don't let it
+     read commands from the terminal meanwhile too.  */
+  struct ui *ui = current_ui;
+  ui->unregister_file_handler ();
+  SCOPE_EXIT
+    {
+      if (ui->prompt_state != PROMPT_BLOCKED)
+	ui->register_file_handler ();
+    };
+
+  /* Serve until interrupted.  */
+  while (gdb_do_one_event () >= 0)
+    ;
+#else
+  error (_("Serving jobs is not supported on this host."));
+#endif
+}
+
+/* Implement "set serve-jobs-retained-files".  */
+
+static void
+set_serve_jobs_retained_files (const char *args, int from_tty,
+			       struct cmd_list_element *c)
+{
+  if (serve_jobs_retained_files == 0)
+    retained_bfds.clear ();
+  else
+    trim_retained_bfds ();
+}
+
+/* Implement "show serve-jobs-retained-files".  */
+
+static void
+show_serve_jobs_retained_files (struct ui_file *file, int from_tty,
+				struct cmd_list_element *c,
+				const char *value)
+{
+  gdb_printf (file, _("The maximum number of files kept open after "
+		      "the jobs that loaded them is %s.\n"),
+	      value);
+}
+
+void _initialize_serve_jobs ();
+void
+_initialize_serve_jobs ()
+{
+  add_cmd ("serve-jobs", class_support, serve_jobs_command, _("\
+Run the GDB commands sent by clients of a local socket.\n\
+Usage: serve-jobs SOCKET-FILE\n\
+GDB listens for connections on the local (Unix domain) socket\n\
+SOCKET-FILE, and runs the commands that each connection sends, one per\n\
+line, in a new inferior and program space, sending their output back.\n\
+When the client has shut down its side of the connection and all its\n\
+commands have run, GDB closes the connection and removes the inferior.\n\
+Several connections can be served at the same time.  This command only\n\
+returns when interrupted."),
+	   &cmdlist);
+
+  add_setshow_zuinteger_unlimited_cmd ("serve-jobs-retained-files",
+				       class_support,
+				       &serve_jobs_retained_files, _("\
+Set the maximum number of files kept open after the jobs that loaded them."),
+				       _("\
+Show the maximum number of files kept open after the jobs that loaded them."),
+				       _("\
+When a job of \"serve-jobs\" finishes, GDB keeps the executable, shared\n\
+library and debug info files it loaded open, with their indexes, so that\n\
+the jobs that load the same files reuse them.  This setting limits the\n\
+number of such files, dropping the least recently used ones first.\n\
+A value of \"unlimited\" means no limit, and 0 keeps no file open."),
+				       set_serve_jobs_retained_files,
+				       show_serve_jobs_retained_files,
+				       &setlist, &showlist);
+}
@@ -0,0 +1,566 @@
+/* SFrame stack trace unwinder for GDB.
+
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* SFrame is a compact stack trace format emitted by the assembler
+   (see "as --gsframe") into an .sframe section.  For each function it
+   records, per range of PCs, how to compute the CFA from the stack or
+   frame pointer, and where the frame pointer and return address of the
+   caller were saved relative to the CFA.  Looking up a PC is a binary
+   search followed by a short linear scan, which makes this unwinder
+   much cheaper than interpreting DWARF CFI when all that is wanted is
+   a backtrace.
+
+   SFrame does not describe the other callee-saved registers.  Those
+   are unwound using the DWARF CFI of the frame, if there is any, which
+   is only decoded when such a register is actually asked for.  */
+
+#include "defs.h"
+#include "sframe-unwind.h"
+#include "complaints.h"
+#include "dwarf2/frame.h"
+#include "dwarf2/frame-tailcall.h"
+#include "frame.h"
+#include "frame-unwind.h"
+#include "gdbarch.h"
+#include "gdbcmd.h"
+#include "gdbsupport/byte-vector.h"
+#include "objfiles.h"
+#include "value.h"
+
+#include "sframe-api.h"
+
+/* Whether the SFrame unwinder may be used.  */
+
+static bool sframe_unwinders_enabled_p = true;
+
+/* Lists for "maint set/show sframe".  */
+
+static struct cmd_list_element *set_sframe_cmdlist;
+static struct cmd_list_element *show_sframe_cmdlist;
+
+/* The SFrame data of an objfile.  */
+
+struct sframe_objfile_data
+{
+  ~sframe_objfile_data ()
+  {
+    sframe_decoder_free (&decoder);
+  }
+
+  /* The decoded .sframe section, or NULL if the objfile has no usable
+     SFrame data.  */
+  sframe_decoder_ctx *decoder = nullptr;
+
+  /* The unrelocated address of the .sframe section.  The start
+     addresses of the functions described by the section are relative
+     to it.  */
+  CORE_ADDR section_vma = 0;
+
+  /* The DWARF register numbers of the frame pointer and the link
+     register of the section's ABI.  LR_DWARF_REGNUM is -1 if the ABI
+     always saves the return address on the stack.  */
+  int fp_dwarf_regnum = -1;
+  int lr_dwarf_regnum = -1;
+};
+
+static const registry<objfile>::key<sframe_objfile_data>
+  sframe_objfile_data_key;
+
+/* How to unwind a frame, as found by sframe_frame_sniffer.  */
+
+struct sframe_frame_cache
+{
+  /* The objfile whose SFrame data describes the frame.  */
+  struct objfile *objfile;
+
+  /* The register the CFA is computed from, and the offset to add to
+     it.  */
+  int cfa_regnum;
+  int32_t cfa_offset;
+
+  /* The frame pointer and link register.  LR_REGNUM is -1 if the
+     architecture has none.  */
+  int fp_regnum;
+  int lr_regnum;
+
+  /* Where the caller's frame pointer and return address were saved,
+     relative to the CFA.  If FP_SAVED_P is false, the frame pointer has
+     not been changed by this frame.  If RA_SAVED_P is false, the return
+     address is still in the link register.  */
+  bool fp_saved_p;
+  int32_t fp_offset;
+  bool ra_saved_p;
+  int32_t ra_offset;
+
+  /* Whether CFA has been computed, and whether that succeeded.  */
+  bool computed_p;
+  bool cfa_p;
+  CORE_ADDR cfa;
+
+  /* The virtual tail call frames between this frame and its caller, if
+     any.  See dwarf2/frame-tailcall.c.  */
+  void *tailcall_cache;
+
+  /* The DWARF frame state used to unwind the registers that SFrame
+     does not describe.  */
+  void *dwarf2_cache;
+};
+
+/* Return true if SFrame data for ABI can describe the frames of
+   GDBARCH.  */
+
+static bool
+sframe_abi_matches_p (struct gdbarch *gdbarch, uint8_t abi)
+{
+  const struct bfd_arch_info *info = gdbarch_bfd_arch_info (gdbarch);
+  enum bfd_endian byte_order = gdbarch_byte_order (gdbarch);
+
+  switch (abi)
+    {
+    case SFRAME_ABI_AMD64_ENDIAN_LITTLE:
+      return (info->arch == bfd_arch_i386
+	      && (info->mach & bfd_mach_x86_64) != 0
+	      && byte_order == BFD_ENDIAN_LITTLE);
+
+    case SFRAME_ABI_AARCH64_ENDIAN_BIG:
+    case SFRAME_ABI_AARCH64_ENDIAN_LITTLE:
+      return (info->arch == bfd_arch_aarch64
+	      && gdbarch_ptr_bit (gdbarch) == 64
+	      && byte_order == (abi == SFRAME_ABI_AARCH64_ENDIAN_BIG
+				? BFD_ENDIAN_BIG : BFD_ENDIAN_LITTLE));
+
+    default:
+      return false;
+    }
+}
+
+/* Read and decode the .sframe section of OBJFILE into DATA, if it has
+   a usable one.  */
+
+static void
+sframe_read_section (struct objfile *objfile, sframe_objfile_data *data)
+{
+  bfd *abfd = objfile->obfd.get ();
+
+  /* The function addresses in the .sframe section of a relocatable
+     file have not been resolved yet.  */
+  if ((bfd_get_file_flags (abfd) & (EXEC_P | DYNAMIC)) == 0)
+    return;
+
+  asection *sect = bfd_get_section_by_name (abfd, ".sframe");
+  if (sect == nullptr || bfd_section_size (sect) == 0)
+    return;
+
+  gdb::byte_vector contents (bfd_section_size (sect));
+  if (!bfd_get_section_contents (abfd, sect, contents.data (), 0,
+				 contents.size ()))
+    {
+      complaint (_("could not read .sframe section of %s"),
+		 objfile_name (objfile));
+      return;
+    }
+
+  int err = 0;
+  sframe_decoder_ctx *decoder
+    = sframe_decode ((const char *) contents.data (), contents.size (),
+		     &err);
+  if (decoder == nullptr)
+    {
+      complaint (_("could not decode .sframe section of %s: %s"),
+		 objfile_name (objfile), sframe_errmsg (err));
+      return;
+    }
+
+  /* The decoder lays out function descriptors as in version 2 of the
+     format, so older sections can't be searched.  */
+  uint8_t abi = sframe_decoder_get_abi_arch (decoder);
+  if (sframe_decoder_get_version (decoder) != SFRAME_VERSION_2
+      || !sframe_abi_matches_p (objfile->arch (), abi))
+    {
+      sframe_decoder_free (&decoder);
+      return;
+    }
+
+  data->decoder = decoder;
+  data->section_vma = bfd_section_vma (sect);
+  if (abi == SFRAME_ABI_AMD64_ENDIAN_LITTLE)
+    data->fp_dwarf_regnum = 6;
+  else
+    {
+      data->fp_dwarf_regnum = 29;
+      data->lr_dwarf_regnum = 30;
+    }
+}
+
+/* Return the SFrame data of OBJFILE, reading it if necessary.  */
+
+static sframe_objfile_data *
+get_sframe_objfile_data (struct objfile *objfile)
+{
+  sframe_objfile_data *data = sframe_objfile_data_key.get (objfile);
+
+  if (data == nullptr)
+    {
+      data = sframe_objfile_data_key.emplace (objfile);
+      sframe_read_section (objfile, data);
+    }
+
+  return data;
+}
+
+/* Find the SFrame row entry of OBJFILE that covers PC, and store it in
+   FRE.  Return false if there is none.  */
+
+static bool
+sframe_find_fre_for_pc (struct objfile *objfile, CORE_ADDR pc,
+			sframe_frame_row_entry *fre)
+{
+  sframe_objfile_data *data = get_sframe_objfile_data (objfile);
+
+  if (data->decoder == nullptr)
+    return false;
+
+  CORE_ADDR unrelocated_pc = pc - objfile->text_section_offset ();
+  LONGEST offset = (LONGEST) (unrelocated_pc - data->section_vma);
+  if (offset < INT32_MIN || offset > INT32_MAX)
+    return false;
+
+  return sframe_find_fre (data->decoder, offset, fre) == 0;
+}
+
+/* Return the offset of the CFA from the stack pointer at the entry of
+   the function of THIS_FRAME in *OFFSET, for the benefit of the tail
+   call frames unwinder.  Return false if it is not known.  */
+
+static bool
+sframe_entry_cfa_sp_offset (frame_info_ptr this_frame,
+			    struct sframe_frame_cache *cache,
+			    LONGEST *offset)
+{
+  CORE_ADDR entry_pc;
+  sframe_frame_row_entry fre;
+  int err = 0;
+
+  if (!get_frame_func_if_available (this_frame, &entry_pc)
+      || !sframe_find_fre_for_pc (cache->objfile, entry_pc, &fre))
+    return false;
+
+  sframe_decoder_ctx *decoder
+    = sframe_objfile_data_key.get (cache->objfile)->decoder;
+  uint8_t base_reg = sframe_fre_get_base_reg_id (&fre, &err);
+  int32_t cfa_offset = sframe_fre_get_cfa_offset (decoder, &fre, &err);
+  if (err != 0 || base_reg != SFRAME_BASE_REG_SP)
+    return false;
+
+  *offset = cfa_offset;
+  return true;
+}
+
+/* Return the cache of THIS_FRAME, computing its CFA if that has not
+   been done yet.  */
+
+static struct sframe_frame_cache *
+sframe_frame_cache (frame_info_ptr this_frame, void **this_cache)
+{
+  struct sframe_frame_cache *cache
+    = (struct sframe_frame_cache *) *this_cache;
+
+  if (cache->computed_p)
+    return cache;
+  cache->computed_p = true;
+
+  try
+    {
+      cache->cfa = (get_frame_register_unsigned (this_frame,
+						 cache->cfa_regnum)
+		    + cache->cfa_offset);
+      cache->cfa_p = true;
+    }
+  catch (const gdb_exception_error &ex)
+    {
+      if (ex.error != NOT_AVAILABLE_ERROR)
+	throw;
+    }
+
+  if (cache->cfa_p)
+    {
+      LONGEST entry_cfa_sp_offset;
+      bool entry_cfa_sp_offset_p
+	= sframe_entry_cfa_sp_offset (this_frame, cache,
+				      &entry_cfa_sp_offset);
+
+      dwarf2_tailcall_sniffer_first (this_frame, &cache->tailcall_cache,
+				     (entry_cfa_sp_offset_p
+				      ? &entry_cfa_sp_offset : NULL));
+    }
+
+  return cache;
+}
+
+static enum unwind_stop_reason
+sframe_frame_unwind_stop_reason (frame_info_ptr this_frame,
+				 void **this_cache)
+{
+  struct sframe_frame_cache *cache
+    = sframe_frame_cache (this_frame, this_cache);
+
+  if (!cache->cfa_p)
+    return UNWIND_UNAVAILABLE;
+
+  return UNWIND_NO_REASON;
+}
+
+static void
+sframe_frame_this_id (frame_info_ptr this_frame, void **this_cache,
+		      struct frame_id *this_id)
+{
+  struct sframe_frame_cache *cache
+    = sframe_frame_cache (this_frame, this_cache);
+
+  if (!cache->cfa_p)
+    (*this_id) = frame_id_build_unavailable_stack (get_frame_func (this_frame));
+  else
+    (*this_id) = frame_id_build (cache->cfa, get_frame_func (this_frame));
+}
+
+static struct value *
+sframe_frame_prev_register (frame_info_ptr this_frame, void **this_cache,
+			    int regnum)
+{
+  struct gdbarch *gdbarch = get_frame_arch (this_frame);
+  struct sframe_frame_cache *cache
+    = sframe_frame_cache (this_frame, this_cache);
+
+  if (cache->tailcall_cache != nullptr)
+    {
+      struct value *val
+	= dwarf2_tailcall_prev_register_first (this_frame,
+					       &cache->tailcall_cache,
+					       regnum);
+      if (val != nullptr)
+	return val;
+    }
+
+  if (regnum == gdbarch_pc_regnum (gdbarch))
+    {
+      if (!cache->ra_saved_p)
+	return frame_unwind_got_register (this_frame, regnum,
+					  cache->lr_regnum);
+      if (!cache->cfa_p)
+	return frame_unwind_got_optimized (this_frame, regnum);
+      return frame_unwind_got_memory (this_frame, regnum,
+				      cache->cfa + cache->ra_offset);
+    }
+
+  if (regnum == gdbarch_sp_regnum (gdbarch))
+    {
+      if (!cache->cfa_p)
+	return frame_unwind_got_optimized (this_frame, regnum);
+      return frame_unwind_got_address (this_frame, regnum, cache->cfa);
+    }
+
+  if (regnum == cache->fp_regnum)
+    {
+      if (!cache->fp_saved_p)
+	return frame_unwind_got_register (this_frame, regnum, regnum);
+      if (!cache->cfa_p)
+	return frame_unwind_got_optimized (this_frame, regnum);
+      return frame_unwind_got_memory (this_frame, regnum,
+				      cache->cfa + cache->fp_offset);
+    }
+
+  struct value *val
+    = dwarf2_frame_prev_register_cfi (this_frame, &cache->dwarf2_cache,
+				      regnum);
+  if (val != nullptr)
+    return val;
+
+  /* Without CFI, assume the register was not changed, as the
+     prologue analyzers do.  */
+  return frame_unwind_got_register (this_frame, regnum, regnum);
+}
+
+static int
+sframe_frame_sniffer (const struct frame_unwind *self,
+		      frame_info_ptr this_frame, void **this_cache)
+{
+  if (!sframe_unwinders_enabled_p)
+    return 0;
+
+  /* See dwarf2_frame_sniffer for why the address in the block is used
+     rather than the PC.  */
+  CORE_ADDR block_addr = get_frame_address_in_block (this_frame);
+  struct obj_section *osect = find_pc_section (block_addr);
+  if (osect == nullptr)
+    return 0;
+
+  struct objfile *objfile = osect->objfile;
+  sframe_frame_row_entry fre;
+  if (!sframe_find_fre_for_pc (objfile, block_addr, &fre))
+    return 0;
+
+  struct gdbarch *gdbarch = get_frame_arch (this_frame);
+  sframe_objfile_data *data = sframe_objfile_data_key.get (objfile);
+  sframe_decoder_ctx *decoder = data->decoder;
+  if (!sframe_abi_matches_p (gdbarch,
+			     sframe_decoder_get_abi_arch (decoder)))
+    return 0;
+
+  int err = 0;
+  uint8_t base_reg = sframe_fre_get_base_reg_id (&fre, &err);
+  int32_t cfa_offset = sframe_fre_get_cfa_offset (decoder, &fre, &err);
+  if (err != 0)
+    return 0;
+
+  /* A mangled return address has to be authenticated (AArch64 pointer
+     authentication); leave that to the DWARF unwinder.  */
+  if (sframe_fre_get_ra_mangled_p (decoder, &fre, &err) || err != 0)
+    return 0;
+
+  int fp_regnum = gdbarch_dwarf2_reg_to_regnum (gdbarch,
+						data->fp_dwarf_regnum);
+  int lr_regnum = (data->lr_dwarf_regnum == -1 ? -1
+		   : gdbarch_dwarf2_reg_to_regnum (gdbarch,
+						   data->lr_dwarf_regnum));
+  if (fp_regnum < 0)
+    return 0;
+
+  int fp_err = 0;
+  int32_t fp_offset = sframe_fre_get_fp_offset (decoder, &fre, &fp_err);
+  int ra_err = 0;
+  int32_t ra_offset = sframe_fre_get_ra_offset (decoder, &fre, &ra_err);
+  if (ra_err != 0 && lr_regnum == -1)
+    return 0;
+
+  struct sframe_frame_cache *cache
+    = FRAME_OBSTACK_ZALLOC (struct sframe_frame_cache);
+  cache->objfile = objfile;
+  cache->cfa_regnum = (base_reg == SFRAME_BASE_REG_FP
+		       ? fp_regnum : gdbarch_sp_regnum (gdbarch));
+  cache->cfa_offset = cfa_offset;
+  cache->fp_regnum = fp_regnum;
+  cache->lr_regnum = lr_regnum;
+  cache->fp_saved_p = fp_err == 0;
+  cache->fp_offset = fp_offset;
+  cache->ra_saved_p = ra_err == 0;
+  cache->ra_offset = ra_offset;
+  *this_cache = cache;
+
+  return 1;
+}
+
+static void
+sframe_frame_dealloc_cache (frame_info *self, void *this_cache)
+{
+  struct sframe_frame_cache *cache
+    = (struct sframe_frame_cache *) this_cache;
+
+  if (cache->tailcall_cache != nullptr)
+    dwarf2_tailcall_frame_unwind.dealloc_cache (self, cache->tailcall_cache);
+}
+
+/* Implement the "retain" frame_unwind method.  */
+
+static bool
+sframe_frame_retain (frame_info_ptr this_frame, void *this_cache)
+{
+  struct sframe_frame_cache *cache
+    = sframe_frame_cache (this_frame, &this_cache);
+
+  if (!cache->cfa_p || cache->tailcall_cache != nullptr)
+    return false;
+
+  /* The DWARF frame state is otherwise computed on demand, which must
+     not happen once the cache is retained.  */
+  if (!dwarf2_frame_cfi_cache (this_frame, &cache->dwarf2_cache))
+    return true;
+
+  return dwarf2_frame_retain_cache (this_frame, cache->dwarf2_cache);
+}
+
+static const struct frame_unwind sframe_frame_unwind =
+{
+  "sframe",
+  NORMAL_FRAME,
+  sframe_frame_unwind_stop_reason,
+  sframe_frame_this_id,
+  sframe_frame_prev_register,
+  NULL,
+  sframe_frame_sniffer,
+  sframe_frame_dealloc_cache,
+  NULL,
+  sframe_frame_retain
+};
+
+/* See sframe-unwind.h.  */
+
+void
+sframe_append_unwinders (struct gdbarch *gdbarch)
+{
+  frame_unwind_append_unwinder (gdbarch, &sframe_frame_unwind);
+}
+
+/* Frames retained across stops keep the unwinder they were found with,
+   so forget them when the unwinder is turned on or off.  */
+
+static void
+set_sframe_unwinders_enabled_p (const char *args, int from_tty,
+				struct cmd_list_element *c)
+{
+  discard_retained_frames ();
+}
+
+/* Handle 'maintenance show sframe unwinders'.  */
+
+static void
+show_sframe_unwinders_enabled_p (struct ui_file *file, int from_tty,
+				 struct cmd_list_element *c,
+				 const char *value)
+{
+  gdb_printf (file,
+	      _("The SFrame stack unwinder is currently %s.\n"),
+	      value);
+}
+
+void _initialize_sframe_unwind ();
+void
+_initialize_sframe_unwind ()
+{
+  add_setshow_prefix_cmd ("sframe", class_maintenance,
+			  _("\
+Set SFrame specific variables.\n\
+Configure the use of SFrame stack trace information."),
+			  _("\
+Show SFrame specific variables.\n\
+Show the use of SFrame stack trace information."),
+			  &set_sframe_cmdlist, &show_sframe_cmdlist,
+			  &maintenance_set_cmdlist, &maintenance_show_cmdlist);
+
+  add_setshow_boolean_cmd ("unwinders", class_obscure,
+			   &sframe_unwinders_enabled_p, _("\
+Set whether the SFrame stack frame unwinder is used."), _("\
+Show whether the SFrame stack frame unwinder is used."), _("\
+When enabled, frames of functions described by an objfile's .sframe\n\
+section are unwound using that information rather than DWARF CFI.\n\
+Registers that SFrame does not describe are still unwound using DWARF CFI."),
+			   set_sframe_unwinders_enabled_p,
+			   show_sframe_unwinders_enabled_p,
+			   &set_sframe_cmdlist,
+			   &show_sframe_cmdlist);
+}
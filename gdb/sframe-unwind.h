@@ -0,0 +1,33 @@
+/* SFrame stack trace unwinder for GDB.
+
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef SFRAME_UNWIND_H
+#define SFRAME_UNWIND_H
+
+struct gdbarch;
+
+/* Append the SFrame unwinder to GDBARCH's list.  This should be done
+   just before the DWARF CFI unwinders are appended, so that the SFrame
+   data is preferred whenever an objfile has it.  Only the AMD64 and
+   AArch64 SFrame ABIs are supported; the unwinder declines frames of
+   any other architecture.  */
+
+extern void sframe_append_unwinders (struct gdbarch *gdbarch);
+
+#endif /* SFRAME_UNWIND_H */
@@ -1029,6 +1029,7 @@ solib_add (const char *pattern, int from_tty, int readsyms)
   {
     bool any_matches = false;
     bool loaded_any_symbols = false;
+    std::vector<objfile *> new_objfiles;
     symfile_add_flags add_flags = SYMFILE_DEFER_BP_RESET;
 
     if (from_tty)
@@ -1057,12 +1058,18 @@ solib_add (const char *pattern, int from_tty, int readsyms)
 				gdb->so_name);
 		}
 	      else if (solib_read_symbols (gdb, add_flags))
-		loaded_any_symbols = true;
+		{
+		  loaded_any_symbols = true;
+		  if (gdb->objfile != nullptr)
+		    new_objfiles.push_back (gdb->objfile);
+		}
 	    }
 	}
 
+    /* Only the breakpoints that may have locations in the new
+       objfiles need to be re-set.  */
     if (loaded_any_symbols)
-      breakpoint_re_set ();
+      breakpoint_re_set_objfiles (new_objfiles);
 
     if (from_tty && pattern && ! any_matches)
       gdb_printf
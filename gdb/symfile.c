@@ -1003,7 +1003,7 @@ finish_new_objfile (struct objfile *objfile, symfile_add_flags add_flags)
     }
   else if ((add_flags & SYMFILE_DEFER_BP_RESET) == 0)
     {
-      breakpoint_re_set ();
+      breakpoint_re_set_objfiles (objfile);
     }
 
   /* We're done reading the symbol file; finish off complaints.  */
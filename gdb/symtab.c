@@ -74,6 +74,10 @@
 #include "gdbsupport/pathstuff.h"
 #include "gdbsupport/common-utils.h"
 
+#if CXX_STD_THREAD
+#include <mutex>
+#endif
+
 /* Forward declarations for local functions.  */
 
 static void rbreak_command (const char *, int);
@@ -188,37 +192,63 @@ symbol_cache_clear_slot (struct symbol_cache_slot *slot)
   slot->state = SYMBOL_SLOT_UNUSED;
 }
 
+/* The number of shards of a block symbol cache.  Each shard has its
+   own lock, so that threads looking up symbols at the same time seldom
+   wait for each other.  */
+#define SYMBOL_CACHE_SHARDS 16
+
+/* A shard of a block symbol cache, holding the slots whose hash maps
+   to it.  */
+
+struct symbol_cache_shard
+{
+#if CXX_STD_THREAD
+  /* Protects all the fields below.  */
+  std::mutex mutex;
+#endif
+
+  unsigned int hits = 0;
+  unsigned int misses = 0;
+  /* The number of entries that were replaced by a new one.  */
+  unsigned int evictions = 0;
+  /* The number of slots in use.  */
+  unsigned int used = 0;
+
+  std::vector<symbol_cache_slot> symbols;
+};
+
 /* Symbols don't specify global vs static block.
    So keep them in separate caches.  */
 
 struct block_symbol_cache
 {
-  unsigned int hits;
-  unsigned int misses;
-  unsigned int collisions;
+  /* Create a cache of SIZE slots, spread over the shards.  */
+  explicit block_symbol_cache (unsigned int size_)
+    : size (size_)
+  {
+    for (unsigned int i = 0; i < SYMBOL_CACHE_SHARDS; ++i)
+      shards[i].symbols.resize (size / SYMBOL_CACHE_SHARDS
+				+ (i < size % SYMBOL_CACHE_SHARDS));
+  }
+
+  ~block_symbol_cache ()
+  {
+    for (symbol_cache_shard &shard : shards)
+      for (symbol_cache_slot &slot : shard.symbols)
+	symbol_cache_clear_slot (&slot);
+  }
 
-  /* SYMBOLS is a variable length array of this size.
+  DISABLE_COPY_AND_ASSIGN (block_symbol_cache);
+
+  /* The total number of slots.
      One can imagine that in general one cache (global/static) should be a
      fraction of the size of the other, but there's no data at the moment
      on which to decide.  */
   unsigned int size;
 
-  struct symbol_cache_slot symbols[1];
+  symbol_cache_shard shards[SYMBOL_CACHE_SHARDS];
 };
 
-/* Clear all slots of BSC and free BSC.  */
-
-static void
-destroy_block_symbol_cache (struct block_symbol_cache *bsc)
-{
-  if (bsc != nullptr)
-    {
-      for (unsigned int i = 0; i < bsc->size; i++)
-	symbol_cache_clear_slot (&bsc->symbols[i]);
-      xfree (bsc);
-    }
-}
-
 /* The symbol cache.
 
    Searching for symbols in the static and global blocks over multiple objfiles
@@ -227,20 +257,17 @@ destroy_block_symbol_cache (struct block_symbol_cache *bsc)
    overall gdb performance.
 
    Symbols are hashed on the name, its domain, and block.
-   They are also hashed on their objfile for objfile-specific lookups.  */
+   They are also hashed on their objfile for objfile-specific lookups.
+
+   The cache can be used from several threads at once: the slots are
+   spread over shards, each with its own lock.  Only resizing the cache
+   requires that no other thread uses it, which holds as it is only
+   done from a command.  */
 
 struct symbol_cache
 {
-  symbol_cache () = default;
-
-  ~symbol_cache ()
-  {
-    destroy_block_symbol_cache (global_symbols);
-    destroy_block_symbol_cache (static_symbols);
-  }
-
-  struct block_symbol_cache *global_symbols = nullptr;
-  struct block_symbol_cache *static_symbols = nullptr;
+  std::unique_ptr<block_symbol_cache> global_symbols;
+  std::unique_ptr<block_symbol_cache> static_symbols;
 };
 
 /* Program space key for finding its symbol cache.  */
@@ -378,6 +405,171 @@ compunit_symtab::set_call_site_htab (htab_t call_site_htab)
   m_call_site_htab = call_site_htab;
 }
 
+/* A compact index of the line table entries of all the filetabs of a
+   compunit_symtab, sorted by address.  It lets find_pc_sect_line find
+   the line containing a PC with a single binary search, instead of one
+   binary search per filetab.  The index is stored in columns, and the
+   addresses are stored as 32-bit offsets from BASE, to keep the index
+   small and the binary search cache-friendly.  Entries at the same
+   address are sorted by filetab and then by line table index, so that
+   walking backward from an address visits the last entry of each
+   filetab first.
+
+   The index does not replace the line tables, it refers to their
+   entries.  It costs a little over 8 bytes per entry, so it is only
+   built for compunits with several line tables: with a single one,
+   one binary search of that table is enough.  */
+
+struct compunit_line_index
+{
+  /* Return the unrelocated address of entry I.  */
+  unrelocated_addr pc (size_t i) const
+  {
+    return unrelocated_addr (CORE_ADDR (base) + pc_offsets[i]);
+  }
+
+  /* Return true if entry I marks the end of a sequence, i.e. has line
+     number zero.  */
+  bool end_p (size_t i) const
+  {
+    return (end_bits[i / 8] & (1 << (i % 8))) != 0;
+  }
+
+  /* Return the index in FILETABS of the filetab of entry I.  */
+  unsigned int filetab (size_t i) const
+  {
+    return (std::upper_bound (filetab_starts + 1,
+			      filetab_starts + nfiletabs,
+			      item_numbers[i])
+	    - (filetab_starts + 1));
+  }
+
+  /* Return the line table entry corresponding to entry I.  */
+  const linetable_entry *entry (size_t i) const
+  {
+    unsigned int f = filetab (i);
+    return &filetabs[f]->linetable ()->item[item_numbers[i]
+					     - filetab_starts[f]];
+  }
+
+  /* The lowest address in the index.  */
+  unrelocated_addr base;
+
+  /* The number of entries.  Zero if the line tables aren't indexed.  */
+  size_t nentries;
+
+  /* The filetabs with a non-empty line table, in compunit order.  */
+  symtab **filetabs;
+  unsigned int nfiletabs;
+
+  /* The entries of the line tables of FILETABS are numbered in order,
+     starting at zero.  This is the number of the first entry of each
+     filetab.  */
+  uint32_t *filetab_starts;
+
+  /* Offsets from BASE of the addresses of the entries.  */
+  uint32_t *pc_offsets;
+
+  /* For each entry, the number of the line table entry it refers to.  */
+  uint32_t *item_numbers;
+
+  /* A bitset recording which entries have line number zero.  */
+  gdb_byte *end_bits;
+};
+
+/* Build the line table index of CUST, on the objfile obstack.  */
+
+static const compunit_line_index *
+build_compunit_line_index (const compunit_symtab *cust)
+{
+  struct obstack *obstack = &cust->objfile ()->objfile_obstack;
+  compunit_line_index *index = OBSTACK_ZALLOC (obstack, compunit_line_index);
+
+  std::vector<symtab *> filetabs;
+  size_t nentries = 0;
+  unrelocated_addr low = unrelocated_addr (-1);
+  unrelocated_addr high = unrelocated_addr (0);
+  for (symtab *s : cust->filetabs ())
+    {
+      const linetable *l = s->linetable ();
+      if (l == nullptr || l->nitems <= 0)
+	continue;
+
+      filetabs.push_back (s);
+      nentries += l->nitems;
+      low = std::min (low, l->item[0].unrelocated_pc ());
+      high = std::max (high, l->item[l->nitems - 1].unrelocated_pc ());
+    }
+
+  /* Leave the index empty if there is a single line table, or if the
+     addresses don't fit the compact encoding; find_pc_sect_line then
+     searches each line table.  */
+  if (filetabs.size () < 2
+      || nentries > UINT32_MAX
+      || CORE_ADDR (high) - CORE_ADDR (low) > UINT32_MAX)
+    return index;
+
+  index->base = low;
+  index->nentries = nentries;
+  index->nfiletabs = filetabs.size ();
+  index->filetabs = XOBNEWVEC (obstack, symtab *, filetabs.size ());
+  std::copy (filetabs.begin (), filetabs.end (), index->filetabs);
+  index->filetab_starts = XOBNEWVEC (obstack, uint32_t, filetabs.size ());
+  index->pc_offsets = XOBNEWVEC (obstack, uint32_t, nentries);
+  index->item_numbers = XOBNEWVEC (obstack, uint32_t, nentries);
+  index->end_bits = XOBNEWVEC (obstack, gdb_byte, (nentries + 7) / 8);
+  memset (index->end_bits, 0, (nentries + 7) / 8);
+
+  /* Since the entries are numbered in filetab order, sorting them by
+     address and then by number gives the order described above.  */
+  uint32_t number = 0;
+  for (uint32_t f = 0; f < filetabs.size (); ++f)
+    {
+      const linetable *l = filetabs[f]->linetable ();
+      index->filetab_starts[f] = number;
+      for (int i = 0; i < l->nitems; ++i, ++number)
+	{
+	  index->pc_offsets[number]
+	    = CORE_ADDR (l->item[i].unrelocated_pc ()) - CORE_ADDR (low);
+	  index->item_numbers[number] = number;
+	}
+    }
+
+  std::sort (index->item_numbers, index->item_numbers + nentries,
+	     [index] (uint32_t a, uint32_t b)
+	     {
+	       if (index->pc_offsets[a] != index->pc_offsets[b])
+		 return index->pc_offsets[a] < index->pc_offsets[b];
+	       return a < b;
+	     });
+
+  /* PC_OFFSETS is indexed by entry number until here, put it in the
+     sorted order.  */
+  std::vector<uint32_t> offsets (index->pc_offsets,
+				 index->pc_offsets + nentries);
+  for (size_t i = 0; i < nentries; ++i)
+    {
+      index->pc_offsets[i] = offsets[index->item_numbers[i]];
+      if (index->entry (i)->line == 0)
+	index->end_bits[i / 8] |= 1 << (i % 8);
+    }
+
+  return index;
+}
+
+/* See symtab.h.  */
+
+const compunit_line_index *
+compunit_symtab::line_index () const
+{
+  if (m_line_index == nullptr)
+    m_line_index = build_compunit_line_index (this);
+
+  if (m_line_index->nentries == 0)
+    return nullptr;
+  return m_line_index;
+}
+
 /* See symtab.h.  */
 
 void
@@ -1278,17 +1470,8 @@ eq_symbol_entry (const struct symbol_cache_slot *slot,
   return 1;
 }
 
-/* Given a cache of size SIZE, return the size of the struct (with variable
-   length array) in bytes.  */
-
-static size_t
-symbol_cache_byte_size (unsigned int size)
-{
-  return (sizeof (struct block_symbol_cache)
-	  + ((size - 1) * sizeof (struct symbol_cache_slot)));
-}
-
-/* Resize CACHE.  */
+/* Resize CACHE.  This must not be done while another thread uses
+   CACHE.  */
 
 static void
 resize_symbol_cache (struct symbol_cache *cache, unsigned int new_size)
@@ -1302,33 +1485,35 @@ resize_symbol_cache (struct symbol_cache *cache, unsigned int new_size)
 	  && new_size == 0))
     return;
 
-  destroy_block_symbol_cache (cache->global_symbols);
-  destroy_block_symbol_cache (cache->static_symbols);
-
   if (new_size == 0)
     {
-      cache->global_symbols = NULL;
-      cache->static_symbols = NULL;
+      cache->global_symbols.reset ();
+      cache->static_symbols.reset ();
     }
   else
     {
-      size_t total_size = symbol_cache_byte_size (new_size);
-
-      cache->global_symbols
-	= (struct block_symbol_cache *) xcalloc (1, total_size);
-      cache->static_symbols
-	= (struct block_symbol_cache *) xcalloc (1, total_size);
-      cache->global_symbols->size = new_size;
-      cache->static_symbols->size = new_size;
+      cache->global_symbols.reset (new block_symbol_cache (new_size));
+      cache->static_symbols.reset (new block_symbol_cache (new_size));
     }
 }
 
+#if CXX_STD_THREAD
+/* Protects the symbol cache registry slot of the program spaces.  */
+static std::mutex symbol_cache_creation_mutex;
+#endif
+
 /* Return the symbol cache of PSPACE.
-   Create one if it doesn't exist yet.  */
+   Create one if it doesn't exist yet.  The registry is not safe to
+   read while another thread writes it, so the lookup is done under
+   the lock too.  */
 
 static struct symbol_cache *
 get_symbol_cache (struct program_space *pspace)
 {
+#if CXX_STD_THREAD
+  std::lock_guard<std::mutex> guard (symbol_cache_creation_mutex);
+#endif
+
   struct symbol_cache *cache = symbol_cache_key.get (pspace);
 
   if (cache == NULL)
@@ -1375,42 +1560,65 @@ set_symbol_cache_size_handler (const char *args, int from_tty,
   set_symbol_cache_size (symbol_cache_size);
 }
 
-/* Lookup symbol NAME,DOMAIN in BLOCK in the symbol cache of PSPACE.
+/* Return the cache of CACHE for BLOCK, or NULL if the cache is
+   disabled.  */
+
+static struct block_symbol_cache *
+symbol_cache_for_block (struct symbol_cache *cache, enum block_enum block)
+{
+  if (block == GLOBAL_BLOCK)
+    return cache->global_symbols.get ();
+  else
+    return cache->static_symbols.get ();
+}
+
+/* Return the shard of BSC where symbol NAME,DOMAIN looked up with
+   OBJFILE_CONTEXT goes, and set *SLOT_INDEX to the index of its slot in
+   the shard.  Return NULL if the shard has no slot.  */
+
+static struct symbol_cache_shard *
+symbol_cache_shard_for (struct block_symbol_cache *bsc,
+			const struct objfile *objfile_context,
+			const char *name, domain_enum domain,
+			unsigned int *slot_index)
+{
+  unsigned int hash = hash_symbol_entry (objfile_context, name, domain);
+  struct symbol_cache_shard *shard = &bsc->shards[hash % SYMBOL_CACHE_SHARDS];
+
+  if (shard->symbols.empty ())
+    return NULL;
+
+  *slot_index = (hash / SYMBOL_CACHE_SHARDS) % shard->symbols.size ();
+  return shard;
+}
+
+/* Lookup symbol NAME,DOMAIN in BLOCK in the symbol cache CACHE.
    OBJFILE_CONTEXT is the current objfile, which may be NULL.
    The result is the symbol if found, SYMBOL_LOOKUP_FAILED if a previous lookup
    failed (and thus this one will too), or NULL if the symbol is not present
-   in the cache.
-   *BSC_PTR and *SLOT_PTR are set to the cache and slot of the symbol, which
-   can be used to save the result of a full lookup attempt.  */
+   in the cache.  */
 
 static struct block_symbol
 symbol_cache_lookup (struct symbol_cache *cache,
 		     struct objfile *objfile_context, enum block_enum block,
-		     const char *name, domain_enum domain,
-		     struct block_symbol_cache **bsc_ptr,
-		     struct symbol_cache_slot **slot_ptr)
+		     const char *name, domain_enum domain)
 {
-  struct block_symbol_cache *bsc;
-  unsigned int hash;
-  struct symbol_cache_slot *slot;
-
-  if (block == GLOBAL_BLOCK)
-    bsc = cache->global_symbols;
-  else
-    bsc = cache->static_symbols;
+  struct block_symbol_cache *bsc = symbol_cache_for_block (cache, block);
   if (bsc == NULL)
-    {
-      *bsc_ptr = NULL;
-      *slot_ptr = NULL;
-      return {};
-    }
+    return {};
 
-  hash = hash_symbol_entry (objfile_context, name, domain);
-  slot = bsc->symbols + hash % bsc->size;
+  unsigned int slot_index;
+  struct symbol_cache_shard *shard
+    = symbol_cache_shard_for (bsc, objfile_context, name, domain,
+			      &slot_index);
+  if (shard == NULL)
+    return {};
 
-  *bsc_ptr = bsc;
-  *slot_ptr = slot;
+#if CXX_STD_THREAD
+  std::lock_guard<std::mutex> guard (shard->mutex);
+#endif
 
+  struct symbol_cache_slot *slot = &shard->symbols[slot_index];
   if (eq_symbol_entry (slot, objfile_context, name, domain))
     {
       symbol_lookup_debug_printf ("%s block symbol cache hit%s for %s, %s",
@@ -1418,7 +1626,7 @@ symbol_cache_lookup (struct symbol_cache *cache,
 				  slot->state == SYMBOL_SLOT_NOT_FOUND
 				  ? " (not found)" : "", name,
 				  domain_name (domain));
-      ++bsc->hits;
+      ++shard->hits;
       if (slot->state == SYMBOL_SLOT_NOT_FOUND)
 	return SYMBOL_LOOKUP_FAILED;
       return slot->value.found;
@@ -1429,65 +1637,113 @@ symbol_cache_lookup (struct symbol_cache *cache,
   symbol_lookup_debug_printf ("%s block symbol cache miss for %s, %s",
 			      block == GLOBAL_BLOCK ? "Global" : "Static",
 			      name, domain_name (domain));
-  ++bsc->misses;
+  ++shard->misses;
   return {};
 }
 
-/* Mark SYMBOL as found in SLOT.
-   OBJFILE_CONTEXT is the current objfile when the lookup was done, or NULL
-   if it's not needed to distinguish lookups (STATIC_BLOCK).  It is *not*
-   necessarily the objfile the symbol was found in.  */
+/* The lock held while updating a slot of the symbol cache.  */
 
-static void
-symbol_cache_mark_found (struct block_symbol_cache *bsc,
-			 struct symbol_cache_slot *slot,
-			 struct objfile *objfile_context,
-			 struct symbol *symbol,
-			 const struct block *block)
+#if CXX_STD_THREAD
+using symbol_cache_lock = std::unique_lock<std::mutex>;
+#else
+using symbol_cache_lock = int;
+#endif
+
+/* Return the slot of CACHE for BLOCK where the result of looking up
+   NAME,DOMAIN with OBJFILE_CONTEXT is saved, emptied and ready to be
+   filled, or NULL if this result can't be cached.  The lock of the
+   slot's shard is held in *GUARD.  */
+
+static struct symbol_cache_slot *
+symbol_cache_slot_for_update (struct symbol_cache *cache,
+			      struct objfile *objfile_context,
+			      enum block_enum block,
+			      const char *name, domain_enum domain,
+			      symbol_cache_lock *guard)
 {
+  struct block_symbol_cache *bsc = symbol_cache_for_block (cache, block);
   if (bsc == NULL)
-    return;
+    return NULL;
+
+  unsigned int slot_index;
+  struct symbol_cache_shard *shard
+    = symbol_cache_shard_for (bsc, objfile_context, name, domain,
+			      &slot_index);
+  if (shard == NULL)
+    return NULL;
+
+#if CXX_STD_THREAD
+  *guard = symbol_cache_lock (shard->mutex);
+#endif
+
+  struct symbol_cache_slot *slot = &shard->symbols[slot_index];
   if (slot->state != SYMBOL_SLOT_UNUSED)
     {
-      ++bsc->collisions;
+      ++shard->evictions;
       symbol_cache_clear_slot (slot);
     }
+  else
+    ++shard->used;
+
+  return slot;
+}
+
+/* Mark SYMBOL as found in CACHE, for a lookup of NAME,DOMAIN in BLOCK.
+   OBJFILE_CONTEXT is the current objfile when the lookup was done, or NULL
+   if it's not needed to distinguish lookups (STATIC_BLOCK).  It is *not*
+   necessarily the objfile the symbol was found in.  */
+
+static void
+symbol_cache_mark_found (struct symbol_cache *cache,
+			 struct objfile *objfile_context,
+			 enum block_enum block, const char *name,
+			 domain_enum domain, struct block_symbol found)
+{
+  symbol_cache_lock guard;
+  struct symbol_cache_slot *slot
+    = symbol_cache_slot_for_update (cache, objfile_context, block, name,
+				    domain, &guard);
+  if (slot == NULL)
+    return;
+
   slot->state = SYMBOL_SLOT_FOUND;
   slot->objfile_context = objfile_context;
-  slot->value.found.symbol = symbol;
-  slot->value.found.block = block;
+  slot->value.found = found;
 }
 
-/* Mark symbol NAME, DOMAIN as not found in SLOT.
+/* Mark symbol NAME, DOMAIN as not found in BLOCK in CACHE.
    OBJFILE_CONTEXT is the current objfile when the lookup was done, or NULL
    if it's not needed to distinguish lookups (STATIC_BLOCK).  */
 
 static void
-symbol_cache_mark_not_found (struct block_symbol_cache *bsc,
-			     struct symbol_cache_slot *slot,
+symbol_cache_mark_not_found (struct symbol_cache *cache,
 			     struct objfile *objfile_context,
-			     const char *name, domain_enum domain)
-{
-  if (bsc == NULL)
+			     enum block_enum block, const char *name,
+			     domain_enum domain)
+{
+  symbol_cache_lock guard;
+  struct symbol_cache_slot *slot
+    = symbol_cache_slot_for_update (cache, objfile_context, block, name,
+				    domain, &guard);
+  if (slot == NULL)
     return;
-  if (slot->state != SYMBOL_SLOT_UNUSED)
-    {
-      ++bsc->collisions;
-      symbol_cache_clear_slot (slot);
-    }
+
   slot->state = SYMBOL_SLOT_NOT_FOUND;
   slot->objfile_context = objfile_context;
   slot->value.not_found.name = xstrdup (name);
   slot->value.not_found.domain = domain;
 }
 
-/* Flush the symbol cache of PSPACE.  */
+/* Remove the entries of the symbol cache of PSPACE for which PRED
+   returns true.  If PRED is NULL, remove all the entries and reset the
+   statistics.  */
 
 static void
-symbol_cache_flush (struct program_space *pspace)
+symbol_cache_flush_if
+  (struct program_space *pspace,
+   gdb::function_view<bool (const struct symbol_cache_slot *)> pred)
 {
   struct symbol_cache *cache = symbol_cache_key.get (pspace);
-  int pass;
 
   if (cache == NULL)
     return;
@@ -1498,32 +1754,67 @@ symbol_cache_flush (struct program_space *pspace)
       return;
     }
 
-  /* If the cache is untouched since the last flush, early exit.
-     This is important for performance during the startup of a program linked
-     with 100s (or 1000s) of shared libraries.  */
-  if (cache->global_symbols->misses == 0
-      && cache->static_symbols->misses == 0)
-    return;
-
   gdb_assert (cache->global_symbols->size == symbol_cache_size);
   gdb_assert (cache->static_symbols->size == symbol_cache_size);
 
-  for (pass = 0; pass < 2; ++pass)
-    {
-      struct block_symbol_cache *bsc
-	= pass == 0 ? cache->global_symbols : cache->static_symbols;
-      unsigned int i;
+  for (block_symbol_cache *bsc : { cache->global_symbols.get (),
+				   cache->static_symbols.get () })
+    for (symbol_cache_shard &shard : bsc->shards)
+      {
+#if CXX_STD_THREAD
+	std::lock_guard<std::mutex> guard (shard.mutex);
+#endif
 
-      for (i = 0; i < bsc->size; ++i)
-	symbol_cache_clear_slot (&bsc->symbols[i]);
-    }
+	if (pred == nullptr)
+	  {
+	    shard.hits = 0;
+	    shard.misses = 0;
+	    shard.evictions = 0;
+	  }
+
+	/* If the shard is empty, early exit.  This is important for
+	   performance during the startup of a program linked with 100s
+	   (or 1000s) of shared libraries.  */
+	for (symbol_cache_slot &slot : shard.symbols)
+	  {
+	    if (shard.used == 0)
+	      break;
+	    if (slot.state != SYMBOL_SLOT_UNUSED
+		&& (pred == nullptr || pred (&slot)))
+	      {
+		symbol_cache_clear_slot (&slot);
+		--shard.used;
+	      }
+	  }
+      }
+}
+
+/* Flush the symbol cache of PSPACE.  */
+
+static void
+symbol_cache_flush (struct program_space *pspace)
+{
+  symbol_cache_flush_if (pspace, nullptr);
+}
+
+/* Remove the entries of the symbol cache of PSPACE that refer to
+   OBJFILE: the symbols it holds and the lookups done in its context.
+   If NOT_FOUND is true, also remove the lookups that failed.  */
 
-  cache->global_symbols->hits = 0;
-  cache->global_symbols->misses = 0;
-  cache->global_symbols->collisions = 0;
-  cache->static_symbols->hits = 0;
-  cache->static_symbols->misses = 0;
-  cache->static_symbols->collisions = 0;
+static void
+symbol_cache_flush_objfile (struct program_space *pspace,
+			    struct objfile *objfile, bool not_found)
+{
+  symbol_cache_flush_if (pspace, [=] (const struct symbol_cache_slot *slot)
+    {
+      if (slot->objfile_context == objfile)
+	return true;
+      if (slot->state == SYMBOL_SLOT_NOT_FOUND)
+	return not_found;
+
+      struct symbol *sym = slot->value.found.symbol;
+      return sym->is_objfile_owned () && sym->objfile () == objfile;
+    });
 }
 
 /* Dump CACHE.  */
@@ -1541,42 +1832,51 @@ symbol_cache_dump (const struct symbol_cache *cache)
 
   for (pass = 0; pass < 2; ++pass)
     {
-      const struct block_symbol_cache *bsc
-	= pass == 0 ? cache->global_symbols : cache->static_symbols;
-      unsigned int i;
+      struct block_symbol_cache *bsc
+	= pass == 0 ? cache->global_symbols.get () : cache->static_symbols.get ();
+      unsigned int i = 0;
 
       if (pass == 0)
 	gdb_printf ("Global symbols:\n");
       else
 	gdb_printf ("Static symbols:\n");
 
-      for (i = 0; i < bsc->size; ++i)
+      for (symbol_cache_shard &shard : bsc->shards)
 	{
-	  const struct symbol_cache_slot *slot = &bsc->symbols[i];
-
-	  QUIT;
+#if CXX_STD_THREAD
+	  std::lock_guard<std::mutex> guard (shard.mutex);
+#endif
 
-	  switch (slot->state)
+	  for (const symbol_cache_slot &slot_ref : shard.symbols)
 	    {
-	    case SYMBOL_SLOT_UNUSED:
-	      break;
-	    case SYMBOL_SLOT_NOT_FOUND:
-	      gdb_printf ("  [%4u] = %s, %s %s (not found)\n", i,
-			  host_address_to_string (slot->objfile_context),
-			  slot->value.not_found.name,
-			  domain_name (slot->value.not_found.domain));
-	      break;
-	    case SYMBOL_SLOT_FOUND:
-	      {
-		struct symbol *found = slot->value.found.symbol;
-		const struct objfile *context = slot->objfile_context;
+	      const struct symbol_cache_slot *slot = &slot_ref;
 
-		gdb_printf ("  [%4u] = %s, %s %s\n", i,
-			    host_address_to_string (context),
-			    found->print_name (),
-			    domain_name (found->domain ()));
-		break;
-	      }
+	      QUIT;
+
+	      switch (slot->state)
+		{
+		case SYMBOL_SLOT_UNUSED:
+		  break;
+		case SYMBOL_SLOT_NOT_FOUND:
+		  gdb_printf ("  [%4u] = %s, %s %s (not found)\n", i,
+			      host_address_to_string (slot->objfile_context),
+			      slot->value.not_found.name,
+			      domain_name (slot->value.not_found.domain));
+		  break;
+		case SYMBOL_SLOT_FOUND:
+		  {
+		    struct symbol *found = slot->value.found.symbol;
+		    const struct objfile *context = slot->objfile_context;
+
+		    gdb_printf ("  [%4u] = %s, %s %s\n", i,
+				host_address_to_string (context),
+				found->print_name (),
+				domain_name (found->domain ()));
+		    break;
+		  }
+		}
+
+	      ++i;
 	    }
 	}
     }
@@ -1632,20 +1932,35 @@ symbol_cache_stats (struct symbol_cache *cache)
 
   for (pass = 0; pass < 2; ++pass)
     {
-      const struct block_symbol_cache *bsc
-	= pass == 0 ? cache->global_symbols : cache->static_symbols;
+      struct block_symbol_cache *bsc
+	= pass == 0 ? cache->global_symbols.get () : cache->static_symbols.get ();
+      unsigned int used = 0, hits = 0, misses = 0, evictions = 0;
 
       QUIT;
 
+      for (symbol_cache_shard &shard : bsc->shards)
+	{
+#if CXX_STD_THREAD
+	  std::lock_guard<std::mutex> guard (shard.mutex);
+#endif
+
+	  used += shard.used;
+	  hits += shard.hits;
+	  misses += shard.misses;
+	  evictions += shard.evictions;
+	}
+
       if (pass == 0)
 	gdb_printf ("Global block cache stats:\n");
       else
 	gdb_printf ("Static block cache stats:\n");
 
       gdb_printf ("  size:       %u\n", bsc->size);
-      gdb_printf ("  hits:       %u\n", bsc->hits);
-      gdb_printf ("  misses:     %u\n", bsc->misses);
-      gdb_printf ("  collisions: %u\n", bsc->collisions);
+      gdb_printf ("  shards:     %u\n", SYMBOL_CACHE_SHARDS);
+      gdb_printf ("  used:       %u\n", used);
+      gdb_printf ("  hits:       %u\n", hits);
+      gdb_printf ("  misses:     %u\n", misses);
+      gdb_printf ("  evictions:  %u\n", evictions);
     }
 }
 
@@ -1679,7 +1994,19 @@ static void
 symtab_new_objfile_observer (struct objfile *objfile)
 {
   /* Ideally we'd use OBJFILE->pspace, but OBJFILE may be NULL.  */
-  symbol_cache_flush (current_program_space);
+  if (objfile == NULL
+      || objfile->pspace->objfiles_list.back ().get () != objfile)
+    {
+      symbol_cache_flush (current_program_space);
+      return;
+    }
+
+  /* OBJFILE comes last in the search order, so it can't hide the
+     symbols found so far; only the failed lookups may now succeed.
+     OBJFILE may also have been re-read, in which case its symbols are
+     gone.  This avoids flushing the whole cache each time a shared
+     library is loaded.  */
+  symbol_cache_flush_objfile (objfile->pspace, objfile, true);
 }
 
 /* This module's 'free_objfile' observer.  */
@@ -1687,7 +2014,9 @@ symtab_new_objfile_observer (struct objfile *objfile)
 static void
 symtab_free_objfile_observer (struct objfile *objfile)
 {
-  symbol_cache_flush (objfile->pspace);
+  /* Removing OBJFILE can't make a failed lookup succeed, nor change the
+     result of a lookup that found a symbol in another objfile.  */
+  symbol_cache_flush_objfile (objfile->pspace, objfile, false);
 }
 
 /* See symtab.h.  */
@@ -2536,16 +2865,13 @@ lookup_global_or_static_symbol (const char *name,
 {
   struct symbol_cache *cache = get_symbol_cache (current_program_space);
   struct block_symbol result;
-  struct block_symbol_cache *bsc;
-  struct symbol_cache_slot *slot;
 
   gdb_assert (block_index == GLOBAL_BLOCK || block_index == STATIC_BLOCK);
   gdb_assert (objfile == nullptr || block_index == GLOBAL_BLOCK);
 
   /* First see if we can find the symbol in the cache.
      This works because we use the current objfile to qualify the lookup.  */
-  result = symbol_cache_lookup (cache, objfile, block_index, name, domain,
-				&bsc, &slot);
+  result = symbol_cache_lookup (cache, objfile, block_index, name, domain);
   if (result.symbol != NULL)
     {
       if (SYMBOL_LOOKUP_FAILED_P (result))
@@ -2566,9 +2892,10 @@ lookup_global_or_static_symbol (const char *name,
        objfile);
 
   if (result.symbol != NULL)
-    symbol_cache_mark_found (bsc, slot, objfile, result.symbol, result.block);
+    symbol_cache_mark_found (cache, objfile, block_index, name, domain,
+			     result);
   else
-    symbol_cache_mark_not_found (bsc, slot, objfile, name, domain);
+    symbol_cache_mark_not_found (cache, objfile, block_index, name, domain);
 
   return result;
 }
@@ -2977,6 +3304,173 @@ find_symbol_at_address (CORE_ADDR address)
 
 
 
+/* BEST is an entry of a line table starting at FIRST.  If BEST isn't a
+   statement, scan backward through entries at the same address to see
+   if there is an entry marked as is-statement, and return it if so.
+   In theory this duplication should have been removed from the line
+   table during construction, this is just a double check.  If the line
+   table has had the duplication removed then this should be pretty
+   cheap.  */
+
+static const linetable_entry *
+prefer_is_stmt_entry (const linetable_entry *first,
+		      const linetable_entry *best)
+{
+  if (!best->is_stmt)
+    {
+      const linetable_entry *tmp = best;
+      while (tmp > first
+	     && (tmp - 1)->unrelocated_pc () == tmp->unrelocated_pc ()
+	     && (tmp - 1)->line != 0 && !tmp->is_stmt)
+	--tmp;
+      if (tmp->is_stmt)
+	best = tmp;
+    }
+
+  return best;
+}
+
+/* The maximum number of index entries lookup_compunit_line_index looks
+   at before giving up.  */
+
+static const int max_line_index_walk = 32;
+
+/* Use INDEX to find the best line table entry for PC, i.e. the entry
+   with the highest address not after PC among the last entries not
+   after PC of each filetab, ignoring the filetabs where that entry has
+   line number zero.  Among entries at that address, the one of the
+   first filetab is the best.
+
+   On success, return true, set *BEST and *BEST_SYMTAB to that entry
+   and its filetab, and *NEXT to the entry whose address ends the line,
+   leaving them alone if there is no such entry.  Return false if the
+   search would be too long, typically because PC is in a large range
+   without line information; the caller must then search each line
+   table.
+
+   This gives the same result as the search of each line table done by
+   find_pc_sect_line.  In particular, the end of the line is the first
+   entry after PC of the filetabs that the latter takes into account:
+   the filetabs with no entry before PC, and the filetabs from the
+   first one that has a candidate for the best entry.  */
+
+static bool
+lookup_compunit_line_index (const compunit_line_index *index,
+			    unrelocated_addr pc,
+			    const linetable_entry **best,
+			    symtab **best_symtab,
+			    const linetable_entry **next)
+{
+  const uint32_t *first = index->pc_offsets;
+  const uint32_t *last = first + index->nentries;
+  const uint32_t *iter;
+  if (pc < index->base)
+    iter = first;
+  else if (CORE_ADDR (pc) - CORE_ADDR (index->base) > UINT32_MAX)
+    iter = last;
+  else
+    iter = std::upper_bound (first, last,
+			     uint32_t (CORE_ADDR (pc)
+				       - CORE_ADDR (index->base)));
+
+  /* The filetabs whose last entry not after PC has been seen, and
+     whether that entry has a line number.  */
+  uint32_t seen[max_line_index_walk];
+  bool seen_line[max_line_index_walk];
+  unsigned int nseen = 0;
+  int steps = 0;
+
+  /* The entries are walked backward from PC; the next one to look at
+     is the one before BACK.  Return 1 if an entry was looked at, 0 if
+     there are no more entries, and -1 if the walk is too long.  */
+  size_t back = iter - first;
+  auto walk_back = [&] () -> int
+    {
+      if (back == 0 || nseen == index->nfiletabs)
+	return 0;
+      if (steps++ == max_line_index_walk)
+	return -1;
+
+      size_t e = --back;
+      uint32_t filetab = index->filetab (e);
+      if (std::find (seen, seen + nseen, filetab) == seen + nseen)
+	{
+	  seen[nseen] = filetab;
+	  seen_line[nseen] = !index->end_p (e);
+	  ++nseen;
+	}
+      return 1;
+    };
+
+  /* Find the best entry.  Entries at the same address are walked
+     backward from the last filetab, so the one of the first filetab
+     is found last.  */
+  size_t found = index->nentries;
+  while (found == index->nentries
+	 || (back > 0 && index->pc (back - 1) == index->pc (found)))
+    {
+      unsigned int old_nseen = nseen;
+      int res = walk_back ();
+      if (res < 0)
+	return false;
+      if (res == 0)
+	break;
+      if (nseen > old_nseen && seen_line[nseen - 1])
+	found = back;
+    }
+
+  if (found == index->nentries)
+    return true;
+
+  uint32_t best_filetab = index->filetab (found);
+
+  /* Find the end of the line.  An entry after PC is ignored if its
+     filetab has entries before PC, but neither it nor any filetab
+     before it has a candidate for the best entry.  */
+  for (const uint32_t *n = iter; n != last; ++n)
+    {
+      if (steps++ == max_line_index_walk)
+	return false;
+
+      size_t e = n - first;
+      uint32_t filetab = index->filetab (e);
+      bool use = (filetab >= best_filetab
+		  || (index->item_numbers[e]
+		      == index->filetab_starts[filetab]));
+      while (!use)
+	{
+	  unsigned int nseen_before = 0;
+	  for (unsigned int k = 0; k < nseen; ++k)
+	    if (seen[k] <= filetab)
+	      {
+		++nseen_before;
+		if (seen_line[k])
+		  use = true;
+	      }
+	  if (use || nseen_before == filetab + 1)
+	    break;
+
+	  int res = walk_back ();
+	  if (res < 0)
+	    return false;
+	  if (res == 0)
+	    break;
+	}
+
+      if (use)
+	{
+	  *next = index->entry (e);
+	  break;
+	}
+    }
+
+  symtab *s = index->filetabs[best_filetab];
+  *best = prefer_is_stmt_entry (s->linetable ()->item, index->entry (found));
+  *best_symtab = s;
+
+  return true;
+}
+
 /* Find the source file and line number for a given PC value and SECTION.
    Return a structure containing a symtab pointer, a line number,
    and a pc range for the entire source line.
@@ -3138,96 +3632,99 @@ find_pc_sect_line (CORE_ADDR pc, struct obj_section *section, int notcurrent)
   bv = cust->blockvector ();
   struct objfile *objfile = cust->objfile ();
 
-  /* Look at all the symtabs that share this blockvector.
-     They all have the same apriori range, that we found was right;
-     but they have different line tables.  */
+  /* Most of the time, a single lookup in the line table index of the
+     compunit finds the best line and its end.  */
 
-  for (symtab *iter_s : cust->filetabs ())
+  const compunit_line_index *index = cust->line_index ();
+  const linetable_entry *next = nullptr;
+  if (index != nullptr
+      && lookup_compunit_line_index (index,
+				     unrelocated_addr
+				       (pc - objfile->text_section_offset ()),
+				     &best, &best_symtab, &next))
     {
-      /* Find the best line in this symtab.  */
-      l = iter_s->linetable ();
-      if (!l)
-	continue;
-      len = l->nitems;
-      if (len <= 0)
+      if (best != nullptr && next != nullptr)
+	best_end = next->pc (objfile);
+    }
+  else
+    {
+      /* Otherwise, look at all the symtabs that share this blockvector.
+	 They all have the same apriori range, that we found was right;
+	 but they have different line tables.  */
+
+      for (symtab *iter_s : cust->filetabs ())
 	{
-	  /* I think len can be zero if the symtab lacks line numbers
-	     (e.g. gcc -g1).  (Either that or the LINETABLE is NULL;
-	     I'm not sure which, and maybe it depends on the symbol
-	     reader).  */
-	  continue;
-	}
+	  /* Find the best line in this symtab.  */
+	  l = iter_s->linetable ();
+	  if (!l)
+	    continue;
+	  len = l->nitems;
+	  if (len <= 0)
+	    {
+	      /* I think len can be zero if the symtab lacks line numbers
+		 (e.g. gcc -g1).  (Either that or the LINETABLE is NULL;
+		 I'm not sure which, and maybe it depends on the symbol
+		 reader).  */
+	      continue;
+	    }
 
-      prev = NULL;
-      item = l->item;		/* Get first line info.  */
+	  prev = NULL;
+	  item = l->item;		/* Get first line info.  */
 
-      /* Is this file's first line closer than the first lines of other files?
-	 If so, record this file, and its first line, as best alternate.  */
-      if (item->pc (objfile) > pc
-	  && (!alt || item->unrelocated_pc () < alt->unrelocated_pc ()))
-	alt = item;
+	  /* Is this file's first line closer than the first lines of other
+	     files?  If so, record this file, and its first line, as best
+	     alternate.  */
+	  if (item->pc (objfile) > pc
+	      && (!alt || item->unrelocated_pc () < alt->unrelocated_pc ()))
+	    alt = item;
 
-      auto pc_compare = [] (const unrelocated_addr &comp_pc,
-			    const struct linetable_entry & lhs)
-      {
-	return comp_pc < lhs.unrelocated_pc ();
-      };
-
-      const linetable_entry *first = item;
-      const linetable_entry *last = item + len;
-      item = (std::upper_bound
-	      (first, last,
-	       unrelocated_addr (pc - objfile->text_section_offset ()),
-	       pc_compare));
-      if (item != first)
-	prev = item - 1;		/* Found a matching item.  */
-
-      /* At this point, prev points at the line whose start addr is <= pc, and
-	 item points at the next line.  If we ran off the end of the linetable
-	 (pc >= start of the last line), then prev == item.  If pc < start of
-	 the first line, prev will not be set.  */
-
-      /* Is this file's best line closer than the best in the other files?
-	 If so, record this file, and its best line, as best so far.  Don't
-	 save prev if it represents the end of a function (i.e. line number
-	 0) instead of a real line.  */
-
-      if (prev && prev->line
-	  && (!best || prev->unrelocated_pc () > best->unrelocated_pc ()))
-	{
-	  best = prev;
-	  best_symtab = iter_s;
-
-	  /* If during the binary search we land on a non-statement entry,
-	     scan backward through entries at the same address to see if
-	     there is an entry marked as is-statement.  In theory this
-	     duplication should have been removed from the line table
-	     during construction, this is just a double check.  If the line
-	     table has had the duplication removed then this should be
-	     pretty cheap.  */
-	  if (!best->is_stmt)
+	  auto pc_compare = [] (const unrelocated_addr &comp_pc,
+				const struct linetable_entry & lhs)
+	  {
+	    return comp_pc < lhs.unrelocated_pc ();
+	  };
+
+	  const linetable_entry *first = item;
+	  const linetable_entry *last = item + len;
+	  item = (std::upper_bound
+		  (first, last,
+		   unrelocated_addr (pc - objfile->text_section_offset ()),
+		   pc_compare));
+	  if (item != first)
+	    prev = item - 1;		/* Found a matching item.  */
+
+	  /* At this point, prev points at the line whose start addr is <= pc,
+	     and item points at the next line.  If we ran off the end of the
+	     linetable (pc >= start of the last line), then prev == item.  If
+	     pc < start of the first line, prev will not be set.  */
+
+	  /* Is this file's best line closer than the best in the other
+	     files?  If so, record this file, and its best line, as best so
+	     far.  Don't save prev if it represents the end of a function
+	     (i.e. line number 0) instead of a real line.  */
+
+	  if (prev && prev->line
+	      && (!best || prev->unrelocated_pc () > best->unrelocated_pc ()))
 	    {
-	      const linetable_entry *tmp = best;
-	      while (tmp > first
-		     && (tmp - 1)->unrelocated_pc () == tmp->unrelocated_pc ()
-		     && (tmp - 1)->line != 0 && !tmp->is_stmt)
-		--tmp;
-	      if (tmp->is_stmt)
-		best = tmp;
+	      best_symtab = iter_s;
+
+	      /* If during the binary search we land on a non-statement entry,
+		 prefer an is-statement entry at the same address.  */
+	      best = prefer_is_stmt_entry (first, prev);
+
+	      /* Discard BEST_END if it's before the PC of the current BEST.  */
+	      if (best_end <= best->pc (objfile))
+		best_end = 0;
 	    }
 
-	  /* Discard BEST_END if it's before the PC of the current BEST.  */
-	  if (best_end <= best->pc (objfile))
-	    best_end = 0;
+	  /* If another line (denoted by ITEM) is in the linetable and its
+	     PC is after BEST's PC, but before the current BEST_END, then
+	     use ITEM's PC as the new best_end.  */
+	  if (best && item < last
+	      && item->unrelocated_pc () > best->unrelocated_pc ()
+	      && (best_end == 0 || best_end > item->pc (objfile)))
+	    best_end = item->pc (objfile);
 	}
-
-      /* If another line (denoted by ITEM) is in the linetable and its
-	 PC is after BEST's PC, but before the current BEST_END, then
-	 use ITEM's PC as the new best_end.  */
-      if (best && item < last
-	  && item->unrelocated_pc () > best->unrelocated_pc ()
-	  && (best_end == 0 || best_end > item->pc (objfile)))
-	best_end = item->pc (objfile);
     }
 
   if (!best_symtab)
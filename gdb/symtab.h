@@ -51,6 +51,7 @@ struct axs_value;
 struct agent_expr;
 struct program_space;
 struct language_defn;
+struct compunit_line_index;
 struct common_block;
 struct obj_section;
 struct cmd_list_element;
@@ -1892,6 +1893,11 @@ struct compunit_symtab
   /* Find call_site info for PC.  */
   call_site *find_call_site (CORE_ADDR pc) const;
 
+  /* Return the address-sorted index of the line tables of all the
+     filetabs of this compunit, building it on first use.  Return NULL
+     if the line tables can't be indexed.  */
+  const struct compunit_line_index *line_index () const;
+
   /* Return the language of this compunit_symtab.  */
   enum language language () const;
 
@@ -1947,6 +1953,10 @@ struct compunit_symtab
   /* struct call_site entries for this compilation unit or NULL.  */
   htab_t m_call_site_htab;
 
+  /* The index of the line tables of the filetabs, or NULL if it
+     hasn't been built yet.  See line_index.  */
+  mutable const struct compunit_line_index *m_line_index;
+
   /* The macro table for this symtab.  Like the blockvector, this
      is shared between different symtabs in a given compilation unit.
      It's debatable whether it *should* be shared among all the symtabs in
@@ -20,6 +20,11 @@
 #include "gdbcmd.h"
 #include "progspace.h"
 #include "cli/cli-cmds.h"
+#include "gdbarch.h"
+#include "gdbthread.h"
+#include "inferior.h"
+#include "regcache.h"
+#include "observable.h"
 
 /* The target dcache is kept per-address-space.  This key lets us
    associate the cache with the address space.  */
@@ -27,6 +32,11 @@
 static const registry<address_space>::key<DCACHE, dcache_deleter>
   target_dcache_aspace_key;
 
+/* Incremented whenever the memory of the threads may have changed, to
+   tell the stack snapshots that are out of date.  */
+
+static unsigned int stack_snapshot_generation;
+
 /* Target dcache is initialized or not.  */
 
 int
@@ -48,6 +58,8 @@ target_dcache_invalidate (void)
 
   if (dcache != NULL)
     dcache_invalidate (dcache);
+
+  ++stack_snapshot_generation;
 }
 
 /* Return the target dcache.  Return NULL if target dcache is not
@@ -153,6 +165,127 @@ code_cache_enabled_p (void)
   return code_cache_enabled;
 }
 
+/* The number of bytes of each thread's stack that
+   target_dcache_read_stack_snapshots reads, and the size of the pages
+   it reads them in.  Reading the snapshot in pages lets the read stop
+   at the end of the stack mapping without losing the rest.  */
+static const ULONGEST stack_snapshot_size = 16 * 1024;
+static const ULONGEST stack_snapshot_page_size = 4096;
+
+/* See target-dcache.h.  */
+
+std::vector<stack_snapshot>
+target_dcache_read_stack_snapshots (gdb::array_view<thread_info *> threads)
+{
+  std::vector<stack_snapshot> snapshots;
+  if (!stack_cache_enabled_p ())
+    return snapshots;
+
+  for (thread_info *tp : threads)
+    {
+      gdb_assert (!tp->executing ());
+
+      try
+	{
+	  struct regcache *regcache = get_thread_regcache (tp);
+	  struct gdbarch *gdbarch = regcache->arch ();
+	  int sp_regnum = gdbarch_sp_regnum (gdbarch);
+
+	  /* The frames are above the stack pointer only if the stack
+	     grows down.  */
+	  if (sp_regnum < 0 || !gdbarch_inner_than (gdbarch, 1, 2))
+	    continue;
+
+	  ULONGEST sp;
+	  if (regcache_cooked_read_unsigned (regcache, sp_regnum, &sp)
+	      != REG_VALID)
+	    continue;
+
+	  CORE_ADDR addr = align_down (sp, stack_snapshot_page_size);
+	  snapshots.push_back ({tp, stack_snapshot_generation, addr,
+				gdb::byte_vector (stack_snapshot_size)});
+	}
+      catch (const gdb_exception_error &ex)
+	{
+	  /* Leave this thread alone, unwinding it will report the
+	     error.  */
+	}
+    }
+
+  /* All the threads of an inferior share its memory, so read the
+     stacks of consecutive threads of the same inferior in one go, from
+     one of them.  */
+  scoped_restore_current_thread restore_thread;
+  std::vector<stack_snapshot> result;
+  result.reserve (snapshots.size ());
+
+  size_t first = 0;
+  while (first < snapshots.size ())
+    {
+      inferior *inf = snapshots[first].thread->inf;
+      size_t last = first;
+      while (last < snapshots.size () && snapshots[last].thread->inf == inf)
+	++last;
+
+      const ULONGEST pages_per_snapshot
+	= stack_snapshot_size / stack_snapshot_page_size;
+      std::vector<memory_read_request> requests;
+      requests.reserve ((last - first) * pages_per_snapshot);
+      for (size_t i = first; i < last; ++i)
+	for (ULONGEST page = 0; page < pages_per_snapshot; ++page)
+	  {
+	    ULONGEST offset = page * stack_snapshot_page_size;
+	    requests.emplace_back (snapshots[i].addr + offset,
+				   snapshots[i].data.data () + offset,
+				   stack_snapshot_page_size);
+	  }
+
+      switch_to_thread (snapshots[first].thread);
+      if (target_read_raw_memory_ranges (requests))
+	{
+	  /* Keep what was read contiguously from the start of each
+	     snapshot.  */
+	  for (size_t i = first; i < last; ++i)
+	    {
+	      ULONGEST len = 0;
+	      for (ULONGEST page = 0; page < pages_per_snapshot; ++page)
+		{
+		  const memory_read_request &request
+		    = requests[(i - first) * pages_per_snapshot + page];
+		  len += request.xfered_len;
+		  if (request.xfered_len != request.len)
+		    break;
+		}
+
+	      if (len != 0)
+		{
+		  snapshots[i].data.resize (len);
+		  result.push_back (std::move (snapshots[i]));
+		}
+	    }
+	}
+
+      first = last;
+    }
+
+  return result;
+}
+
+/* See target-dcache.h.  */
+
+void
+target_dcache_install_stack_snapshot (const stack_snapshot &snapshot)
+{
+  gdb_assert (snapshot.thread == inferior_thread ());
+
+  if (!stack_cache_enabled_p ()
+      || snapshot.generation != stack_snapshot_generation)
+    return;
+
+  dcache_fill (target_dcache_get_or_init (), snapshot.addr,
+	       snapshot.data.data (), snapshot.data.size ());
+}
+
 /* Implement the 'maint flush dcache' command.  */
 
 static void
@@ -163,10 +296,22 @@ maint_flush_dcache_command (const char *command, int from_tty)
     gdb_printf (_("The dcache was flushed.\n"));
 }
 
+/* Observer for the memory_changed event.  */
+
+static void
+target_dcache_memory_changed (inferior *inf, CORE_ADDR addr, ssize_t len,
+			      const bfd_byte *data)
+{
+  ++stack_snapshot_generation;
+}
+
 void _initialize_target_dcache ();
 void
 _initialize_target_dcache ()
 {
+  gdb::observers::memory_changed.attach (target_dcache_memory_changed,
+					 "target-dcache");
+
   add_setshow_boolean_cmd ("stack-cache", class_support,
 			   &stack_cache_enabled_1, _("\
 Set cache use for stack access."), _("\
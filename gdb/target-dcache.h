@@ -19,6 +19,10 @@
 #define TARGET_DCACHE_H
 
 #include "dcache.h"
+#include "gdbsupport/array-view.h"
+#include "gdbsupport/byte-vector.h"
+
+struct thread_info;
 
 extern void target_dcache_invalidate (void);
 
@@ -32,4 +36,35 @@ extern int stack_cache_enabled_p (void);
 
 extern int code_cache_enabled_p (void);
 
+/* The memory at the top of the stack of a thread, read ahead of
+   unwinding it.  */
+
+struct stack_snapshot
+{
+  /* The thread.  */
+  thread_info *thread;
+  /* When the snapshot was read.  It is out of date once the memory of
+     the threads may have changed.  */
+  unsigned int generation;
+  /* The address of the data.  */
+  CORE_ADDR addr;
+  /* The memory read at ADDR.  */
+  gdb::byte_vector data;
+};
+
+/* Read the top of the stack of each of THREADS, which must all be
+   stopped, with as few target operations as possible.  The threads
+   whose stack couldn't be read, e.g. because the target can't read
+   several memory ranges at once, get no snapshot.  */
+
+extern std::vector<stack_snapshot> target_dcache_read_stack_snapshots
+  (gdb::array_view<thread_info *> threads);
+
+/* Store SNAPSHOT in the target dcache, so that unwinding its thread
+   reads from it rather than from the target, unless it is out of
+   date.  The thread of SNAPSHOT must be the current thread.  */
+
+extern void target_dcache_install_stack_snapshot
+  (const stack_snapshot &snapshot);
+
 #endif /* TARGET_DCACHE_H */
@@ -160,6 +160,10 @@
   target_debug_do_print (host_address_to_string (X.get ()))
 #define target_debug_print_gdb_array_view_const_int(X)	\
   target_debug_do_print (host_address_to_string (X.data ()))
+#define target_debug_print_gdb_array_view_memory_read_request(X) \
+  target_debug_do_print (host_address_to_string (X.data ()))
+#define target_debug_print_gdb_array_view_thread_info_p(X) \
+  target_debug_do_print (host_address_to_string (X.data ()))
 #define target_debug_print_inferior_p(inf) \
   target_debug_do_print (host_address_to_string (inf))
 #define target_debug_print_record_print_flags(X) \
@@ -39,6 +39,7 @@ struct dummy_target : public target_ops
   void fetch_registers (struct regcache *arg0, int arg1) override;
   void store_registers (struct regcache *arg0, int arg1) override;
   void prepare_to_store (struct regcache *arg0) override;
+  void prefetch_registers (gdb::array_view<thread_info *> arg0) override;
   void files_info () override;
   int insert_breakpoint (struct gdbarch *arg0, struct bp_target_info *arg1) override;
   int remove_breakpoint (struct gdbarch *arg0, struct bp_target_info *arg1, enum remove_bp_reason arg2) override;
@@ -113,6 +114,7 @@ struct dummy_target : public target_ops
   void goto_bookmark (const gdb_byte *arg0, int arg1) override;
   CORE_ADDR get_thread_local_address (ptid_t arg0, CORE_ADDR arg1, CORE_ADDR arg2) override;
   enum target_xfer_status xfer_partial (enum target_object arg0, const char *arg1, gdb_byte *arg2, const gdb_byte *arg3, ULONGEST arg4, ULONGEST arg5, ULONGEST *arg6) override;
+  bool read_raw_memory_ranges (gdb::array_view<memory_read_request> arg0) override;
   ULONGEST get_memory_xfer_limit () override;
   std::vector<mem_region> memory_map () override;
   void flash_erase (ULONGEST arg0, LONGEST arg1) override;
@@ -213,6 +215,7 @@ struct debug_target : public target_ops
   void fetch_registers (struct regcache *arg0, int arg1) override;
   void store_registers (struct regcache *arg0, int arg1) override;
   void prepare_to_store (struct regcache *arg0) override;
+  void prefetch_registers (gdb::array_view<thread_info *> arg0) override;
   void files_info () override;
   int insert_breakpoint (struct gdbarch *arg0, struct bp_target_info *arg1) override;
   int remove_breakpoint (struct gdbarch *arg0, struct bp_target_info *arg1, enum remove_bp_reason arg2) override;
@@ -287,6 +290,7 @@ struct debug_target : public target_ops
   void goto_bookmark (const gdb_byte *arg0, int arg1) override;
   CORE_ADDR get_thread_local_address (ptid_t arg0, CORE_ADDR arg1, CORE_ADDR arg2) override;
   enum target_xfer_status xfer_partial (enum target_object arg0, const char *arg1, gdb_byte *arg2, const gdb_byte *arg3, ULONGEST arg4, ULONGEST arg5, ULONGEST *arg6) override;
+  bool read_raw_memory_ranges (gdb::array_view<memory_read_request> arg0) override;
   ULONGEST get_memory_xfer_limit () override;
   std::vector<mem_region> memory_map () override;
   void flash_erase (ULONGEST arg0, LONGEST arg1) override;
@@ -585,6 +589,27 @@ debug_target::prepare_to_store (struct regcache *arg0)
   gdb_puts (")\n", gdb_stdlog);
 }
 
+void
+target_ops::prefetch_registers (gdb::array_view<thread_info *> arg0)
+{
+  this->beneath ()->prefetch_registers (arg0);
+}
+
+void
+dummy_target::prefetch_registers (gdb::array_view<thread_info *> arg0)
+{
+}
+
+void
+debug_target::prefetch_registers (gdb::array_view<thread_info *> arg0)
+{
+  gdb_printf (gdb_stdlog, "-> %s->prefetch_registers (...)\n", this->beneath ()->shortname ());
+  this->beneath ()->prefetch_registers (arg0);
+  gdb_printf (gdb_stdlog, "<- %s->prefetch_registers (", this->beneath ()->shortname ());
+  target_debug_print_gdb_array_view_thread_info_p (arg0);
+  gdb_puts (")\n", gdb_stdlog);
+}
+
 void
 target_ops::files_info ()
 {
@@ -2474,6 +2499,32 @@ debug_target::xfer_partial (enum target_object arg0, const char *arg1, gdb_byte
   return result;
 }
 
+bool
+target_ops::read_raw_memory_ranges (gdb::array_view<memory_read_request> arg0)
+{
+  return this->beneath ()->read_raw_memory_ranges (arg0);
+}
+
+bool
+dummy_target::read_raw_memory_ranges (gdb::array_view<memory_read_request> arg0)
+{
+  return false;
+}
+
+bool
+debug_target::read_raw_memory_ranges (gdb::array_view<memory_read_request> arg0)
+{
+  bool result;
+  gdb_printf (gdb_stdlog, "-> %s->read_raw_memory_ranges (...)\n", this->beneath ()->shortname ());
+  result = this->beneath ()->read_raw_memory_ranges (arg0);
+  gdb_printf (gdb_stdlog, "<- %s->read_raw_memory_ranges (", this->beneath ()->shortname ());
+  target_debug_print_gdb_array_view_memory_read_request (arg0);
+  gdb_puts (") = ", gdb_stdlog);
+  target_debug_print_bool (result);
+  gdb_puts ("\n", gdb_stdlog);
+  return result;
+}
+
 ULONGEST
 target_ops::get_memory_xfer_limit ()
 {
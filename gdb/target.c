@@ -245,6 +245,24 @@ target_prepare_to_store (regcache *regcache)
 
 /* See target.h.  */
 
+void
+target_prefetch_registers (gdb::array_view<thread_info *> threads)
+{
+  /* Each inferior has its own target stack.  */
+  for (inferior *inf : all_non_exited_inferiors ())
+    {
+      std::vector<thread_info *> inf_threads;
+      for (thread_info *tp : threads)
+	if (tp->inf == inf)
+	  inf_threads.push_back (tp);
+
+      if (!inf_threads.empty ())
+	inf->top_target ()->prefetch_registers (inf_threads);
+    }
+}
+
+/* See target.h.  */
+
 bool
 target_supports_enable_disable_tracepoint ()
 {
@@ -1809,6 +1827,20 @@ target_read_raw_memory (CORE_ADDR memaddr, gdb_byte *myaddr, ssize_t len)
     return -1;
 }
 
+/* See target.h.  */
+
+bool
+target_read_raw_memory_ranges (gdb::array_view<memory_read_request> requests)
+{
+  /* Some memory may have to be read from the executable files instead,
+     see memory_xfer_partial_1.  */
+  if (overlay_debugging || trust_readonly)
+    return false;
+
+  return current_inferior ()->top_target ()->read_raw_memory_ranges
+    (requests);
+}
+
 /* Like target_read_memory, but specify explicitly that this is a read from
    the target's stack.  This may trigger different cache behavior.  */
 
@@ -297,6 +297,29 @@ struct memory_read_result
 extern std::vector<memory_read_result> read_memory_robust
     (struct target_ops *ops, const ULONGEST offset, const LONGEST len);
 
+/* A request to read LEN bytes of memory at ADDRESS into BUF, for
+   target_read_raw_memory_ranges.  */
+
+struct memory_read_request
+{
+  memory_read_request (CORE_ADDR address_, gdb_byte *buf_, ULONGEST len_)
+    : address (address_),
+      buf (buf_),
+      len (len_)
+  {
+  }
+
+  /* The address to read from.  */
+  CORE_ADDR address;
+  /* Where to store the data.  */
+  gdb_byte *buf;
+  /* The number of bytes to read.  */
+  ULONGEST len;
+  /* The number of bytes that were read, from the start of the
+     range.  */
+  ULONGEST xfered_len = 0;
+};
+
 /* Request that OPS transfer up to LEN addressable units from BUF to the
    target's OBJECT.  When writing to a memory object, the addressable unit
    size is architecture dependent and can be found using
@@ -512,6 +535,14 @@ struct target_ops
     virtual void prepare_to_store (struct regcache *)
       TARGET_DEFAULT_NORETURN (noprocess ());
 
+    /* Fetch the registers of each of THREADS, which are stopped, into
+       their register caches, if the target can do that faster than
+       one thread at a time, e.g. by overlapping the requests.  Targets
+       that supply the registers of some threads themselves must not
+       let this reach the target beneath for those threads.  */
+    virtual void prefetch_registers (gdb::array_view<thread_info *> threads)
+      TARGET_DEFAULT_IGNORE ();
+
     virtual void files_info ()
       TARGET_DEFAULT_IGNORE ();
     virtual int insert_breakpoint (struct gdbarch *,
@@ -800,6 +831,18 @@ struct target_ops
 						  ULONGEST *xfered_len)
       TARGET_DEFAULT_RETURN (TARGET_XFER_E_IO);
 
+    /* Read the raw memory of each of REQUESTS, setting its xfered_len
+       to the number of bytes read, e.g. with a single system call for
+       all of them.  Return false if the target can't do that, in
+       which case no request was read.  The requests that weren't
+       fully read should be read again with xfer_partial, to find out
+       why.  Targets that don't pass all memory reads down to the
+       target beneath in xfer_partial must implement this method too,
+       even if only to return false.  */
+    virtual bool read_raw_memory_ranges
+      (gdb::array_view<memory_read_request> requests)
+      TARGET_DEFAULT_RETURN (false);
+
     /* Return the limit on the size of any single memory transfer
        for the target.  */
 
@@ -1533,6 +1576,12 @@ extern void target_store_registers (struct regcache *regcache, int regs);
 
 extern void target_prepare_to_store (regcache *regcache);
 
+/* Fetch the registers of the stopped THREADS ahead of their use, if
+   the targets of their inferiors can do that faster than one thread at
+   a time.  See target_ops::prefetch_registers.  */
+
+extern void target_prefetch_registers (gdb::array_view<thread_info *> threads);
+
 /* Determine current address space of thread PTID.  */
 
 struct address_space *target_thread_address_space (ptid_t);
@@ -1578,6 +1627,12 @@ extern bool target_can_run_breakpoint_commands ();
 extern int target_read_raw_memory (CORE_ADDR memaddr, gdb_byte *myaddr,
 				   ssize_t len);
 
+/* Read the raw memory of each of REQUESTS at once, if the target
+   supports it.  See target_ops::read_raw_memory_ranges.  */
+
+extern bool target_read_raw_memory_ranges
+  (gdb::array_view<memory_read_request> requests);
+
 extern int target_read_stack (CORE_ADDR memaddr, gdb_byte *myaddr, ssize_t len);
 
 extern int target_read_code (CORE_ADDR memaddr, gdb_byte *myaddr, ssize_t len);
@@ -0,0 +1,50 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2023 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+struct request
+{
+  int id;
+  short flags;
+  struct request *next;
+};
+
+volatile int handled;
+
+void __attribute__ ((noinline))
+handle (struct request *req)
+{
+  handled++;	/* handle line */
+}
+
+int
+main ()
+{
+  struct request reqs[100];
+  int i;
+
+  for (i = 0; i < 100; i++)
+    {
+      reqs[i].id = 1000 + i;
+      reqs[i].flags = (i % 7 == 3) ? -i : i;
+      reqs[i].next = (i == 50) ? 0 : &reqs[i + 1];
+    }
+
+  for (i = 0; i < 100; i++)
+    handle (&reqs[i]);
+
+  return 0;
+}
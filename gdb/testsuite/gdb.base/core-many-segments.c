@@ -0,0 +1,57 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2023 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define NR_PAGES 256
+
+int *pages;
+long page_size;
+
+static void
+marker (void)
+{
+}
+
+int
+main (int argc, char **argv)
+{
+  int i, j;
+
+  page_size = sysconf (_SC_PAGESIZE);
+  pages = mmap (NULL, NR_PAGES * page_size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (pages == MAP_FAILED)
+    return 1;
+
+  /* Fill each page with its number, and make every other page
+     read-only, so that each page is a segment of its own.  */
+  for (i = 0; i < NR_PAGES; i++)
+    for (j = 0; j < page_size / sizeof (int); j++)
+      pages[i * page_size / sizeof (int) + j] = i;
+  for (i = 0; i < NR_PAGES; i += 2)
+    mprotect ((char *) pages + i * page_size, page_size, PROT_READ);
+
+  /* Dump core if asked to.  */
+  if (argc > 1)
+    abort ();
+
+  marker ();
+  return 0;
+}
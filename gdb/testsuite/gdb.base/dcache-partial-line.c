@@ -0,0 +1,77 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2023 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
+
+size_t pg_size;
+size_t line_size;
+unsigned char *lines;
+
+void
+breakpt (void)
+{
+  /* Nothing. */
+}
+
+int
+main (void)
+{
+  unsigned char *p;
+
+  /* Find two contiguous blocks of LINE_SIZE bytes, aligned on
+     LINE_SIZE, and unmap the last page of the second one.  GDB reads
+     them as two dcache lines, the second of which crosses into the
+     unmapped page.
+
+      .---.---.---.---.
+      | M | M | M | U |
+      '---'---'---'---'
+      |       |       |  <- line alignment
+       ^^^^^^^ ^^^^^^^
+          |       |
+          + line1 + line2  */
+
+  pg_size = getpagesize ();
+  line_size = 2 * pg_size;
+
+  p = mmap (0, 3 * line_size, PROT_READ|PROT_WRITE,
+	    MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
+  if (p == MAP_FAILED)
+    {
+      perror ("mmap");
+      return EXIT_FAILURE;
+    }
+
+  lines = (unsigned char *) (((uintptr_t) p + line_size - 1)
+			     & -(uintptr_t) line_size);
+  memset (lines, 0x5a, 2 * line_size);
+
+  if (munmap (lines + 2 * line_size - pg_size, pg_size) == -1)
+    {
+      perror ("munmap");
+      return EXIT_FAILURE;
+    }
+
+  breakpt ();
+
+  return EXIT_SUCCESS;
+}
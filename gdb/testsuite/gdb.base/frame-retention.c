@@ -0,0 +1,49 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2023 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#define DEPTH 40
+
+volatile int counter;
+
+static void __attribute__ ((noinline))
+work (int n)
+{
+  counter += n;
+}
+
+static int __attribute__ ((noinline))
+recurse (int depth)
+{
+  int i, sum = 0;
+
+  if (depth > 0)
+    return recurse (depth - 1) + depth;
+
+  for (i = 0; i < 3; i++)
+    {
+      work (i);		/* loop line */
+      sum += counter;
+    }
+
+  return sum;
+}
+
+int
+main (void)
+{
+  return recurse (DEPTH) == 0;
+}
@@ -0,0 +1,42 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2023 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BUF_SIZE (16 * 1024 * 1024)
+
+char *buf;
+int glob[1024] = { 1, 2, 3 };
+
+static void
+marker (void)
+{
+}
+
+int
+main (void)
+{
+  buf = malloc (BUF_SIZE);
+  memset (buf, 0, BUF_SIZE);
+  memset (buf + 4096, 0x5a, 8192);
+  buf[BUF_SIZE - 1] = 0x33;
+  glob[1023] = 42;
+
+  marker ();
+  return 0;
+}
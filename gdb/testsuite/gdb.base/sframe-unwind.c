@@ -0,0 +1,45 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2023 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+volatile int sink;
+
+static void __attribute__ ((noinline))
+leaf (int depth)
+{
+  sink = depth;		/* break here */
+}
+
+static int __attribute__ ((noinline))
+recurse (int depth)
+{
+  /* Keep a value live across the call, so that it is likely to end
+     up in a callee-saved register.  */
+  int saved = depth * 3 + sink;
+
+  if (depth == 0)
+    leaf (depth);
+  else
+    recurse (depth - 1);
+
+  return saved + sink;
+}
+
+int
+main (void)
+{
+  return recurse (5) == 0;
+}
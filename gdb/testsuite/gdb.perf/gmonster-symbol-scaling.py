@@ -0,0 +1,115 @@
+# Copyright (C) 2023 Free Software Foundation, Inc.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Measure how symbol loading and the main symbol lookup paths scale with
+# the number of compunits.  Each phase is measured separately, with the
+# phase name appended to the run name, e.g. "1000-cus:lookup-symbol".
+#
+# The phases are:
+# load: reading the symbols, including building the index.
+# lookup-symbol: looking up global variables, i.e. lookup_symbol.  The
+#   variables looked up are non-const, since the const ones have
+#   internal linkage and are not found by lookup_global_symbol.
+# info-types: "info types" with a regexp matching one type.
+# break-overloaded: setting a breakpoint on a name with one overload
+#   per compunit.
+# block-for-pc: finding the block of function addresses,
+#   i.e. find_pc_compunit_symtab.
+
+import gdb
+from perftest import perftest
+from perftest import measure
+from perftest import utils
+
+# The maximum number of compunits whose symbols are looked up in the
+# lookup-symbol and block-for-pc phases.
+MAX_SAMPLES = 1000
+
+
+class SymbolScaling(perftest.TestCaseWithPeakRss):
+    def __init__(self, name, run_names, binfile):
+        super(SymbolScaling, self).__init__(name)
+        self.run_names = run_names
+        self.binfile = binfile
+
+    def warm_up(self):
+        pass
+
+    def _measure_phase(self, run, phase, func, iterations=3):
+        for _ in range(iterations):
+            self.measure.measure(func, "%s:%s" % (run, phase))
+
+    def _sample_compunits(self, run):
+        # The gmonster3 run names start with the number of compunits.
+        nr_compunits = int(run.split("-")[0])
+        step = max(1, nr_compunits // MAX_SAMPLES)
+        return range(0, nr_compunits, step)
+
+    def _load(self, binfile):
+        utils.select_file(binfile)
+        gdb.lookup_global_symbol("main")
+
+    def _global_name(self, cu):
+        return "global_%d_1" % cu
+
+    def _lookup_symbols(self, compunits):
+        for cu in compunits:
+            gdb.lookup_global_symbol(self._global_name(cu))
+
+    def _blocks_for_pcs(self, pcs):
+        progspace = gdb.current_progspace()
+        for pc in pcs:
+            progspace.block_for_pc(pc)
+
+    def _break_overloaded(self):
+        utils.safe_execute("break overloaded_function_0")
+        utils.safe_execute("delete")
+
+    def execute_test(self):
+        for run in self.run_names:
+            this_run_binfile = "%s-%s" % (self.binfile, utils.convert_spaces(run))
+            compunits = self._sample_compunits(run)
+
+            self._measure_phase(run, "load", lambda: self._load(this_run_binfile))
+
+            # Make sure that the lookup-symbol phase measures successful
+            # lookups.
+            name = self._global_name(compunits[0])
+            if gdb.lookup_global_symbol(name) is None:
+                raise gdb.GdbError("global symbol %s not found" % name)
+
+            def lookup():
+                utils.safe_execute("mt flush symbol-cache")
+                self._lookup_symbols(compunits)
+
+            self._measure_phase(run, "lookup-symbol", lookup)
+
+            self._measure_phase(
+                run,
+                "info-types",
+                lambda: utils.safe_execute("info types ^cu_0_overload_tag$"),
+            )
+
+            self._measure_phase(run, "break-overloaded", self._break_overloaded)
+
+            # Expand the sampled compunits first, so that only the lookup
+            # of the compunits is measured.
+            pcs = []
+            for cu in compunits:
+                sym = gdb.lookup_global_symbol("function_%d_0" % cu)
+                if sym is not None:
+                    pcs.append(int(sym.value().address))
+            self._blocks_for_pcs(pcs)
+            self._measure_phase(run, "block-for-pc", lambda: self._blocks_for_pcs(pcs))
@@ -22,6 +22,7 @@ from perftest.measure import MeasurementPerfCounter
 from perftest.measure import MeasurementProcessTime
 from perftest.measure import MeasurementWallTime
 from perftest.measure import MeasurementVmSize
+from perftest.measure import MeasurementPeakRss
 
 
 class TestCase(object):
@@ -65,6 +66,7 @@ class TestCase(object):
 
         self.execute_test()
         self.measure.report(reporter.TextReporter(append), self.name)
+        self.measure.report(reporter.JsonReporter(append), self.name)
 
 
 class TestCaseWithBasicMeasurements(TestCase):
@@ -79,3 +81,14 @@ class TestCaseWithBasicMeasurements(TestCase):
             MeasurementVmSize(result_factory.create_result()),
         ]
         super(TestCaseWithBasicMeasurements, self).__init__(name, Measure(measurements))
+
+
+class TestCaseWithPeakRss(TestCaseWithBasicMeasurements):
+    """Test case measuring CPU time, wall time, memory usage and peak RSS."""
+
+    def __init__(self, name):
+        super(TestCaseWithPeakRss, self).__init__(name)
+        result_factory = testresult.SingleStatisticResultFactory()
+        self.measure.measurements.append(
+            MeasurementPeakRss(result_factory.create_result())
+        )
@@ -13,6 +13,8 @@
 # You should have received a copy of the GNU General Public License
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+import json
+
 # Text reports are written here.
 # This is the perftest counterpart to gdb.sum.
 SUM_FILE_NAME = "perftest.sum"
@@ -21,6 +23,10 @@ SUM_FILE_NAME = "perftest.sum"
 # This is the perftest counterpart to gdb.log.
 LOG_FILE_NAME = "perftest.log"
 
+# Machine-readable reports are written here, one JSON object per line,
+# for tracking results across GDB versions.
+JSON_FILE_NAME = "perftest.json"
+
 
 class Reporter(object):
     """Base class of reporter to report test results in a certain format.
@@ -84,3 +90,38 @@ class TextReporter(Reporter):
     def end(self):
         self.txt_sum.close()
         self.txt_log.close()
+
+
+class JsonReporter(Reporter):
+    """Report results in a JSON lines file 'perftest.json'."""
+
+    def __init__(self, append):
+        super(JsonReporter, self).__init__(append)
+        self.json_file = None
+
+    def report(self, test_name, measurement_name, data_points):
+        # TEST_NAME is the name of the test followed by the name of the
+        # measurement, and MEASUREMENT_NAME is the parameter of the
+        # data points, e.g. the run name.
+        test, _, measurement = test_name.rpartition(" ")
+        record = {
+            "test": test,
+            "measurement": measurement,
+            "parameter": measurement_name,
+            "data": data_points,
+        }
+        if len(data_points) > 0:
+            record["average"] = sum(data_points) / len(data_points)
+            record["min"] = min(data_points)
+            record["max"] = max(data_points)
+        self.json_file.write(json.dumps(record, sort_keys=True) + "\n")
+
+    def start(self):
+        # Each measurement starts the report again, so only the first
+        # one may truncate the file.
+        mode = "a+" if self.append else "w"
+        self.json_file = open(JSON_FILE_NAME, mode)
+        self.append = True
+
+    def end(self):
+        self.json_file.close()
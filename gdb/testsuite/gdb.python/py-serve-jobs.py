@@ -0,0 +1,83 @@
+# Copyright (C) 2023 Free Software Foundation, Inc.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# This file is part of the GDB testsuite.  It connects to the socket
+# of "serve-jobs" from a thread, while the main thread of GDB serves
+# the jobs.
+
+import socket
+import threading
+import time
+
+import gdb
+
+# The output of each job, by name.
+results = {}
+
+
+def send_job(path, commands):
+    """Connect to the socket at PATH, send COMMANDS and shut down."""
+    for _ in range(100):
+        try:
+            sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            sock.connect(path)
+            break
+        except OSError:
+            sock.close()
+            time.sleep(0.1)
+    else:
+        raise RuntimeError("can't connect to " + path)
+    sock.sendall(("\n".join(commands) + "\n").encode())
+    sock.shutdown(socket.SHUT_WR)
+    return sock
+
+
+def read_job(sock):
+    """Return all the output of the job of SOCK."""
+    output = b""
+    while True:
+        data = sock.recv(4096)
+        if not data:
+            break
+        output += data
+    sock.close()
+    return output.decode()
+
+
+def run_clients(path, binfile):
+    try:
+        # The commands of the second job, and the end of the input of
+        # both, arrive while the first job runs the program.
+        first = send_job(
+            path, ["file " + binfile, "break marker", "run", "print counter"]
+        )
+        second = send_job(path, ["file " + binfile, "print counter"])
+        results["first"] = read_job(first)
+        results["second"] = read_job(second)
+
+        # The program's BFD is kept open after the jobs that loaded it
+        # are gone, and reused by the next job that loads it.
+        results["before"] = read_job(send_job(path, ["maint info bfds"]))
+        results["after"] = read_job(
+            send_job(path, ["file " + binfile, "maint info bfds"])
+        )
+    except Exception as e:
+        results["error"] = str(e)
+    gdb.post_event(lambda: print("serve-jobs clients done"))
+
+
+def start_clients(path, binfile):
+    """Run the jobs on the socket at PATH from a new thread."""
+    threading.Thread(target=run_clients, args=(path, binfile), daemon=True).start()
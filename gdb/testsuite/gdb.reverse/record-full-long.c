@@ -0,0 +1,36 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2023 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#define NR_ITERATIONS 5000
+
+volatile unsigned int buf[64];
+volatile unsigned int sum;
+
+int
+main (void)
+{
+  unsigned int i;
+
+  sum = 1;	/* begin marker */
+  for (i = 0; i < NR_ITERATIONS; i++)
+    {
+      buf[i % 64] += sum;
+      sum = sum * 31 + i;
+    }
+
+  return 0;	/* end marker */
+}
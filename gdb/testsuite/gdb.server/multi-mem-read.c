@@ -0,0 +1,32 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2023 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+int
+main (int argc, char **argv)
+{
+  /* Large enough to span several lines of the stack cache.  */
+  unsigned char buf[1024];
+  int i;
+
+  /* Include the characters that are escaped in binary packets.  Each
+     argument shifts the pattern by one, so that processes started
+     with different arguments have different contents.  */
+  for (i = 0; i < sizeof (buf); i++)
+    buf[i] = "$#}*ab"[(i + argc - 1) % 6];
+
+  return buf[0];  /* break here */
+}
@@ -0,0 +1,44 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2023 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* The contents of BUF include the characters that must be escaped in
+   the remote protocol, and 'z', which starts compressed replies.  */
+
+static const unsigned char pattern[] = { 0x24, 0x23, 0x7d, 0x2a, 0x7a, 0x61 };
+
+/* Large enough for the reply to a request reading it to be
+   compressed.  */
+
+unsigned char buf[2048];
+
+void
+marker (void)
+{
+}
+
+int
+main (void)
+{
+  int i;
+
+  for (i = 0; i < sizeof (buf); i++)
+    buf[i] = pattern[i % sizeof (pattern)];
+
+  marker ();
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2023 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <pthread.h>
+
+/* More threads than "thread apply all" handles in one batch.  */
+#define NUM_THREADS 300
+
+static pthread_barrier_t threads_started;
+static pthread_barrier_t threads_done;
+
+static void
+worker_leaf (long id)
+{
+  volatile long local = id;
+
+  pthread_barrier_wait (&threads_started);
+  pthread_barrier_wait (&threads_done);
+}
+
+static void
+worker_middle (long id, int depth)
+{
+  volatile char buf[1000];
+
+  buf[0] = depth;
+  if (depth == 0)
+    worker_leaf (id);
+  else
+    worker_middle (id, depth - 1);
+}
+
+static void *
+worker (void *arg)
+{
+  worker_middle ((long) arg, 5);
+  return NULL;
+}
+
+static void
+all_started (void)
+{
+}
+
+int
+main (void)
+{
+  pthread_t threads[NUM_THREADS];
+  long i;
+
+  pthread_barrier_init (&threads_started, NULL, NUM_THREADS + 1);
+  pthread_barrier_init (&threads_done, NULL, NUM_THREADS + 1);
+
+  for (i = 0; i < NUM_THREADS; i++)
+    pthread_create (&threads[i], NULL, worker, (void *) i);
+
+  pthread_barrier_wait (&threads_started);
+  all_started ();
+  pthread_barrier_wait (&threads_done);
+
+  for (i = 0; i < NUM_THREADS; i++)
+    pthread_join (threads[i], NULL);
+
+  return 0;
+}
@@ -50,6 +50,7 @@
 #include "inline-frame.h"
 #include "stack.h"
 #include "interps.h"
+#include "target-dcache.h"
 
 /* See gdbthread.h.  */
 
@@ -1593,6 +1594,11 @@ make_thread_apply_options_def_group (qcs_flags *flags)
   return {{thr_qcs_flags_option_defs}, flags};
 }
 
+/* The number of threads whose registers and stack "thread apply all"
+   reads at once.  This bounds the memory used by the stack snapshots.  */
+
+static const size_t thread_apply_all_batch_size = 256;
+
 /* Apply a GDB command to a list of threads.  List syntax is a whitespace
    separated list of numbers, or ranges, or the keyword `all'.  Ranges consist
    of two numbers separated by a hyphen.  Examples:
@@ -1641,9 +1647,43 @@ thread_apply_all_command (const char *cmd, int from_tty)
 
       scoped_restore_current_thread restore_thread;
 
-      for (thread_info_ref &thr : thr_list_cpy)
-	if (switch_to_thread_if_alive (thr.get ()))
-	  thread_try_catch_cmd (thr.get (), {}, cmd, from_tty, flags);
+      for (size_t first = 0; first < thr_list_cpy.size ();
+	   first += thread_apply_all_batch_size)
+	{
+	  size_t last = std::min (first + thread_apply_all_batch_size,
+				  thr_list_cpy.size ());
+
+	  /* The command is likely to need the registers and the stack of
+	     each thread, e.g. to unwind it, so give the targets a chance
+	     to read them for a whole batch of threads at once.  */
+	  std::vector<thread_info *> stopped_threads;
+	  for (size_t i = first; i < last; ++i)
+	    if (!thr_list_cpy[i]->executing ())
+	      stopped_threads.push_back (thr_list_cpy[i].get ());
+	  target_prefetch_registers (stopped_threads);
+	  std::vector<stack_snapshot> snapshots
+	    = target_dcache_read_stack_snapshots (stopped_threads);
+
+	  auto snapshot = snapshots.begin ();
+	  for (size_t i = first; i < last; ++i)
+	    {
+	      thread_info *tp = thr_list_cpy[i].get ();
+
+	      /* The snapshots are in thread order, but not every thread
+		 has one.  Consume the snapshot of TP even if TP is gone,
+		 so that it isn't compared with the next threads.  */
+	      const stack_snapshot *tp_snapshot = nullptr;
+	      if (snapshot != snapshots.end () && snapshot->thread == tp)
+		tp_snapshot = &*snapshot++;
+
+	      if (!switch_to_thread_if_alive (tp))
+		continue;
+
+	      if (tp_snapshot != nullptr)
+		target_dcache_install_stack_snapshot (*tp_snapshot);
+	      thread_try_catch_cmd (tp, {}, cmd, from_tty, flags);
+	    }
+	}
     }
 }
 
@@ -29,7 +29,9 @@
 #include "gdbsupport/netstuff.h"
 #include "gdbsupport/filestuff.h"
 #include "gdbsupport/gdb-sigmask.h"
+#include "gdbsupport/byte-vector.h"
 #include <ctype.h>
+#include <zlib.h>
 #if HAVE_SYS_IOCTL_H
 #include <sys/ioctl.h>
 #endif
@@ -621,6 +623,40 @@ read_prim (void *buf, int count)
     return read (remote_desc, buf, count);
 }
 
+/* When GDB requested it with the QCompression packet, the replies at
+   least this long are compressed.  Shorter ones wouldn't get much
+   shorter.  */
+static const int compression_threshold = 256;
+
+/* Compress the packet data in BUF, CNT bytes long, into OUT, as a
+   "z"<length>":"<data> reply where LENGTH is CNT in hex and DATA is
+   the data compressed with zlib, escaped as binary data.  Return
+   false if this failed.  */
+
+static bool
+compress_reply (const char *buf, int cnt, std::string &out)
+{
+  uLongf compressed_len = compressBound (cnt);
+  gdb::byte_vector compressed (compressed_len);
+  if (compress2 (compressed.data (), &compressed_len,
+		 (const Bytef *) buf, cnt, Z_BEST_SPEED) != Z_OK)
+    return false;
+
+  char header[sizeof ("z:") + 2 * sizeof (int)];
+  int header_len = xsnprintf (header, sizeof (header), "z%x:", cnt);
+
+  /* Each escaped byte takes two.  */
+  out.resize (header_len + 2 * compressed_len);
+  memcpy (&out[0], header, header_len);
+  int out_len;
+  int escaped_len
+    = remote_escape_output (compressed.data (), compressed_len, 1,
+			    (gdb_byte *) &out[header_len], &out_len,
+			    2 * compressed_len);
+  out.resize (header_len + escaped_len);
+  return true;
+}
+
 /* Send a packet to the remote machine, with error checking.
    The data of the packet is in BUF, and the length of the
    packet is in CNT.  Returns >= 0 on success, -1 otherwise.  */
@@ -635,6 +671,32 @@ putpkt_binary_1 (char *buf, int cnt, int is_notif)
   char *p;
   int cc;
 
+  /* Compress the long replies, and the ones that start with 'z' so
+     that GDB doesn't take them for compressed replies.  Keep the
+     original reply if compressing didn't make it shorter, framing it
+     as "z:"<reply> if it starts with 'z'.  */
+  std::string compressed;
+  if (!is_notif
+      && cs.compress_replies
+      && cnt > 0
+      && (cnt >= compression_threshold || buf[0] == 'z'))
+    {
+      int uncompressed_len = buf[0] == 'z' ? cnt + 2 : cnt;
+      if (!compress_reply (buf, cnt, compressed)
+	  || (int) compressed.size () >= uncompressed_len)
+	{
+	  compressed.clear ();
+	  if (buf[0] == 'z')
+	    compressed = "z:" + std::string (buf, cnt);
+	}
+
+      if (!compressed.empty ())
+	{
+	  buf = &compressed[0];
+	  cnt = compressed.size ();
+	}
+    }
+
   buf2 = (char *) xmalloc (strlen ("$") + cnt + strlen ("#nn") + 1);
 
   /* Copy the packet into buffer BUF2, encapsulating it
@@ -783,6 +783,22 @@ handle_general_set (char *own_buf)
       return;
     }
 
+  if (startswith (own_buf, "QCompression:"))
+    {
+      const char *algorithm = own_buf + strlen ("QCompression:");
+
+      if (strcmp (algorithm, "zlib") == 0)
+	{
+	  remote_debug_printf ("[zlib compression enabled]");
+
+	  cs.compress_replies = true;
+	  write_ok (own_buf);
+	}
+      else
+	write_enn (own_buf);
+      return;
+    }
+
   if (startswith (own_buf, "QNonStop:"))
     {
       char *mode = own_buf + 9;
@@ -2409,6 +2425,10 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
       if (cs.transport_is_reliable)
 	strcat (own_buf, ";QStartNoAckMode+");
 
+      /* The compression algorithms the replies may be compressed
+	 with.  */
+      strcat (own_buf, ";QCompression=zlib");
+
       if (the_target->supports_qxfer_osdata ())
 	strcat (own_buf, ";qXfer:osdata:read+");
 
@@ -2477,6 +2497,13 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
 
       strcat (own_buf, ";no-resumed+");
 
+      strcat (own_buf, ";vMultiMemRead+");
+
+      /* Packets are read from a buffered stream and handled in turn,
+	 so GDB may send a request before the reply to the previous
+	 one arrives.  */
+      strcat (own_buf, ";pipelined-requests+");
+
       if (target_supports_memory_tagging ())
 	strcat (own_buf, ";memory-tagging+");
 
@@ -3101,6 +3128,90 @@ handle_v_kill (char *own_buf)
     write_enn (own_buf);
 }
 
+/* Handle a vMultiMemRead packet.  Read each of the ADDR,LENGTH ranges
+   it lists, and reply with the number of bytes read from each range,
+   followed by all the bytes read, escaped.  */
+
+static void
+handle_v_multi_mem_read (char *own_buf, int *new_packet_len)
+{
+  std::vector<std::pair<CORE_ADDR, ULONGEST>> ranges;
+  ULONGEST total = 0;
+
+  const char *p = own_buf + strlen ("vMultiMemRead:");
+  while (*p != '\0')
+    {
+      ULONGEST addr, len;
+
+      p = unpack_varlen_hex (p, &addr);
+      if (*p != ',')
+	{
+	  write_enn (own_buf);
+	  return;
+	}
+      p = unpack_varlen_hex (p + 1, &len);
+      if (*p == ';')
+	++p;
+      else if (*p != '\0')
+	{
+	  write_enn (own_buf);
+	  return;
+	}
+
+      ranges.emplace_back (addr, len);
+      total += len;
+    }
+
+  /* Each length in the reply takes at most this many characters,
+     including its separator.  */
+  const int max_len_chars = 2 * sizeof (ULONGEST) + 1;
+  if (ranges.empty ()
+      || total > PBUFSIZ
+      || ranges.size () * max_len_chars >= PBUFSIZ)
+    {
+      write_enn (own_buf);
+      return;
+    }
+
+  gdb::byte_vector data (total);
+  std::vector<ULONGEST> xfered (ranges.size ());
+  ULONGEST offset = 0;
+  for (size_t i = 0; i < ranges.size (); ++i)
+    {
+      int res = gdb_read_memory (ranges[i].first, data.data () + offset,
+				 ranges[i].second);
+      xfered[i] = res < 0 ? 0 : res;
+      offset += ranges[i].second;
+    }
+
+  /* Escape the data first, as it may not all fit in the reply, in
+     which case the lengths must say how much of it was sent.  */
+  int room = PBUFSIZ - ranges.size () * max_len_chars;
+  gdb::byte_vector escaped (room);
+  int escaped_len = 0;
+  offset = 0;
+  for (size_t i = 0; i < ranges.size (); ++i)
+    {
+      int out_len;
+
+      escaped_len += remote_escape_output (data.data () + offset, xfered[i], 1,
+					   escaped.data () + escaped_len, &out_len,
+					   room - escaped_len);
+      xfered[i] = out_len;
+      offset += ranges[i].second;
+    }
+
+  char *out = own_buf;
+  for (size_t i = 0; i < ranges.size (); ++i)
+    {
+      strcpy (out, phex_nz (xfered[i], sizeof (ULONGEST)));
+      out += strlen (out);
+      *out++ = i + 1 < ranges.size () ? ',' : ';';
+    }
+  memcpy (out, escaped.data (), escaped_len);
+  *new_packet_len = out - own_buf + escaped_len;
+}
+
 /* Handle all of the extended 'v' packets.  */
 void
 handle_v_requests (char *own_buf, int packet_len, int *new_packet_len)
@@ -3187,6 +3298,13 @@ handle_v_requests (char *own_buf, int packet_len, int *new_packet_len)
       return;
     }
 
+  if (startswith (own_buf, "vMultiMemRead:"))
+    {
+      require_running_or_return (own_buf);
+      handle_v_multi_mem_read (own_buf, new_packet_len);
+      return;
+    }
+
   if (handle_notif_ack (own_buf, packet_len))
     return;
 
@@ -3955,6 +4073,7 @@ captured_main (int argc, char *argv[])
   while (1)
     {
       cs.noack_mode = 0;
+      cs.compress_replies = false;
       cs.multi_process = 0;
       cs.report_fork_events = 0;
       cs.report_vfork_events = 0;
@@ -181,6 +181,9 @@ struct client_state
 
   /* If true, then GDB has requested noack mode.  */
   int noack_mode = 0;
+  /* If true, then GDB has requested that the replies be compressed
+     with zlib, see the QCompression packet.  */
+  bool compress_replies = false;
   /* If true, then we tell GDB to use noack mode by default.  */
   int transport_is_reliable = 0;
 